@@ -142,6 +142,8 @@ static int want_sdp = 1;
 static BenchmarkTimeStamps current_time;
 AVIOContext *progress_avio = NULL;
 
+static AVBufferRef *buffer_pool;
+
 static uint8_t *subtitle_out;
 
 InputStream **input_streams = NULL;
@@ -166,6 +168,8 @@ static int restore_tty;
 
 #if HAVE_THREADS
 static void free_input_threads(void);
+static void free_encoder_thread(OutputStream *ost);
+static void free_encoder_jobs(void);
 #endif
 
 /* sub2video hack:
@@ -480,6 +484,36 @@ static int decode_interrupt_cb(void *ctx)
 
 const AVIOInterruptCB int_cb = { decode_interrupt_cb, NULL };
 
+int ref_shared_buffer_pool(AVBufferRef **dst)
+{
+    if (!shared_buffer_pool && !buffer_pool_max_size)
+        return 0;
+
+    if (!buffer_pool) {
+        buffer_pool = av_buffer_shared_pool_alloc(buffer_pool_max_size);
+        if (!buffer_pool)
+            return AVERROR(ENOMEM);
+    }
+
+    av_buffer_unref(dst);
+    *dst = av_buffer_ref(buffer_pool);
+    return *dst ? 0 : AVERROR(ENOMEM);
+}
+
+static void free_shared_buffer_pool(void)
+{
+    AVBufferPoolStats stats;
+
+    if (!buffer_pool)
+        return;
+
+    av_buffer_shared_pool_get_stats(buffer_pool, &stats);
+    av_log(NULL, AV_LOG_VERBOSE, "Shared buffer pool: %"PRIu64" hits, "
+           "%"PRIu64" misses, %"PRIu64" failures, peak %"PRId64" bytes\n",
+           stats.hits, stats.misses, stats.failures, stats.peak_bytes);
+    av_buffer_unref(&buffer_pool);
+}
+
 static void ffmpeg_cleanup(int ret)
 {
     int i, j;
@@ -568,6 +602,9 @@ static void ffmpeg_cleanup(int ret)
 
         av_dict_free(&ost->sws_dict);
 
+#if HAVE_THREADS
+        free_encoder_thread(ost);
+#endif
         avcodec_free_context(&ost->enc_ctx);
         avcodec_parameters_free(&ost->ref_par);
 
@@ -584,6 +621,7 @@ static void ffmpeg_cleanup(int ret)
     }
 #if HAVE_THREADS
     free_input_threads();
+    free_encoder_jobs();
 #endif
     for (i = 0; i < nb_input_files; i++) {
         avformat_close_input(&input_files[i]->ctx);
@@ -613,12 +651,15 @@ static void ffmpeg_cleanup(int ret)
                    av_err2str(AVERROR(errno)));
     }
     av_freep(&vstats_filename);
+    av_freep(&filter_scheduler);
 
     av_freep(&input_streams);
     av_freep(&input_files);
     av_freep(&output_streams);
     av_freep(&output_files);
 
+    free_shared_buffer_pool();
+
     uninit_opts();
 
     avformat_network_deinit();
@@ -907,6 +948,267 @@ static int check_recording_time(OutputStream *ost)
     return 1;
 }
 
+#if HAVE_THREADS
+#define ENC_THREAD_QUEUE_SIZE 8
+
+typedef struct EncodedPacket {
+    AVPacket pkt;
+    char *stats_out;    /* copy of AVCodecContext.stats_out after this packet */
+    int frame_done;     /* no packet, marks the end of the output for one frame */
+    int ret;            /* encoding status of the frame, with frame_done */
+} EncodedPacket;
+
+/*
+ * Everything that is muxed while encoder threads are running goes through
+ * enc_job_fifo, in the order the serial code path would mux it: the frames
+ * sent to an encoder thread, whose packets are muxed once it returns them,
+ * and the packets of copied streams, which are muxed as they are.
+ */
+typedef struct EncoderJob {
+    OutputStream *ost;
+    int frame;          /* a frame sent to the encoder thread of ost */
+    AVPacket pkt;       /* otherwise, a copied packet */
+} EncoderJob;
+
+static AVFifoBuffer *enc_job_fifo;
+
+static void queue_encoder_job(EncoderJob *job)
+{
+    if (av_fifo_grow(enc_job_fifo, sizeof(*job)) < 0)
+        exit_program(1);
+    av_fifo_generic_write(enc_job_fifo, job, sizeof(*job), NULL);
+}
+
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    AVCodecContext *enc = ost->enc_ctx;
+    AVFrame *frame;
+    int ret;
+
+    while (av_thread_message_queue_recv(ost->enc_frame_queue, &frame, 0) >= 0) {
+        EncodedPacket ep = { { 0 } };
+
+        ret = avcodec_send_frame(enc, frame);
+        while (ret >= 0) {
+            av_init_packet(&ep.pkt);
+            ep.pkt.data = NULL;
+            ep.pkt.size = 0;
+
+            ret = avcodec_receive_packet(enc, &ep.pkt);
+            if (ret == AVERROR(EAGAIN)) {
+                ret = 0;
+                break;
+            }
+            if (ret < 0)
+                break;
+
+            if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
+                if (ep.pkt.pts == AV_NOPTS_VALUE && !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
+                    ep.pkt.pts = frame->pts;
+                if (enc->stats_out && !(ep.stats_out = av_strdup(enc->stats_out))) {
+                    av_packet_unref(&ep.pkt);
+                    ret = AVERROR(ENOMEM);
+                    break;
+                }
+            }
+
+            if (av_thread_message_queue_send(ost->enc_pkt_queue, &ep, 0) < 0) {
+                av_packet_unref(&ep.pkt);
+                av_freep(&ep.stats_out);
+                av_frame_free(&frame);
+                return NULL;
+            }
+            ep.stats_out = NULL;
+        }
+        av_frame_free(&frame);
+
+        memset(&ep, 0, sizeof(ep));
+        ep.frame_done = 1;
+        ep.ret        = ret;
+        if (av_thread_message_queue_send(ost->enc_pkt_queue, &ep, 0) < 0)
+            break;
+    }
+
+    return NULL;
+}
+
+/*
+ * Mux the oldest job: a copied packet, or the packets of a frame sent to an
+ * encoder thread.
+ *
+ * @return 1 if the job is done, 0 if nonblock is set and the encoder has not
+ *         finished the frame yet
+ */
+static int reap_encoder_job(int nonblock)
+{
+    EncoderJob job;
+    OutputStream *ost;
+    OutputFile *of;
+    AVCodecContext *enc;
+
+    av_fifo_generic_peek(enc_job_fifo, &job, sizeof(job), NULL);
+    ost = job.ost;
+    of  = output_files[ost->file_index];
+    enc = ost->enc_ctx;
+
+    if (!job.frame) {
+        av_fifo_drain(enc_job_fifo, sizeof(job));
+        output_packet(of, &job.pkt, ost, 0);
+        return 1;
+    }
+
+    while (1) {
+        EncodedPacket ep;
+        int ret = av_thread_message_queue_recv(ost->enc_pkt_queue, &ep,
+                                               nonblock ? AV_THREAD_MESSAGE_NONBLOCK : 0);
+        if (ret == AVERROR(EAGAIN))
+            return 0;
+        if (ret < 0) {
+            av_log(NULL, AV_LOG_FATAL, "Error receiving packets from the encoder "
+                   "thread of output stream #%d:%d: %s\n",
+                   ost->file_index, ost->index, av_err2str(ret));
+            exit_program(1);
+        }
+
+        if (ep.frame_done) {
+            av_fifo_drain(enc_job_fifo, sizeof(job));
+            ost->enc_jobs_pending--;
+            if (ep.ret < 0) {
+                av_log(NULL, AV_LOG_FATAL, "%s encoding failed\n",
+                       enc->codec_type == AVMEDIA_TYPE_VIDEO ? "Video" : "Audio");
+                exit_program(1);
+            }
+            if (enc->codec_type == AVMEDIA_TYPE_VIDEO && vstats_filename && ost->enc_frame_size)
+                do_video_stats(ost, ost->enc_frame_size);
+            ost->enc_frame_size = 0;
+            return 1;
+        }
+
+        if (debug_ts) {
+            av_log(NULL, AV_LOG_INFO, "encoder -> type:%s "
+                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
+                   av_get_media_type_string(enc->codec_type),
+                   av_ts2str(ep.pkt.pts), av_ts2timestr(ep.pkt.pts, &enc->time_base),
+                   av_ts2str(ep.pkt.dts), av_ts2timestr(ep.pkt.dts, &enc->time_base));
+        }
+
+        av_packet_rescale_ts(&ep.pkt, enc->time_base, ost->mux_timebase);
+
+        ost->enc_frame_size = ep.pkt.size;
+        output_packet(of, &ep.pkt, ost, 0);
+
+        /* if two pass, output log */
+        if (ost->logfile && ep.stats_out)
+            fprintf(ost->logfile, "%s", ep.stats_out);
+        av_freep(&ep.stats_out);
+    }
+}
+
+/*
+ * Mux the jobs that are done, in order. With nonblock unset, wait until all
+ * of them are.
+ */
+static void reap_encoder_threads(int nonblock)
+{
+    while (enc_job_fifo && av_fifo_size(enc_job_fifo) && reap_encoder_job(nonblock))
+        ;
+}
+
+static void send_frame_to_encoder_thread(OutputStream *ost, AVFrame *frame)
+{
+    EncoderJob enc_job = { ost, 1 };
+    AVFrame *job;
+    int ret;
+
+    /* make sure the send below cannot block on a thread waiting for us */
+    while (ost->enc_jobs_pending >= ENC_THREAD_QUEUE_SIZE)
+        reap_encoder_job(0);
+
+    job = av_frame_clone(frame);
+    if (!job)
+        exit_program(1);
+
+    ret = av_thread_message_queue_send(ost->enc_frame_queue, &job, 0);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Error sending a frame to the encoder "
+               "thread of output stream #%d:%d: %s\n",
+               ost->file_index, ost->index, av_err2str(ret));
+        av_frame_free(&job);
+        exit_program(1);
+    }
+    queue_encoder_job(&enc_job);
+    ost->enc_jobs_pending++;
+}
+
+static int init_encoder_thread(OutputStream *ost)
+{
+    int ret;
+
+    if (!enc_job_fifo &&
+        !(enc_job_fifo = av_fifo_alloc_array(nb_output_streams * ENC_THREAD_QUEUE_SIZE,
+                                             sizeof(EncoderJob))))
+        return AVERROR(ENOMEM);
+
+    ret = av_thread_message_queue_alloc(&ost->enc_frame_queue,
+                                        ENC_THREAD_QUEUE_SIZE, sizeof(AVFrame *));
+    if (ret < 0)
+        return ret;
+    ret = av_thread_message_queue_alloc(&ost->enc_pkt_queue,
+                                        ENC_THREAD_QUEUE_SIZE, sizeof(EncodedPacket));
+    if (ret < 0)
+        goto fail;
+
+    if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        ret = AVERROR(ret);
+        goto fail;
+    }
+
+    return 0;
+fail:
+    av_thread_message_queue_free(&ost->enc_pkt_queue);
+    av_thread_message_queue_free(&ost->enc_frame_queue);
+    return ret;
+}
+
+static void free_encoder_thread(OutputStream *ost)
+{
+    EncodedPacket ep;
+    AVFrame *frame;
+
+    if (!ost->enc_frame_queue)
+        return;
+
+    av_thread_message_queue_set_err_send(ost->enc_pkt_queue, AVERROR_EOF);
+    av_thread_message_queue_set_err_recv(ost->enc_frame_queue, AVERROR_EOF);
+    pthread_join(ost->enc_thread, NULL);
+
+    while (av_thread_message_queue_recv(ost->enc_frame_queue, &frame, 0) >= 0)
+        av_frame_free(&frame);
+    while (av_thread_message_queue_recv(ost->enc_pkt_queue, &ep,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0) {
+        av_packet_unref(&ep.pkt);
+        av_freep(&ep.stats_out);
+    }
+
+    av_thread_message_queue_free(&ost->enc_frame_queue);
+    av_thread_message_queue_free(&ost->enc_pkt_queue);
+    ost->enc_jobs_pending = 0;
+}
+
+static void free_encoder_jobs(void)
+{
+    EncoderJob job;
+
+    while (enc_job_fifo && av_fifo_size(enc_job_fifo)) {
+        av_fifo_generic_read(enc_job_fifo, &job, sizeof(job), NULL);
+        av_packet_unref(&job.pkt);
+    }
+    av_fifo_freep(&enc_job_fifo);
+}
+#endif
+
 static void do_audio_out(OutputFile *of, OutputStream *ost,
                          AVFrame *frame)
 {
@@ -936,6 +1238,13 @@ static void do_audio_out(OutputFile *of, OutputStream *ost,
                enc->time_base.num, enc->time_base.den);
     }
 
+#if HAVE_THREADS
+    if (ost->enc_frame_queue) {
+        send_frame_to_encoder_thread(ost, frame);
+        return;
+    }
+#endif
+
     ret = avcodec_send_frame(enc, frame);
     if (ret < 0)
         goto error;
@@ -986,6 +1295,11 @@ static void do_subtitle_out(OutputFile *of,
 
     enc = ost->enc_ctx;
 
+#if HAVE_THREADS
+    /* keep the packet order of the serial code path */
+    reap_encoder_threads(0);
+#endif
+
     if (!subtitle_out) {
         subtitle_out = av_malloc(subtitle_out_max_size);
         if (!subtitle_out) {
@@ -1289,6 +1603,13 @@ static void do_video_out(OutputFile *of,
 
         ost->frames_encoded++;
 
+#if HAVE_THREADS
+        if (ost->enc_frame_queue) {
+            send_frame_to_encoder_thread(ost, in_picture);
+            goto next_frame;
+        }
+#endif
+
         ret = avcodec_send_frame(enc, in_picture);
         if (ret < 0)
             goto error;
@@ -1329,6 +1650,9 @@ static void do_video_out(OutputFile *of,
             }
         }
     }
+#if HAVE_THREADS
+next_frame:
+#endif
     ost->sync_opts++;
     /*
      * For video, number of frames in == number of packets out.
@@ -1443,6 +1767,12 @@ static int reap_filters(int flush)
 
         if (!ost->initialized) {
             char error[1024] = "";
+#if HAVE_THREADS
+            /* this may write the header and the queued packets, so everything
+             * encoded before must be queued first; this only happens until all
+             * output streams are initialized */
+            reap_encoder_threads(0);
+#endif
             ret = init_output_stream(ost, error, sizeof(error));
             if (ret < 0) {
                 av_log(NULL, AV_LOG_ERROR, "Error initializing output stream %d:%d -- %s\n",
@@ -1497,8 +1827,16 @@ static int reap_filters(int flush)
 
             switch (av_buffersink_get_type(filter)) {
             case AVMEDIA_TYPE_VIDEO:
-                if (!ost->frame_aspect_ratio.num)
+                if (!ost->frame_aspect_ratio.num &&
+                    av_cmp_q(enc->sample_aspect_ratio, filtered_frame->sample_aspect_ratio)) {
+#if HAVE_THREADS
+                    /* the encoder thread reads it, only change it while
+                     * the thread is idle */
+                    while (ost->enc_jobs_pending)
+                        reap_encoder_job(0);
+#endif
                     enc->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
+                }
 
                 if (debug_ts) {
                     av_log(NULL, AV_LOG_INFO, "filter -> pts:%s pts_time:%s exact:%f time_base:%d/%d\n",
@@ -1527,6 +1865,11 @@ static int reap_filters(int flush)
         }
     }
 
+#if HAVE_THREADS
+    /* mux what is ready, the rest is picked up by the next call */
+    reap_encoder_threads(1);
+#endif
+
     return 0;
 }
 
@@ -1861,6 +2204,11 @@ static void flush_encoders(void)
 {
     int i, ret;
 
+#if HAVE_THREADS
+    /* the encoders are flushed from this thread */
+    reap_encoder_threads(0);
+#endif
+
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream   *ost = output_streams[i];
         AVCodecContext *enc = ost->enc_ctx;
@@ -2003,6 +2351,13 @@ static void do_streamcopy(InputStream *ist, OutputStream *ost, const AVPacket *p
 
     av_init_packet(&opkt);
 
+#if HAVE_THREADS
+    /* keep the packet order of the serial code path; the checks below use
+     * the number of packets muxed, so wait for the first one to be */
+    if (!pkt || !ost->frame_number)
+        reap_encoder_threads(0);
+#endif
+
     // EOF: flush output bitstream filters.
     if (!pkt) {
         output_packet(of, &opkt, ost, 1);
@@ -2077,6 +2432,17 @@ static void do_streamcopy(InputStream *ist, OutputStream *ost, const AVPacket *p
 
     av_copy_packet_side_data(&opkt, pkt);
 
+#if HAVE_THREADS
+    if (enc_job_fifo && av_fifo_size(enc_job_fifo)) {
+        EncoderJob job = { ost };
+        if (av_packet_ref(&job.pkt, &opkt) < 0)
+            exit_program(1);
+        av_packet_unref(&opkt);
+        queue_encoder_job(&job);
+        return;
+    }
+#endif
+
     output_packet(of, &opkt, ost, 0);
 }
 
@@ -2936,6 +3302,13 @@ static int init_input_stream(int ist_index, char *error, int error_len)
             return ret;
         }
 
+        ret = ref_shared_buffer_pool(&ist->dec_ctx->shared_buffer_pool);
+        if (ret < 0) {
+            snprintf(error, error_len, "Error setting up the shared buffer pool "
+                     "for input stream #%d:%d", ist->file_index, ist->st->index);
+            return ret;
+        }
+
         if ((ret = avcodec_open2(ist->dec_ctx, codec, &ist->decoder_opts)) < 0) {
             if (ret == AVERROR_EXPERIMENTAL)
                 abort_codec_experimental(codec, 0);
@@ -3508,6 +3881,13 @@ static int init_output_stream(OutputStream *ost, char *error, int error_len)
             }
         }
 
+        ret = ref_shared_buffer_pool(&ost->enc_ctx->shared_buffer_pool);
+        if (ret < 0) {
+            snprintf(error, error_len, "Error setting up the shared buffer pool "
+                     "for output stream #%d:%d", ost->file_index, ost->index);
+            return ret;
+        }
+
         if ((ret = avcodec_open2(ost->enc_ctx, codec, &ost->encoder_opts)) < 0) {
             if (ret == AVERROR_EXPERIMENTAL)
                 abort_codec_experimental(codec, 1);
@@ -3522,6 +3902,16 @@ static int init_output_stream(OutputStream *ost, char *error, int error_len)
             av_buffersink_set_frame_size(ost->filter->filter,
                                             ost->enc_ctx->frame_size);
         assert_avoptions(ost->encoder_opts);
+#if HAVE_THREADS
+        if (parallel_encoders && ost->filter) {
+            ret = init_encoder_thread(ost);
+            if (ret < 0) {
+                snprintf(error, error_len, "Could not start the encoder thread "
+                         "for output stream #%d:%d", ost->file_index, ost->index);
+                return ret;
+            }
+        }
+#endif
         if (ost->enc_ctx->bit_rate && ost->enc_ctx->bit_rate < 1000 &&
             ost->enc_ctx->codec_id != AV_CODEC_ID_CODEC2 /* don't complain about 700 bit/s modes */)
             av_log(NULL, AV_LOG_WARNING, "The bitrate parameter is set too low."
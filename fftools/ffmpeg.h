@@ -549,6 +549,15 @@ typedef struct OutputStream {
 
     /* frame encode sum of squared error values */
     int64_t error[4];
+
+#if HAVE_THREADS
+    /* encoding on a separate thread, see -parallel_encoders */
+    AVThreadMessageQueue *enc_frame_queue; /* frames sent to the encoder thread */
+    AVThreadMessageQueue *enc_pkt_queue;   /* packets coming back from it */
+    pthread_t enc_thread;
+    int enc_jobs_pending;                  /* frames whose packets are not muxed yet */
+    int enc_frame_size;                    /* size of the last packet of the current job */
+#endif
 } OutputStream;
 
 typedef struct OutputFile {
@@ -609,6 +618,10 @@ extern char *videotoolbox_pixfmt;
 
 extern int filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern char *filter_scheduler;
+extern int parallel_encoders;
+extern int shared_buffer_pool;
+extern int64_t buffer_pool_max_size;
 extern int vstats_version;
 
 extern const AVIOInterruptCB int_cb;
@@ -635,6 +648,12 @@ void assert_avoptions(AVDictionary *m);
 
 int guess_input_channel_layout(InputStream *ist);
 
+/**
+ * Put a new reference to the process-wide shared buffer pool in *dst, creating
+ * the pool on first use. Does nothing if no shared pool was requested.
+ */
+int ref_shared_buffer_pool(AVBufferRef **dst);
+
 enum AVPixelFormat choose_pixel_fmt(AVStream *st, AVCodecContext *avctx, AVCodec *codec, enum AVPixelFormat target);
 void choose_sample_fmt(AVStream *st, AVCodec *codec);
 
@@ -1004,6 +1004,8 @@ int configure_filtergraph(FilterGraph *fg)
     cleanup_filtergraph(fg);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    if ((ret = ref_shared_buffer_pool(&fg->graph->shared_buffer_pool)) < 0)
+        return ret;
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
@@ -1045,6 +1047,10 @@ int configure_filtergraph(FilterGraph *fg)
         fg->graph->nb_threads = filter_complex_nbthreads;
     }
 
+    if (filter_scheduler &&
+        (ret = av_opt_set(fg->graph, "scheduler", filter_scheduler, 0)) < 0)
+        goto fail;
+
     if ((ret = avfilter_graph_parse2(fg->graph, graph_desc, &inputs, &outputs)) < 0)
         goto fail;
 
@@ -109,6 +109,10 @@ int frame_bits_per_raw_sample = 0;
 float max_error_rate  = 2.0/3;
 int filter_nbthreads = 0;
 int filter_complex_nbthreads = 0;
+char *filter_scheduler = NULL;
+int parallel_encoders = 0;
+int shared_buffer_pool = 0;
+int64_t buffer_pool_max_size = 0;
 int vstats_version = 2;
 
 
@@ -3457,6 +3461,14 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_threads", HAS_ARG | OPT_INT,                   { &filter_complex_nbthreads },
         "number of threads for -filter_complex" },
+    { "filter_scheduler", HAS_ARG | OPT_STRING | OPT_EXPERT,         { &filter_scheduler },
+        "filter activation scheduler (serial or parallel)", "scheduler" },
+    { "parallel_encoders", OPT_BOOL | OPT_EXPERT,                    { &parallel_encoders },
+        "run each encoder in its own thread" },
+    { "shared_buffer_pool", OPT_BOOL | OPT_EXPERT,                   { &shared_buffer_pool },
+        "allocate the frames of all decoders, filters and encoders from one buffer pool" },
+    { "buffer_pool_max_size", HAS_ARG | OPT_INT64 | OPT_EXPERT,      { &buffer_pool_max_size },
+        "maximum size in bytes of the shared buffer pool (implies -shared_buffer_pool)", "size" },
     { "lavfi",          HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_filter_complex },
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
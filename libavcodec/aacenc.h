@@ -370,6 +370,23 @@ static const AACPCEInfo aac_pce_configs[] = {
     },
 };
 
+/**
+ * Per channel element state, coded independently of the other elements
+ */
+typedef struct AACEncElement {
+    int tag;                                     ///< syntax element type
+    int id;                                      ///< element instance tag
+    int start_ch;                                ///< first channel of the element
+    FFPsyWindowInfo wi[2];                       ///< window decision for each channel
+    int bitres_alloc;                            ///< bits granted by the psy model, or -1
+    int random_state;                            ///< PNS noise generator state
+    int cutoff;                                  ///< psy cutoff as left by the coder
+    int ms_mode, is_mode, tns_mode, pred_mode;   ///< tools used by the element
+    uint8_t *buf;                                ///< element bitstream
+    int buf_size;
+    int bits;                                    ///< number of bits written to buf
+} AACEncElement;
+
 /**
  * AAC encoder context
  */
@@ -392,6 +409,9 @@ typedef struct AACEncContext {
     const uint8_t *chan_map;                     ///< channel configuration map
 
     ChannelElement *cpe;                         ///< channel elements
+    AACEncElement *elements;                     ///< coding state of the channel elements
+    struct AACEncContext **thread_ctx;           ///< per-thread coder contexts, the first one is the main context
+    int nb_thread_ctx;                           ///< number of entries in thread_ctx
     FFPsyContext psy;
     struct FFPsyPreprocessContext* psypp;
     const AACCoefficientsEncoder *coder;
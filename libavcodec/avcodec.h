@@ -3300,6 +3300,24 @@ typedef struct AVCodecContext {
      * used as reference pictures).
      */
     int extra_hw_frames;
+
+    /**
+     * A reference to a shared buffer pool allocated with
+     * av_buffer_shared_pool_alloc(). When set, the default get_buffer2()
+     * implementation takes the frame buffers of decoders from it, and
+     * encoders allocate their output packets from it, so that several
+     * codecs (and filter graphs) can draw from the same memory.
+     *
+     * The reference is owned by libavcodec and will be unreffed in
+     * avcodec_free_context(). It is kept by avcodec_close(), so a closed
+     * context can be opened again with the same pool. The pool itself lives
+     * until its last reference is gone, which includes the buffers handed
+     * out from it, so other contexts sharing it are not affected.
+     *
+     * - encoding: May be set by the user before calling avcodec_open2().
+     * - decoding: May be set by the user before calling avcodec_open2().
+     */
+    AVBufferRef *shared_buffer_pool;
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
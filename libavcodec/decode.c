@@ -1512,9 +1512,11 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
 
         for (i = 0; i < 4; i++) {
             av_buffer_pool_uninit(&pool->pools[i]);
-            pool->linesize[i] = linesize[i];
+            pool->linesize[i]  = linesize[i];
+            pool->pool_size[i] = 0;
             if (size[i]) {
-                pool->pools[i] = av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1,
+                pool->pool_size[i] = size[i] + 16 + STRIDE_ALIGN - 1;
+                pool->pools[i] = av_buffer_pool_init(pool->pool_size[i],
                                                      CONFIG_MEMORY_POISONING ?
                                                         NULL :
                                                         av_buffer_allocz);
@@ -1545,6 +1547,7 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
         if (ret < 0)
             goto fail;
 
+        pool->pool_size[0] = pool->linesize[0];
         pool->pools[0] = av_buffer_pool_init(pool->linesize[0], NULL);
         if (!pool->pools[0]) {
             ret = AVERROR(ENOMEM);
@@ -1569,6 +1572,16 @@ fail:
     return ret;
 }
 
+static AVBufferRef *frame_pool_get(AVCodecContext *avctx, int plane)
+{
+    FramePool *pool = avctx->internal->pool;
+
+    if (avctx->shared_buffer_pool)
+        return av_buffer_shared_pool_get(avctx->shared_buffer_pool,
+                                         pool->pool_size[plane]);
+    return av_buffer_pool_get(pool->pools[plane]);
+}
+
 static int audio_get_buffer(AVCodecContext *avctx, AVFrame *frame)
 {
     FramePool *pool = avctx->internal->pool;
@@ -1593,13 +1606,13 @@ static int audio_get_buffer(AVCodecContext *avctx, AVFrame *frame)
     }
 
     for (i = 0; i < FFMIN(planes, AV_NUM_DATA_POINTERS); i++) {
-        frame->buf[i] = av_buffer_pool_get(pool->pools[0]);
+        frame->buf[i] = frame_pool_get(avctx, 0);
         if (!frame->buf[i])
             goto fail;
         frame->extended_data[i] = frame->data[i] = frame->buf[i]->data;
     }
     for (i = 0; i < frame->nb_extended_buf; i++) {
-        frame->extended_buf[i] = av_buffer_pool_get(pool->pools[0]);
+        frame->extended_buf[i] = frame_pool_get(avctx, 0);
         if (!frame->extended_buf[i])
             goto fail;
         frame->extended_data[i + AV_NUM_DATA_POINTERS] = frame->extended_buf[i]->data;
@@ -1638,7 +1651,7 @@ static int video_get_buffer(AVCodecContext *s, AVFrame *pic)
     for (i = 0; i < 4 && pool->pools[i]; i++) {
         pic->linesize[i] = pool->linesize[i];
 
-        pic->buf[i] = av_buffer_pool_get(pool->pools[i]);
+        pic->buf[i] = frame_pool_get(s, i);
         if (!pic->buf[i])
             goto fail;
 
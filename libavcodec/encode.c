@@ -62,6 +62,20 @@ int ff_alloc_packet2(AVCodecContext *avctx, AVPacket *avpkt, int64_t size, int64
         avpkt->buf      = buf;
         avpkt->size     = size;
         return 0;
+    } else if (avctx && avctx->shared_buffer_pool) {
+        AVBufferRef *buf = av_buffer_shared_pool_get(avctx->shared_buffer_pool,
+                                                     size + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!buf) {
+            av_log(avctx, AV_LOG_ERROR, "Failed to allocate packet of size %"PRId64"\n", size);
+            return AVERROR(ENOMEM);
+        }
+        memset(buf->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+        av_init_packet(avpkt);
+        avpkt->buf  = buf;
+        avpkt->data = buf->data;
+        avpkt->size = size;
+        return 0;
     } else {
         int ret = av_new_packet(avpkt, size);
         if (ret < 0)
@@ -525,7 +525,7 @@ int ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts)
         if (s->ps.pps->tiles_enabled_flag &&
             s->ps.pps->tile_id[ctb_addr_ts] != s->ps.pps->tile_id[ctb_addr_ts - 1]) {
             int ret;
-            if (s->threads_number == 1)
+            if (!s->entry_points_parallel)
                 ret = cabac_reinit(s->HEVClc);
             else {
                 ret = cabac_init_decoder(s);
@@ -538,7 +538,7 @@ int ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts)
             if (ctb_addr_ts % s->ps.sps->ctb_width == 0) {
                 int ret;
                 get_cabac_terminate(&s->HEVClc->cc);
-                if (s->threads_number == 1)
+                if (!s->entry_points_parallel)
                     ret = cabac_reinit(s->HEVClc);
                 else {
                     ret = cabac_init_decoder(s);
@@ -75,6 +75,8 @@ static void pic_arrays_free(HEVCContext *s)
     av_freep(&s->horizontal_bs);
     av_freep(&s->vertical_bs);
 
+    av_freep(&s->filter_progress);
+
     av_freep(&s->sh.entry_point_offset);
     av_freep(&s->sh.size);
     av_freep(&s->sh.offset);
@@ -126,6 +128,10 @@ static int pic_arrays_init(HEVCContext *s, const HEVCSPS *sps)
     if (!s->horizontal_bs || !s->vertical_bs)
         goto fail;
 
+    s->filter_progress = av_mallocz_array(sps->ctb_height, sizeof(*s->filter_progress));
+    if (!s->filter_progress)
+        goto fail;
+
     s->tab_mvf_pool = av_buffer_pool_init(min_pu_size * sizeof(MvField),
                                           av_buffer_allocz);
     s->rpl_tab_pool = av_buffer_pool_init(ctb_count * sizeof(RefPicListTab),
@@ -843,10 +849,10 @@ static int hls_slice_header(HEVCContext *s)
                 unsigned val = get_bits_long(gb, offset_len);
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
-            if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
-                s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
-                s->threads_number = 1;
-            } else
+            /* the substreams of WPP rows inside tiles are decoded serially */
+            if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1))
+                s->enable_parallel_tiles = !s->ps.pps->entropy_coding_sync_enabled_flag;
+            else
                 s->enable_parallel_tiles = 0;
         } else
             s->enable_parallel_tiles = 0;
@@ -2489,6 +2495,11 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
         if (ret < 0)
             goto error;
         hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
         more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
 
         if (more_data < 0) {
@@ -2530,39 +2541,29 @@ error:
     return ret;
 }
 
-static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
+/**
+ * Locate the substreams of the current slice segment in the NAL unit and
+ * set up the per-thread contexts decoding them.
+ */
+static int init_substreams(HEVCContext *s, const H2645NAL *nal)
 {
     const uint8_t *data = nal->data;
     int length          = nal->size;
     HEVCLocalContext *lc = s->HEVClc;
-    int *ret = av_malloc_array(s->sh.num_entry_point_offsets + 1, sizeof(int));
-    int *arg = av_malloc_array(s->sh.num_entry_point_offsets + 1, sizeof(int));
     int64_t offset;
     int64_t startheader, cmpt = 0;
-    int i, j, res = 0;
-
-    if (!ret || !arg) {
-        av_free(ret);
-        av_free(arg);
-        return AVERROR(ENOMEM);
-    }
-
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
-        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
-            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
-            s->ps.sps->ctb_width, s->ps.sps->ctb_height
-        );
-        res = AVERROR_INVALIDDATA;
-        goto error;
-    }
-
-    ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
+    int i, j;
 
     if (!s->sList[1]) {
         for (i = 1; i < s->threads_number; i++) {
             s->sList[i] = av_malloc(sizeof(HEVCContext));
-            memcpy(s->sList[i], s, sizeof(HEVCContext));
             s->HEVClcList[i] = av_mallocz(sizeof(HEVCLocalContext));
+            if (!s->sList[i] || !s->HEVClcList[i]) {
+                av_freep(&s->sList[i]);
+                av_freep(&s->HEVClcList[i]);
+                return AVERROR(ENOMEM);
+            }
+            memcpy(s->sList[i], s, sizeof(HEVCContext));
             s->sList[i]->HEVClc = s->HEVClcList[i];
         }
     }
@@ -2593,14 +2594,14 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         offset += s->sh.entry_point_offset[s->sh.num_entry_point_offsets - 1] - cmpt;
         if (length < offset) {
             av_log(s->avctx, AV_LOG_ERROR, "entry_point_offset table is corrupted\n");
-            res = AVERROR_INVALIDDATA;
-            goto error;
+            return AVERROR_INVALIDDATA;
         }
         s->sh.size[s->sh.num_entry_point_offsets - 1] = length - offset;
         s->sh.offset[s->sh.num_entry_point_offsets - 1] = offset;
 
     }
     s->data = data;
+    s->entry_points_parallel = 1;
 
     for (i = 1; i < s->threads_number; i++) {
         s->sList[i]->HEVClc->first_qp_group = 1;
@@ -2610,6 +2611,39 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
     }
 
     atomic_store(&s->wpp_err, 0);
+
+    return 0;
+}
+
+static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
+{
+    int *ret = av_malloc_array(s->sh.num_entry_point_offsets + 1, sizeof(int));
+    int *arg = av_malloc_array(s->sh.num_entry_point_offsets + 1, sizeof(int));
+    int i, res = 0;
+
+    if (!ret || !arg) {
+        av_free(ret);
+        av_free(arg);
+        return AVERROR(ENOMEM);
+    }
+
+    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
+        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
+            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
+            s->ps.sps->ctb_width, s->ps.sps->ctb_height
+        );
+        res = AVERROR_INVALIDDATA;
+        goto error;
+    }
+
+    res = ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
+    if (res < 0)
+        goto error;
+
+    res = init_substreams(s, nal);
+    if (res < 0)
+        goto error;
+
     ff_reset_entries(s->avctx);
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
@@ -2619,6 +2653,7 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 
     if (s->ps.pps->entropy_coding_sync_enabled_flag)
         s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+    s->entry_points_parallel = 0;
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
         res += ret[i];
@@ -2628,6 +2663,164 @@ error:
     return res;
 }
 
+static int hls_decode_entry_tile(AVCodecContext *avctxt, void *input_ctb_addr_ts, int job, int self_id)
+{
+    HEVCContext *s1  = avctxt->priv_data, *s;
+    HEVCLocalContext *lc;
+    int more_data   = 1;
+    int ctb_addr_ts = ((int *)input_ctb_addr_ts)[job];
+    int tile_id     = s1->ps.pps->tile_id[ctb_addr_ts];
+    int ctb_addr_rs = s1->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+    int ret;
+
+    s  = s1->sList[self_id];
+    lc = s->HEVClc;
+
+    if (job) {
+        ret = init_get_bits8(&lc->gb, s->data + s->sh.offset[job - 1], s->sh.size[job - 1]);
+        if (ret < 0)
+            goto error;
+        ff_init_cabac_decoder(&lc->cc, s->data + s->sh.offset[job - 1], s->sh.size[job - 1]);
+    }
+
+    while (more_data && ctb_addr_ts < s->ps.sps->ctb_size &&
+           s->ps.pps->tile_id[ctb_addr_ts] == tile_id) {
+        int x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        int y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+
+        if (atomic_load(&s1->wpp_err))
+            return 0;
+
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        ret = ff_hevc_cabac_init(s, ctb_addr_ts);
+        if (ret < 0)
+            goto error;
+        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+        more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            ret = more_data;
+            goto error;
+        }
+
+        ctb_addr_ts++;
+        ff_hevc_save_states(s, ctb_addr_ts);
+        if (ctb_addr_ts < s->ps.sps->ctb_size)
+            ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+    }
+
+    /* only the last substream may end before the end of its tile */
+    if (!more_data && job != s->sh.num_entry_point_offsets &&
+        ctb_addr_ts < s->ps.sps->ctb_size &&
+        s->ps.pps->tile_id[ctb_addr_ts] == tile_id) {
+        ret = AVERROR_INVALIDDATA;
+        goto error;
+    }
+
+    return ctb_addr_ts;
+error:
+    s->tab_slice_address[ctb_addr_rs] = -1;
+    atomic_store(&s1->wpp_err, 1);
+    return ret;
+}
+
+/**
+ * Decode the tiles of a slice segment in parallel, one tile per entry
+ * point. The deblocking and SAO filters need the neighbouring tiles, so
+ * they run once all the tiles of the segment are decoded.
+ */
+static int hls_slice_data_tiles(HEVCContext *s, const H2645NAL *nal)
+{
+    const HEVCSPS *sps = s->ps.sps;
+    const HEVCPPS *pps = s->ps.pps;
+    int ctb_size    = 1 << sps->log2_ctb_size;
+    int nb_jobs     = s->sh.num_entry_point_offsets + 1;
+    int ctb_addr_ts = pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int start_ts    = ctb_addr_ts;
+    int tile_id     = pps->tile_id[ctb_addr_ts];
+    int *ret, *arg;
+    int i, res = 0;
+
+    if (!ctb_addr_ts && s->sh.dependent_slice_segment_flag) {
+        av_log(s->avctx, AV_LOG_ERROR, "Impossible initial tile.\n");
+        return AVERROR_INVALIDDATA;
+    }
+
+    if (s->sh.dependent_slice_segment_flag) {
+        int prev_rs = pps->ctb_addr_ts_to_rs[ctb_addr_ts - 1];
+        if (s->tab_slice_address[prev_rs] != s->sh.slice_addr) {
+            av_log(s->avctx, AV_LOG_ERROR, "Previous slice segment missing\n");
+            return AVERROR_INVALIDDATA;
+        }
+    }
+
+    if (pps->ctb_addr_rs_to_ts[pps->tile_pos_rs[tile_id]] != ctb_addr_ts ||
+        tile_id + nb_jobs > pps->num_tile_columns * pps->num_tile_rows) {
+        av_log(s->avctx, AV_LOG_ERROR, "Tile entry points are wrong (%d %d)\n",
+               tile_id, s->sh.num_entry_point_offsets);
+        return AVERROR_INVALIDDATA;
+    }
+
+    ret = av_malloc_array(nb_jobs, sizeof(int));
+    arg = av_malloc_array(nb_jobs, sizeof(int));
+    if (!ret || !arg) {
+        res = AVERROR(ENOMEM);
+        goto error;
+    }
+
+    res = init_substreams(s, nal);
+    if (res < 0)
+        goto error;
+
+    for (i = 0; i < nb_jobs; i++) {
+        arg[i] = pps->ctb_addr_rs_to_ts[pps->tile_pos_rs[tile_id + i]];
+        ret[i] = 0;
+    }
+
+    s->avctx->execute2(s->avctx, hls_decode_entry_tile, arg, ret, nb_jobs);
+    s->entry_points_parallel = 0;
+
+    for (i = 0; i < nb_jobs; i++) {
+        if (ret[i] < 0) {
+            res = ret[i];
+            goto error;
+        }
+    }
+    ctb_addr_ts = ret[nb_jobs - 1];
+    if (atomic_load(&s->wpp_err) || ctb_addr_ts <= start_ts) {
+        res = AVERROR_INVALIDDATA;
+        goto error;
+    }
+
+    for (i = start_ts; i < ctb_addr_ts; i++) {
+        int ctb_addr_rs = pps->ctb_addr_ts_to_rs[i];
+        ff_hevc_deblocking_boundary_strengths_tile_edges(s,
+            (ctb_addr_rs % sps->ctb_width) << sps->log2_ctb_size,
+            (ctb_addr_rs / sps->ctb_width) << sps->log2_ctb_size);
+    }
+
+    for (i = start_ts; i < ctb_addr_ts; i++) {
+        int ctb_addr_rs = pps->ctb_addr_ts_to_rs[i];
+        int x_ctb = (ctb_addr_rs % sps->ctb_width) << sps->log2_ctb_size;
+        int y_ctb = (ctb_addr_rs / sps->ctb_width) << sps->log2_ctb_size;
+
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (x_ctb + ctb_size >= sps->width && y_ctb + ctb_size >= sps->height)
+            ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+    }
+    res = ctb_addr_ts;
+
+error:
+    av_free(ret);
+    av_free(arg);
+    return res;
+}
+
 static int set_side_data(HEVCContext *s)
 {
     AVFrame *out = s->ref->frame;
@@ -2784,6 +2977,8 @@ static int hevc_frame_start(HEVCContext *s)
     memset(s->cbf_luma,      0, s->ps.sps->min_tb_width * s->ps.sps->min_tb_height);
     memset(s->is_pcm,        0, (s->ps.sps->min_pu_width + 1) * (s->ps.sps->min_pu_height + 1));
     memset(s->tab_slice_address, -1, pic_size_in_ctb * sizeof(*s->tab_slice_address));
+    memset(s->filter_progress,   0, s->ps.sps->ctb_height * sizeof(*s->filter_progress));
+    s->nb_filtered_rows = 0;
 
     s->is_decoded        = 0;
     s->first_nal_type    = s->nal_unit_type;
@@ -2978,7 +3173,10 @@ static int decode_nal_unit(HEVCContext *s, const H2645NAL *nal)
             if (ret < 0)
                 goto fail;
         } else {
-            if (s->threads_number > 1 && s->sh.num_entry_point_offsets > 0)
+            if (s->enable_parallel_tiles && s->sh.num_entry_point_offsets > 0)
+                ctb_addr_ts = hls_slice_data_tiles(s, nal);
+            else if (s->threads_number > 1 && s->sh.num_entry_point_offsets > 0 &&
+                     s->ps.pps->num_tile_rows == 1 && s->ps.pps->num_tile_columns == 1)
                 ctb_addr_ts = hls_slice_data_wpp(s, nal);
             else
                 ctb_addr_ts = hls_slice_data(s);
@@ -3272,6 +3470,7 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
     int i;
 
     pic_arrays_free(s);
+    ff_mutex_destroy(&s->filter_progress_mutex);
 
     av_freep(&s->md5_ctx);
 
@@ -3316,6 +3515,7 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
     int i;
 
     s->avctx = avctx;
+    ff_mutex_init(&s->filter_progress_mutex, NULL);
 
     s->HEVClc = av_mallocz(sizeof(HEVCLocalContext));
     if (!s->HEVClc)
@@ -3459,10 +3659,7 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
 
     atomic_init(&s->wpp_err, 0);
 
-    if(avctx->active_thread_type & FF_THREAD_SLICE)
-        s->threads_number = avctx->thread_count;
-    else
-        s->threads_number = 1;
+    s->threads_number = ff_slice_thread_count(avctx);
 
     if (avctx->extradata_size > 0 && avctx->extradata) {
         ret = hevc_decode_extradata(s, avctx->extradata, avctx->extradata_size, 1);
@@ -3537,7 +3734,8 @@ AVCodec ff_hevc_decoder = {
     .init_thread_copy      = ONLY_IF_THREADS_ENABLED(hevc_init_thread_copy),
     .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
                              AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
-    .caps_internal         = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_EXPORTS_CROPPING,
+    .caps_internal         = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_EXPORTS_CROPPING |
+                             FF_CODEC_CAP_NESTED_SLICE_THREADS,
     .profiles              = NULL_IF_CONFIG_SMALL(ff_hevc_profiles),
     .hw_configs            = (const AVCodecHWConfigInternal*[]) {
 #if CONFIG_HEVC_DXVA2_HWACCEL
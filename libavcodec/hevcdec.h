@@ -27,6 +27,7 @@
 
 #include "libavutil/buffer.h"
 #include "libavutil/md5.h"
+#include "libavutil/thread.h"
 
 #include "avcodec.h"
 #include "bswapdsp.h"
@@ -469,6 +470,20 @@ typedef struct HEVCContext {
 
     int enable_parallel_tiles;
     atomic_int wpp_err;
+    /**
+     * Set while the substreams of the current slice segment are decoded in
+     * parallel, each one starting from its own HEVCLocalContext.gb.
+     */
+    int entry_points_parallel;
+
+    /**
+     * Frame threading progress of each CTB row once it is filtered, plus one.
+     * The WPP threads of a frame thread can finish the rows out of order, so
+     * the progress is only reported up to the first row not filtered yet.
+     */
+    AVMutex filter_progress_mutex;
+    int *filter_progress;
+    int nb_filtered_rows;
 
     const uint8_t *data;
 
@@ -591,6 +606,7 @@ void ff_hevc_set_qPy(HEVCContext *s, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+void ff_hevc_deblocking_boundary_strengths_tile_edges(HEVCContext *s, int x_ctb, int y_ctb);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
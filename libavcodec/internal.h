@@ -68,6 +68,12 @@
  * Codec initializes slice-based threading with a main function
  */
 #define FF_CODEC_CAP_SLICE_THREAD_HAS_MF    (1 << 5)
+/**
+ * The decoder supports frame threading and slice threading at the same time:
+ * each frame thread then gets its own pool of slice threads, used by
+ * execute() and execute2().
+ */
+#define FF_CODEC_CAP_NESTED_SLICE_THREADS   (1 << 6)
 
 #ifdef TRACE
 #   define ff_tlog(ctx, ...) av_log(ctx, AV_LOG_TRACE, __VA_ARGS__)
@@ -103,6 +109,11 @@ typedef struct FramePool {
      * so only pools[0] is used.
      */
     AVBufferPool *pools[4];
+    /**
+     * Size of the buffers of each pool, used to request buffers of the same
+     * size from AVCodecContext.shared_buffer_pool instead.
+     */
+    int pool_size[4];
 
     /*
      * Pool parameters
@@ -161,6 +172,11 @@ typedef struct AVCodecInternal {
     FramePool *pool;
 
     void *thread_ctx;
+    /**
+     * Slice threading context of a frame thread, see
+     * FF_CODEC_CAP_NESTED_SLICE_THREADS.
+     */
+    void *slice_thread_ctx;
 
     DecodeSimpleContext ds;
     DecodeFilterContext filter;
@@ -44,6 +44,7 @@
 #include "mjpegdec.h"
 #include "jpeglsdec.h"
 #include "put_bits.h"
+#include "thread.h"
 #include "tiff.h"
 #include "exif.h"
 #include "bytestream.h"
@@ -72,34 +73,61 @@ static int build_vlc(VLC *vlc, const uint8_t *bits_table,
                               huff_code, 2, 2, huff_sym, 2, 2, use_static);
 }
 
-static int build_basic_mjpeg_vlc(MJpegDecodeContext *s)
+/**
+ * Build the VLCs for one Huffman table and keep a raw copy of it, which is
+ * used by hwaccels and to copy the table between frame threads.
+ */
+static int init_huffman_table(MJpegDecodeContext *s, int class, int index,
+                              const uint8_t *bits_table,
+                              const uint8_t *val_table)
 {
-    int ret;
-
-    if ((ret = build_vlc(&s->vlcs[0][0], avpriv_mjpeg_bits_dc_luminance,
-                         avpriv_mjpeg_val_dc, 12, 0, 0)) < 0)
+    int i, n = 0, code_max = 0, ret;
+
+    for (i = 1; i <= 16; i++)
+        n += bits_table[i];
+    for (i = 0; i < n; i++)
+        code_max = FFMAX(code_max, val_table[i]);
+
+    /* build VLC and flush previous vlc if present */
+    ff_free_vlc(&s->vlcs[class][index]);
+    av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
+           class, index, code_max + 1);
+    if ((ret = build_vlc(&s->vlcs[class][index], bits_table, val_table,
+                         code_max + 1, 0, class > 0)) < 0)
         return ret;
 
-    if ((ret = build_vlc(&s->vlcs[0][1], avpriv_mjpeg_bits_dc_chrominance,
-                         avpriv_mjpeg_val_dc, 12, 0, 0)) < 0)
-        return ret;
+    if (class > 0) {
+        ff_free_vlc(&s->vlcs[2][index]);
+        if ((ret = build_vlc(&s->vlcs[2][index], bits_table, val_table,
+                             code_max + 1, 0, 0)) < 0)
+            return ret;
+    }
 
-    if ((ret = build_vlc(&s->vlcs[1][0], avpriv_mjpeg_bits_ac_luminance,
-                         avpriv_mjpeg_val_ac_luminance, 251, 0, 1)) < 0)
-        return ret;
+    memcpy(s->raw_huffman_lengths[class][index], bits_table + 1, 16);
+    memcpy(s->raw_huffman_values[class][index], val_table, n);
+    memset(s->raw_huffman_values[class][index] + n, 0, 256 - n);
+    return 0;
+}
+
+static int build_basic_mjpeg_vlc(MJpegDecodeContext *s)
+{
+    int ret;
 
-    if ((ret = build_vlc(&s->vlcs[1][1], avpriv_mjpeg_bits_ac_chrominance,
-                         avpriv_mjpeg_val_ac_chrominance, 251, 0, 1)) < 0)
+    if ((ret = init_huffman_table(s, 0, 0, avpriv_mjpeg_bits_dc_luminance,
+                                  avpriv_mjpeg_val_dc)) < 0)
         return ret;
 
-    if ((ret = build_vlc(&s->vlcs[2][0], avpriv_mjpeg_bits_ac_luminance,
-                         avpriv_mjpeg_val_ac_luminance, 251, 0, 0)) < 0)
+    if ((ret = init_huffman_table(s, 0, 1, avpriv_mjpeg_bits_dc_chrominance,
+                                  avpriv_mjpeg_val_dc)) < 0)
         return ret;
 
-    if ((ret = build_vlc(&s->vlcs[2][1], avpriv_mjpeg_bits_ac_chrominance,
-                         avpriv_mjpeg_val_ac_chrominance, 251, 0, 0)) < 0)
+    if ((ret = init_huffman_table(s, 1, 0, avpriv_mjpeg_bits_ac_luminance,
+                                  avpriv_mjpeg_val_ac_luminance)) < 0)
         return ret;
 
+    if ((ret = init_huffman_table(s, 1, 1, avpriv_mjpeg_bits_ac_chrominance,
+                                  avpriv_mjpeg_val_ac_chrominance)) < 0)
+        return ret;
 
     return 0;
 }
@@ -228,7 +256,7 @@ int ff_mjpeg_decode_dqt(MJpegDecodeContext *s)
 /* decode huffman tables and build VLC decoders */
 int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
 {
-    int len, index, i, class, n, v, code_max;
+    int len, index, i, class, n;
     uint8_t bits_table[17];
     uint8_t val_table[256];
     int ret = 0;
@@ -258,41 +286,28 @@ int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
         if (len < n || n > 256)
             return AVERROR_INVALIDDATA;
 
-        code_max = 0;
-        for (i = 0; i < n; i++) {
-            v = get_bits(&s->gb, 8);
-            if (v > code_max)
-                code_max = v;
-            val_table[i] = v;
-        }
+        for (i = 0; i < n; i++)
+            val_table[i] = get_bits(&s->gb, 8);
         len -= n;
 
-        /* build VLC and flush previous vlc if present */
-        ff_free_vlc(&s->vlcs[class][index]);
-        av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
-               class, index, code_max + 1);
-        if ((ret = build_vlc(&s->vlcs[class][index], bits_table, val_table,
-                             code_max + 1, 0, class > 0)) < 0)
+        if ((ret = init_huffman_table(s, class, index, bits_table, val_table)) < 0)
             return ret;
-
-        if (class > 0) {
-            ff_free_vlc(&s->vlcs[2][index]);
-            if ((ret = build_vlc(&s->vlcs[2][index], bits_table, val_table,
-                                 code_max + 1, 0, 0)) < 0)
-                return ret;
-        }
-
-        for (i = 0; i < 16; i++)
-            s->raw_huffman_lengths[class][index][i] = bits_table[i + 1];
-        for (i = 0; i < 256; i++)
-            s->raw_huffman_values[class][index][i] = val_table[i];
     }
     return 0;
 }
 
+static void release_picture(MJpegDecodeContext *s)
+{
+    ThreadFrame tframe = { .f = s->picture_ptr };
+    ff_thread_release_buffer(s->avctx, &tframe);
+    /* also reset the properties of a frame without buffers */
+    av_frame_unref(s->picture_ptr);
+}
+
 int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
 {
     int len, nb_components, i, width, height, bits, ret, size_change;
+    ThreadFrame tframe;
     unsigned pix_fmt_id;
     int h_count[MAX_COMPONENTS] = { 0 };
     int v_count[MAX_COMPONENTS] = { 0 };
@@ -680,8 +695,9 @@ unk_pixfmt:
         return 0;
     }
 
-    av_frame_unref(s->picture_ptr);
-    if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+    release_picture(s);
+    tframe.f = s->picture_ptr;
+    if (ff_thread_get_buffer(s->avctx, &tframe, AV_GET_BUFFER_FLAG_REF) < 0)
         return -1;
     s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
     s->picture_ptr->key_frame = 1;
@@ -1334,28 +1350,31 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
-static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
-                             int Al, const uint8_t *mb_bitmask,
-                             int mb_bitmask_size,
-                             const AVFrame *reference)
+/**
+ * Decode the MCUs mb_start to mb_end - 1 of a sequential or progressive DC
+ * scan, starting at the current bitstream position.
+ *
+ * @return negative error code, or whether a restart marker was consumed
+ *         after the last MCU
+ */
+static int mjpeg_decode_scan_mbs(MJpegDecodeContext *s, int nb_components,
+                                 int Ah, int Al, const uint8_t *mb_bitmask,
+                                 const AVFrame *reference,
+                                 int mb_start, int mb_end)
 {
-    int i, mb_x, mb_y, chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
+    int i, mb, mb_x, mb_y, chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
     uint8_t *data[MAX_COMPONENTS];
     const uint8_t *reference_data[MAX_COMPONENTS];
     int linesize[MAX_COMPONENTS];
     GetBitContext mb_bitmask_gb = {0}; // initialize to silence gcc warning
     int bytes_per_pixel = 1 + (s->bits > 8);
+    int reset = 0;
 
     if (mb_bitmask) {
-        if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
-            av_log(s->avctx, AV_LOG_ERROR, "mb_bitmask_size mismatches\n");
-            return AVERROR_INVALIDDATA;
-        }
         init_get_bits(&mb_bitmask_gb, mb_bitmask, s->mb_width * s->mb_height);
+        skip_bits_long(&mb_bitmask_gb, mb_start);
     }
 
-    s->restart_count = 0;
-
     av_pix_fmt_get_chroma_sub_sample(s->avctx->pix_fmt, &chroma_h_shift,
                                      &chroma_v_shift);
     chroma_width  = AV_CEIL_RSHIFT(s->width,  chroma_h_shift);
@@ -1366,95 +1385,227 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         data[c] = s->picture_ptr->data[c];
         reference_data[c] = reference ? reference->data[c] : NULL;
         linesize[c] = s->linesize[c];
-        s->coefs_finished[c] |= 1;
     }
 
-    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
-        for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
-            const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
+    mb_x = mb_start % s->mb_width;
+    mb_y = mb_start / s->mb_width;
+    for (mb = mb_start; mb < mb_end; mb++) {
+        const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
 
-            if (s->restart_interval && !s->restart_count)
-                s->restart_count = s->restart_interval;
+        if (s->restart_interval && !s->restart_count)
+            s->restart_count = s->restart_interval;
+
+        if (get_bits_left(&s->gb) < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
+                   -get_bits_left(&s->gb));
+            return AVERROR_INVALIDDATA;
+        }
+        for (i = 0; i < nb_components; i++) {
+            uint8_t *ptr;
+            int n, h, v, x, y, c, j;
+            int block_offset;
+            n = s->nb_blocks[i];
+            c = s->comp_index[i];
+            h = s->h_scount[i];
+            v = s->v_scount[i];
+            x = 0;
+            y = 0;
+            for (j = 0; j < n; j++) {
+                block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
+                                 (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
+
+                if (s->interlaced && s->bottom_field)
+                    block_offset += linesize[c] >> 1;
+                if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
+                    && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)) {
+                    ptr = data[c] + block_offset;
+                } else
+                    ptr = NULL;
+                if (!s->progressive) {
+                    if (copy_mb) {
+                        if (ptr)
+                            mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
+                                            linesize[c], s->avctx->lowres);
 
-            if (get_bits_left(&s->gb) < 0) {
-                av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
-                       -get_bits_left(&s->gb));
-                return AVERROR_INVALIDDATA;
-            }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = (((linesize[c] * (v * mb_y + y) * 8) +
-                                     (h * mb_x + x) * 8 * bytes_per_pixel) >> s->avctx->lowres);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? chroma_width  : s->width)
-                        && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? chroma_height : s->height)) {
-                        ptr = data[c] + block_offset;
-                    } else
-                        ptr = NULL;
-                    if (!s->progressive) {
-                        if (copy_mb) {
-                            if (ptr)
-                                mjpeg_copy_block(s, ptr, reference_data[c] + block_offset,
-                                                linesize[c], s->avctx->lowres);
-
-                        } else {
-                            s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_sindex[i]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            if (ptr) {
-                                s->idsp.idct_put(ptr, linesize[c], s->block);
-                                if (s->bits & 7)
-                                    shift_output(s, ptr, linesize[c]);
-                            }
-                        }
                     } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_sindex[i]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_sindex[i]],
-                                                       Al) < 0) {
+                        s->bdsp.clear_block(s->block);
+                        if (decode_block(s, s->block, i,
+                                         s->dc_index[i], s->ac_index[i],
+                                         s->quant_matrixes[s->quant_sindex[i]]) < 0) {
                             av_log(s->avctx, AV_LOG_ERROR,
                                    "error y=%d x=%d\n", mb_y, mb_x);
                             return AVERROR_INVALIDDATA;
                         }
+                        if (ptr) {
+                            s->idsp.idct_put(ptr, linesize[c], s->block);
+                            if (s->bits & 7)
+                                shift_output(s, ptr, linesize[c]);
+                        }
                     }
-                    ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
+                } else {
+                    int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                     (h * mb_x + x);
+                    int16_t *block = s->blocks[c][block_idx];
+                    if (Ah)
+                        block[0] += get_bits1(&s->gb) *
+                                    s->quant_matrixes[s->quant_sindex[i]][0] << Al;
+                    else if (decode_dc_progressive(s, block, i, s->dc_index[i],
+                                                   s->quant_matrixes[s->quant_sindex[i]],
+                                                   Al) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
                     }
                 }
+                ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+                ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                        mb_x, mb_y, x, y, c, s->bottom_field,
+                        (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+                if (++x == h) {
+                    x = 0;
+                    y++;
+                }
             }
+        }
 
-            handle_rstn(s, nb_components);
+        reset = handle_rstn(s, nb_components);
+
+        if (++mb_x == s->mb_width) {
+            mb_x = 0;
+            mb_y++;
         }
     }
+    return reset;
+}
+
+#define MAX_SCAN_SLICES 32
+
+typedef struct ScanSliceContext {
+    int nb_components, Ah, Al;
+    const uint8_t *mb_bitmask;
+    const AVFrame *reference;
+    int nb_intervals;
+    int nb_jobs;
+    int start;          ///< bit position of the first MCU
+    const int *rst;     ///< byte offsets following the restart markers of this scan
+    GetBitContext gb;   ///< bitstream position after the last MCU
+} ScanSliceContext;
+
+/**
+ * Decode a run of restart intervals. Each job works on a copy of the context
+ * and verifies that it ends right after the restart marker where the next
+ * job starts, which is where the sequential decoder would continue.
+ */
+static int mjpeg_decode_scan_slice(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    ScanSliceContext *sc  = arg;
+    MJpegDecodeContext sl = *s;
+    int first    = sc->nb_intervals *  jobnr      / sc->nb_jobs;
+    int last     = sc->nb_intervals * (jobnr + 1) / sc->nb_jobs;
+    int mb_start = first * s->restart_interval;
+    int mb_end   = FFMIN(last * s->restart_interval, s->mb_width * s->mb_height);
+    int start    = first ? sc->rst[first - 1] * 8 : sc->start;
+    int i, ret;
+
+    skip_bits_long(&sl.gb, start - get_bits_count(&sl.gb));
+    sl.restart_count = 0;
+    for (i = 0; i < sc->nb_components; i++)
+        sl.last_dc[i] = (4 << s->bits);
+
+    ret = mjpeg_decode_scan_mbs(&sl, sc->nb_components, sc->Ah, sc->Al,
+                                sc->mb_bitmask, sc->reference, mb_start, mb_end);
+    if (ret < 0)
+        return ret;
+
+    if (jobnr == sc->nb_jobs - 1)
+        sc->gb = sl.gb;
+    else if (!ret || get_bits_count(&sl.gb) != sc->rst[last - 1] * 8)
+        return AVERROR_INVALIDDATA;
+
+    emms_c();
+    return 0;
+}
+
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s, int nb_components,
+                                      int Ah, int Al, const uint8_t *mb_bitmask,
+                                      const AVFrame *reference)
+{
+    AVCodecContext *avctx = s->avctx;
+    int nb_mbs = s->mb_width * s->mb_height;
+    ScanSliceContext sc = {
+        .nb_components = nb_components,
+        .Ah            = Ah,
+        .Al            = Al,
+        .mb_bitmask    = mb_bitmask,
+        .reference     = reference,
+        .start         = get_bits_count(&s->gb),
+    };
+    int i, first_rst, ret[MAX_SCAN_SLICES];
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) ||
+        avctx->thread_count < 2 || !s->restart_interval ||
+        s->gb.buffer != s->buffer)
+        return AVERROR(ENOSYS);
+
+    sc.nb_intervals = (nb_mbs + s->restart_interval - 1) / s->restart_interval;
+    sc.nb_jobs      = FFMIN3(avctx->thread_count, sc.nb_intervals, MAX_SCAN_SLICES);
+    if (sc.nb_jobs < 2)
+        return AVERROR(ENOSYS);
+
+    /* the markers of this scan follow the current position */
+    for (first_rst = 0; first_rst < s->nb_rst_offsets; first_rst++)
+        if (s->rst_offsets[first_rst] * 8 > sc.start)
+            break;
+    if (s->nb_rst_offsets - first_rst < sc.nb_intervals - 1)
+        return AVERROR(ENOSYS);
+    sc.rst = s->rst_offsets + first_rst;
+
+    avctx->execute2(avctx, mjpeg_decode_scan_slice, &sc, ret, sc.nb_jobs);
+    for (i = 0; i < sc.nb_jobs; i++)
+        if (ret[i] < 0)
+            return ret[i];
+
+    s->gb = sc.gb;
     return 0;
 }
 
+static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
+                             int Al, const uint8_t *mb_bitmask,
+                             int mb_bitmask_size,
+                             const AVFrame *reference)
+{
+    GetBitContext gb = s->gb;
+    int i, ret;
+
+    if (mb_bitmask) {
+        if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
+            av_log(s->avctx, AV_LOG_ERROR, "mb_bitmask_size mismatches\n");
+            return AVERROR_INVALIDDATA;
+        }
+    }
+
+    s->restart_count = 0;
+
+    for (i = 0; i < nb_components; i++)
+        s->coefs_finished[s->comp_index[i]] |= 1;
+
+    if (mjpeg_decode_scan_threaded(s, nb_components, Ah, Al,
+                                   mb_bitmask, reference) >= 0)
+        return 0;
+
+    /* not threaded, or some restart interval did not end where the next one
+     * starts: decode the scan sequentially from its beginning */
+    s->gb = gb;
+    for (i = 0; i < nb_components; i++)
+        s->last_dc[i] = (4 << s->bits);
+
+    ret = mjpeg_decode_scan_mbs(s, nb_components, Ah, Al, mb_bitmask, reference,
+                                0, s->mb_width * s->mb_height);
+    return FFMIN(ret, 0);
+}
+
 static int mjpeg_decode_scan_progressive_ac(MJpegDecodeContext *s, int ss,
                                             int se, int Ah, int Al)
 {
@@ -2125,6 +2276,11 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
         const uint8_t *src = *buf_ptr;
         const uint8_t *ptr = src;
         uint8_t *dst = s->buffer;
+        /* restart intervals are located here because a marker can not be
+         * told apart from unescaped data later */
+        int record_rst = s->avctx->active_thread_type & FF_THREAD_SLICE;
+
+        s->nb_rst_offsets = 0;
 
         #define copy_data_segment(skip) do {       \
             ptrdiff_t length = (ptr - src) - (skip);  \
@@ -2163,6 +2319,13 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else if (record_rst) {
+                        int *tmp = av_fast_realloc(s->rst_offsets, &s->rst_offsets_size,
+                                                   (s->nb_rst_offsets + 1) * sizeof(*s->rst_offsets));
+                        if (!tmp)
+                            return AVERROR(ENOMEM);
+                        s->rst_offsets = tmp;
+                        s->rst_offsets[s->nb_rst_offsets++] = dst - s->buffer + (ptr - src);
                     }
                 }
             }
@@ -2228,6 +2391,20 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     return start_code;
 }
 
+/**
+ * Check that only restart markers and EOI follow the scan at buf_ptr.
+ */
+static int is_last_scan(const uint8_t *buf_ptr, const uint8_t *buf_end)
+{
+    int code;
+
+    do {
+        code = find_marker(&buf_ptr, buf_end);
+    } while (code >= RST0 && code <= RST7);
+
+    return code == EOI;
+}
+
 static void reset_icc_profile(MJpegDecodeContext *s)
 {
     int i;
@@ -2259,6 +2436,7 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
     int is16bit;
 
     s->buf_size = buf_size;
+    s->setup_finished = 0;
 
     av_dict_free(&s->exif_metadata);
     av_freep(&s->stereo3d);
@@ -2457,6 +2635,15 @@ eoi_parser:
                 break;
             }
 
+            /* with a single scan all state needed by the next frame is
+             * known now, let the next frame thread start */
+            if ((avctx->active_thread_type & FF_THREAD_FRAME) &&
+                !avctx->hwaccel && !s->setup_finished && !s->interlaced &&
+                !s->progressive && !s->ls && is_last_scan(buf_ptr, buf_end)) {
+                s->setup_finished = 1;
+                ff_thread_finish_setup(avctx);
+            }
+
             if ((ret = ff_mjpeg_decode_sos(s, NULL, 0, NULL)) < 0 &&
                 (avctx->err_recognition & AV_EF_EXPLODE))
                 goto fail;
@@ -2737,6 +2924,7 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
         av_frame_unref(s->picture_ptr);
 
     av_freep(&s->buffer);
+    av_freep(&s->rst_offsets);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2758,6 +2946,153 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     return 0;
 }
 
+#if HAVE_THREADS
+/**
+ * Build the VLCs of src in dst. dst->vlcs must hold the tables of old, or be
+ * zeroed if old is NULL.
+ */
+static int copy_huffman_tables(MJpegDecodeContext *dst,
+                               const MJpegDecodeContext *src,
+                               const MJpegDecodeContext *old)
+{
+    int class, index, ret;
+
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            uint8_t bits_table[17] = { 0 };
+            int have_old = old && old->vlcs[class][index].table;
+
+            if (!src->vlcs[class][index].table) {
+                if (have_old) {
+                    ff_free_vlc(&dst->vlcs[class][index]);
+                    if (class > 0)
+                        ff_free_vlc(&dst->vlcs[2][index]);
+                }
+                continue;
+            }
+            if (have_old &&
+                !memcmp(old->raw_huffman_lengths[class][index],
+                        src->raw_huffman_lengths[class][index], 16) &&
+                !memcmp(old->raw_huffman_values[class][index],
+                        src->raw_huffman_values[class][index], 256))
+                continue;
+
+            memcpy(bits_table + 1, src->raw_huffman_lengths[class][index], 16);
+            if ((ret = init_huffman_table(dst, class, index, bits_table,
+                                          src->raw_huffman_values[class][index])) < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+static int mjpeg_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    MJpegDecodeContext *src;
+    int ret;
+
+    /* the context is a copy of the first thread's, only keep its state */
+    src = av_memdup(s, sizeof(*s));
+    if (!src)
+        return AVERROR(ENOMEM);
+
+    s->avctx                   = avctx;
+    s->buffer                  = NULL;
+    s->buffer_size             = 0;
+    s->rst_offsets             = NULL;
+    s->rst_offsets_size        = 0;
+    s->nb_rst_offsets          = 0;
+    s->ljpeg_buffer            = NULL;
+    s->ljpeg_buffer_size       = 0;
+    s->exif_metadata           = NULL;
+    s->stereo3d                = NULL;
+    s->iccdata                 = NULL;
+    s->iccdatalens             = NULL;
+    s->iccnum                  = 0;
+    s->iccread                 = 0;
+    s->hwaccel_picture_private = NULL;
+    memset(s->blocks,   0, sizeof(s->blocks));
+    memset(s->last_nnz, 0, sizeof(s->last_nnz));
+    memset(s->vlcs,     0, sizeof(s->vlcs));
+
+    s->picture = s->picture_ptr = av_frame_alloc();
+    if (!s->picture) {
+        av_free(src);
+        return AVERROR(ENOMEM);
+    }
+
+    ret = copy_huffman_tables(s, src, NULL);
+    av_free(src);
+    return ret;
+}
+
+static int mjpeg_decode_update_thread_context(AVCodecContext *dst,
+                                              const AVCodecContext *src)
+{
+    MJpegDecodeContext *d = dst->priv_data, *s = src->priv_data;
+    MJpegDecodeContext *old;
+    int ret;
+
+    if (d == s)
+        return 0;
+
+    old = av_memdup(d, sizeof(*d));
+    if (!old)
+        return AVERROR(ENOMEM);
+
+    /* take over the complete decoder state, then restore what dst owns */
+    memcpy(d, s, sizeof(*d));
+
+    d->avctx                   = dst;
+    d->buffer                  = old->buffer;
+    d->buffer_size             = old->buffer_size;
+    d->rst_offsets             = old->rst_offsets;
+    d->rst_offsets_size        = old->rst_offsets_size;
+    d->nb_rst_offsets          = 0;
+    d->ljpeg_buffer            = old->ljpeg_buffer;
+    d->ljpeg_buffer_size       = old->ljpeg_buffer_size;
+    d->exif_metadata           = old->exif_metadata;
+    d->stereo3d                = old->stereo3d;
+    d->iccdata                 = old->iccdata;
+    d->iccdatalens             = old->iccdatalens;
+    d->iccnum                  = old->iccnum;
+    d->iccread                 = old->iccread;
+    d->hwaccel_picture_private = old->hwaccel_picture_private;
+    d->picture                 = old->picture;
+    d->picture_ptr             = old->picture_ptr;
+    memcpy(d->blocks,   old->blocks,   sizeof(d->blocks));
+    memcpy(d->last_nnz, old->last_nnz, sizeof(d->last_nnz));
+    memcpy(d->vlcs,     old->vlcs,     sizeof(d->vlcs));
+
+    /* the source thread is still decoding its only scan, which leaves no
+     * picture pending once it reaches EOI */
+    if (s->setup_finished) {
+        d->got_picture = 0;
+        d->cur_scan    = 0;
+    }
+    d->setup_finished = 0;
+
+    /* the progressive coefficient buffers are not shared, so a progressive
+     * picture can not be continued by another thread */
+    if (d->progressive)
+        d->got_picture = 0;
+
+    /* a second field continues the picture of the first one */
+    ret = 0;
+    if (d->got_picture) {
+        release_picture(d);
+        if (s->picture_ptr->buf[0])
+            ret = av_frame_ref(d->picture_ptr, s->picture_ptr);
+    }
+
+    if (ret >= 0)
+        ret = copy_huffman_tables(d, s, old);
+    av_free(old);
+    return ret;
+}
+#endif
+
 static void decode_flush(AVCodecContext *avctx)
 {
     MJpegDecodeContext *s = avctx->priv_data;
@@ -2790,7 +3125,10 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(mjpeg_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(mjpeg_decode_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE |
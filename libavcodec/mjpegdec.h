@@ -113,6 +113,9 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *rst_offsets;    ///< offsets following each RSTn marker in the unescaped SOS buffer
+    unsigned int rst_offsets_size;
+    int nb_rst_offsets;
 
     int buggy_avid;
     int cs_itu601;
@@ -148,6 +151,8 @@ typedef struct MJpegDecodeContext {
     uint8_t raw_huffman_lengths[2][4][16];
     uint8_t raw_huffman_values[2][4][256];
 
+    int setup_finished; ///< ff_thread_finish_setup() was called before EOI
+
     enum AVPixelFormat hwaccel_sw_pix_fmt;
     enum AVPixelFormat hwaccel_pix_fmt;
     void *hwaccel_picture_private;
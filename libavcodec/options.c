@@ -177,6 +177,7 @@ void avcodec_free_context(AVCodecContext **pavctx)
 
     avcodec_close(avctx);
 
+    av_buffer_unref(&avctx->shared_buffer_pool);
     av_freep(&avctx->extradata);
     av_freep(&avctx->subtitle_header);
     av_freep(&avctx->intra_matrix);
@@ -204,6 +205,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     av_freep(&avctx->subtitle_header);
     av_buffer_unref(&avctx->hw_frames_ctx);
     av_buffer_unref(&avctx->hw_device_ctx);
+    av_buffer_unref(&avctx->shared_buffer_pool);
     for (i = 0; i < avctx->nb_coded_side_data; i++)
         av_freep(&avctx->coded_side_data[i].data);
     av_freep(&avctx->coded_side_data);
@@ -256,6 +258,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     dest->subtitle_header = NULL;
     dest->hw_frames_ctx   = NULL;
     dest->hw_device_ctx   = NULL;
+    dest->shared_buffer_pool = NULL;
     dest->nb_coded_side_data = 0;
 
 #define alloc_and_copy_or_fail(obj, size, pad) \
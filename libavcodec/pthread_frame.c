@@ -700,6 +700,7 @@ void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
         }
 
         if (p->avctx) {
+            ff_slice_thread_free_nested(p->avctx);
             av_freep(&p->avctx->internal);
             av_buffer_unref(&p->avctx->hw_frames_ctx);
         }
@@ -726,6 +727,8 @@ int ff_frame_thread_init(AVCodecContext *avctx)
     const AVCodec *codec = avctx->codec;
     AVCodecContext *src = avctx;
     FrameThreadContext *fctx;
+    int auto_threads = !thread_count;
+    int slice_threads = 0;
     int i, err = 0;
 
     if (!thread_count) {
@@ -746,6 +749,15 @@ int ff_frame_thread_init(AVCodecContext *avctx)
         return 0;
     }
 
+    /* with an automatic thread count, give the cores not taken by the frame
+     * threads to slice threads running inside each of them; a thread count
+     * set by the user is the total and is all used by the frame threads */
+    if (auto_threads &&
+        codec->caps_internal & FF_CODEC_CAP_NESTED_SLICE_THREADS &&
+        codec->capabilities & AV_CODEC_CAP_SLICE_THREADS &&
+        avctx->thread_type & FF_THREAD_SLICE)
+        slice_threads = FFMIN(av_cpu_count() / thread_count, MAX_AUTO_THREADS);
+
     avctx->internal->thread_ctx = fctx = av_mallocz(sizeof(FrameThreadContext));
     if (!fctx)
         return AVERROR(ENOMEM);
@@ -801,6 +813,13 @@ int ff_frame_thread_init(AVCodecContext *avctx)
         copy->internal->thread_ctx = p;
         copy->internal->last_pkt_props = &p->avpkt;
 
+        err = ff_slice_thread_init_nested(copy, slice_threads);
+        if (err < 0) {
+            if (i)
+                copy->priv_data = NULL;
+            goto error;
+        }
+
         if (!i) {
             src = copy;
 
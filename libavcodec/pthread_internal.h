@@ -28,6 +28,13 @@
 int ff_slice_thread_init(AVCodecContext *avctx);
 void ff_slice_thread_free(AVCodecContext *avctx);
 
+/**
+ * Create a pool of slice threads for one frame thread context; execute() and
+ * execute2() called on this context then run their jobs on it.
+ */
+int ff_slice_thread_init_nested(AVCodecContext *avctx, int thread_count);
+void ff_slice_thread_free_nested(AVCodecContext *avctx);
+
 int ff_frame_thread_init(AVCodecContext *avctx);
 void ff_frame_thread_free(AVCodecContext *avctx, int thread_count);
 
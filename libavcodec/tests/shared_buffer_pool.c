@@ -0,0 +1,131 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Share one buffer pool between two decoder contexts and check that they
+ * reuse each other's buffers, that avcodec_close() keeps the reference and
+ * that freeing one context leaves the pool usable by the other.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/buffer.h"
+#include "libavutil/frame.h"
+
+static int dummy_decode(AVCodecContext *avctx, void *data, int *got_frame,
+                        AVPacket *pkt)
+{
+    return AVERROR(ENOSYS);
+}
+
+static AVCodec dummy_decoder = {
+    .name   = "dummy_decoder",
+    .type   = AVMEDIA_TYPE_VIDEO,
+    .id     = AV_CODEC_ID_NONE,
+    .decode = dummy_decode,
+};
+
+static void print_stats(const char *step, AVBufferRef *pool)
+{
+    AVBufferPoolStats st;
+
+    /* the sizes depend on STRIDE_ALIGN, only print how much is cached */
+    av_buffer_shared_pool_get_stats(pool, &st);
+    printf("%-28s hits %2"PRIu64" misses %2"PRIu64" cached %-4s refs %d\n",
+           step, st.hits, st.misses,
+           !st.cached_bytes ? "none" : st.cached_bytes == st.allocated_bytes ? "all" : "some",
+           av_buffer_get_ref_count(pool));
+}
+
+static AVCodecContext *open_context(AVBufferRef *pool)
+{
+    AVCodecContext *avctx = avcodec_alloc_context3(&dummy_decoder);
+
+    if (!avctx)
+        return NULL;
+    avctx->width   = 320;
+    avctx->height  = 240;
+    avctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    if (!(avctx->shared_buffer_pool = av_buffer_ref(pool)) ||
+        avcodec_open2(avctx, &dummy_decoder, NULL) < 0)
+        avcodec_free_context(&avctx);
+    return avctx;
+}
+
+static int get_frame(AVCodecContext *avctx, AVFrame *frame)
+{
+    av_frame_unref(frame);
+    frame->format = avctx->pix_fmt;
+    frame->width  = avctx->width;
+    frame->height = avctx->height;
+    return avcodec_default_get_buffer2(avctx, frame, 0);
+}
+
+int main(void)
+{
+    AVBufferRef *pool = av_buffer_shared_pool_alloc(0);
+    AVCodecContext *avctx[2] = { NULL };
+    AVFrame *frame = av_frame_alloc();
+    int ret = 1;
+
+    if (!pool || !frame)
+        goto end;
+    if (!(avctx[0] = open_context(pool)) || !(avctx[1] = open_context(pool)))
+        goto end;
+    print_stats("opened", pool);
+
+    if (get_frame(avctx[0], frame) < 0)
+        goto end;
+    print_stats("frame from context 0", pool);
+    av_frame_unref(frame);
+    if (get_frame(avctx[1], frame) < 0)
+        goto end;
+    print_stats("frame from context 1", pool);
+
+    /* the frame keeps the pool alive, the context does too after close */
+    avcodec_close(avctx[0]);
+    printf("closed context 0: pool %s\n", avctx[0]->shared_buffer_pool ? "kept" : "lost");
+    if (avcodec_open2(avctx[0], &dummy_decoder, NULL) < 0)
+        goto end;
+    av_frame_unref(frame);
+    if (get_frame(avctx[0], frame) < 0)
+        goto end;
+    print_stats("reopened context 0", pool);
+
+    avcodec_free_context(&avctx[0]);
+    print_stats("freed context 0", pool);
+    av_frame_unref(frame);
+    if (get_frame(avctx[1], frame) < 0)
+        goto end;
+    print_stats("frame from context 1", pool);
+
+    avcodec_free_context(&avctx[1]);
+    print_stats("freed context 1", pool);
+    av_frame_unref(frame);
+    print_stats("released frame", pool);
+    ret = 0;
+
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&avctx[0]);
+    avcodec_free_context(&avctx[1]);
+    av_buffer_unref(&pool);
+    return ret;
+}
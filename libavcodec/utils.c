@@ -1841,6 +1841,11 @@ int ff_thread_can_start_frame(AVCodecContext *avctx)
     return 1;
 }
 
+int ff_slice_thread_count(AVCodecContext *avctx)
+{
+    return 1;
+}
+
 int ff_alloc_entries(AVCodecContext *avctx, int count)
 {
     return 0;
@@ -0,0 +1,314 @@
+;*****************************************************************************
+;* SIMD-optimized HEVC intra prediction
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+cextern pw_1024
+cextern pd_16
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+
+; dst[x] = ((32 - fact) * ref[x] + fact * ref[x + 1] + 16) >> 5
+; m2 = weights, m4 = rounding constant
+%macro INTERP_8 1 ; size
+%if %1 * 2 == mmsize
+    movq          xm0, [srcq]
+    movq          xm1, [srcq + 1]
+    punpcklbw     xm0, xm1
+    pmaddubsw     xm0, xm2
+    pmulhrsw      xm0, xm4
+    packuswb      xm0, xm0
+    movq       [dstq], xm0
+%else
+    movu           m0, [srcq]
+    movu           m1, [srcq + 1]
+    punpckhbw      m3, m0, m1
+    punpcklbw      m0, m1
+    pmaddubsw      m0, m2
+    pmaddubsw      m3, m2
+    pmulhrsw       m0, m4
+    pmulhrsw       m3, m4
+    packuswb       m0, m3
+    movu       [dstq], m0
+%endif
+%endmacro
+
+%macro INTERP_16 1 ; offset
+    movu           m0, [srcq + %1]
+    movu           m1, [srcq + %1 + 2]
+    punpckhwd      m3, m0, m1
+    punpcklwd      m0, m1
+    pmaddwd        m0, m2
+    pmaddwd        m3, m2
+    paddd          m0, m4
+    paddd          m3, m4
+    psrld          m0, 5
+    psrld          m3, 5
+    packusdw       m0, m3
+    movu  [dstq + %1], m0
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_hevc_pred_angular_<size>_<bits>(uint8_t *dst, ptrdiff_t stride,
+;                                         const uint8_t *ref, int angle)
+;
+; Predicts size rows from the reference row, row y starting at
+; ref[((y + 1) * angle >> 5) + 1].
+;-----------------------------------------------------------------------------
+%macro PRED_ANGULAR 2 ; size, bits
+cglobal hevc_pred_angular_%1_%2, 4, 8, 5, dst, stride, ref, angle, pos, src, w, h
+%if %2 == 8
+    mova           m4, [pw_1024]
+%else
+    mova           m4, [pd_16]
+%endif
+    mov          posd, angled
+    mov            hd, %1
+.loop:
+    mov          srcd, posd
+    sar          srcd, 5
+    movsxd       srcq, srcd
+%if %2 == 8
+    lea          srcq, [refq + srcq + 1]
+%else
+    lea          srcq, [refq + srcq * 2 + 2]
+%endif
+    mov            wd, posd
+    and            wd, 31
+    jnz .interp
+
+    ; fact == 0: plain copy, which also avoids reading past the edge
+%if %1 * %2 / 8 < mmsize
+    movq          xm0, [srcq]
+    movq       [dstq], xm0
+%else
+%assign %%i 0
+%rep %1 * %2 / 8 / mmsize
+    movu           m0, [srcq + %%i]
+    movu [dstq + %%i], m0
+%assign %%i %%i + mmsize
+%endrep
+%endif
+    jmp .next
+
+.interp:
+%if %2 == 8
+    imul           wd, 255   ; fact << 8 | (32 - fact)
+    add            wd, 32
+    movd          xm2, wd
+    vpbroadcastw   m2, xm2
+    INTERP_8 %1
+%else
+    imul           wd, 65535 ; fact << 16 | (32 - fact)
+    add            wd, 32
+    movd          xm2, wd
+    vpbroadcastd   m2, xm2
+    INTERP_16 0
+%if %1 * 2 > mmsize
+    INTERP_16 mmsize
+%endif
+%endif
+
+.next:
+    add          dstq, strideq
+    add          posd, angled
+    dec            hd
+    jg .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_hevc_transpose_<bits>(uint8_t *dst, ptrdiff_t stride,
+;                               const uint8_t *src, int size)
+;
+; Transposes the size x size block src, whose rows are size pixels apart,
+; into dst in 8x8 tiles.
+;-----------------------------------------------------------------------------
+%macro TRANSPOSE 1 ; bits
+cglobal hevc_transpose_%1, 4, 12, 16, dst, stride, src, size, sstride, sstride3, stride3, dstp, srcp, col, row, tmp
+    movsxdifnidn  sizeq, sized
+%if %1 == 8
+    mov        sstrideq, sizeq
+%else
+    lea        sstrideq, [sizeq * 2]
+%endif
+    lea       sstride3q, [sstrideq * 3]
+    lea        stride3q, [strideq * 3]
+    mov            rowd, sized
+.loop_row:
+    mov           dstpq, dstq
+    mov           srcpq, srcq
+    mov            cold, sized
+.loop_col:
+    lea            tmpq, [srcpq + sstrideq * 4]
+%if %1 == 8
+    movq             m0, [srcpq]
+    movq             m1, [srcpq + sstrideq]
+    movq             m2, [srcpq + sstrideq * 2]
+    movq             m3, [srcpq + sstride3q]
+    movq             m4, [tmpq]
+    movq             m5, [tmpq + sstrideq]
+    movq             m6, [tmpq + sstrideq * 2]
+    movq             m7, [tmpq + sstride3q]
+    punpcklbw        m8, m0, m1
+    punpcklbw        m9, m2, m3
+    punpcklbw       m10, m4, m5
+    punpcklbw       m11, m6, m7
+    punpcklwd        m0, m8, m9
+    punpckhwd        m1, m8, m9
+    punpcklwd        m2, m10, m11
+    punpckhwd        m3, m10, m11
+    punpckldq        m4, m0, m2
+    punpckhdq        m5, m0, m2
+    punpckldq        m6, m1, m3
+    punpckhdq        m7, m1, m3
+    lea            tmpq, [dstpq + strideq * 4]
+    movq                  [dstpq], m4
+    movhps      [dstpq + strideq], m4
+    movq    [dstpq + strideq * 2], m5
+    movhps     [dstpq + stride3q], m5
+    movq                   [tmpq], m6
+    movhps       [tmpq + strideq], m6
+    movq     [tmpq + strideq * 2], m7
+    movhps      [tmpq + stride3q], m7
+%else
+    movu             m0, [srcpq]
+    movu             m1, [srcpq + sstrideq]
+    movu             m2, [srcpq + sstrideq * 2]
+    movu             m3, [srcpq + sstride3q]
+    movu             m4, [tmpq]
+    movu             m5, [tmpq + sstrideq]
+    movu             m6, [tmpq + sstrideq * 2]
+    movu             m7, [tmpq + sstride3q]
+    TRANSPOSE8x8W     0, 1, 2, 3, 4, 5, 6, 7, 8
+    lea            tmpq, [dstpq + strideq * 4]
+    movu                  [dstpq], m0
+    movu        [dstpq + strideq], m1
+    movu    [dstpq + strideq * 2], m2
+    movu       [dstpq + stride3q], m3
+    movu                   [tmpq], m4
+    movu         [tmpq + strideq], m5
+    movu     [tmpq + strideq * 2], m6
+    movu        [tmpq + stride3q], m7
+%endif
+    add           dstpq, %1 ; 8 pixels
+    lea           srcpq, [srcpq + sstrideq * 8]
+    sub            cold, 8
+    jg .loop_col
+    lea            dstq, [dstq + strideq * 8]
+    add            srcq, %1
+    sub            rowd, 8
+    jg .loop_row
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_hevc_pred_planar_<size>_<bits>(uint8_t *dst, ptrdiff_t stride,
+;                                        const uint8_t *left, const int32_t *c)
+;
+; dst[x] = (c[64 + x] + y * c[32 + x] + c[x] * left[y]) >> (log2(size) + 1)
+;-----------------------------------------------------------------------------
+%macro PRED_PLANAR 3 ; size, bits, shift
+cglobal hevc_pred_planar_%1_%2, 4, 6, 4, dst, stride, left, c, y, l
+    xor            yd, yd
+.loop:
+%if %2 == 8
+    movzx          ld, byte [leftq + yq]
+%else
+    movzx          ld, word [leftq + yq * 2]
+%endif
+    movd          xm2, ld
+    vpbroadcastd   m2, xm2
+    movd          xm3, yd
+    vpbroadcastd   m3, xm3
+%assign %%i 0
+%rep %1 / 8
+    pmulld         m0, m2, [cq + %%i * 32]
+    pmulld         m1, m3, [cq + %%i * 32 + 128]
+    paddd          m0, [cq + %%i * 32 + 256]
+    paddd          m0, m1
+    psrad          m0, %3
+    packusdw       m0, m0
+    vpermq         m0, m0, q0020
+%if %2 == 8
+    packuswb      xm0, xm0
+    movq [dstq + %%i * 8], xm0
+%else
+    movu [dstq + %%i * 16], xm0
+%endif
+%assign %%i %%i + 1
+%endrep
+    add          dstq, strideq
+    inc            yd
+    cmp            yd, %1
+    jl .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_hevc_pred_dc_fill_<size>_<bits>(uint8_t *dst, ptrdiff_t stride, int dc)
+;-----------------------------------------------------------------------------
+%macro PRED_DC_FILL 2 ; size, bits
+cglobal hevc_pred_dc_fill_%1_%2, 3, 4, 1, dst, stride, dc, h
+    movd          xm0, dcd
+%if %2 == 8
+    vpbroadcastb   m0, xm0
+%else
+    vpbroadcastw   m0, xm0
+%endif
+    mov            hd, %1
+.loop:
+%assign %%i 0
+%rep %1 * %2 / 8 / mmsize
+    movu [dstq + %%i], m0
+%assign %%i %%i + mmsize
+%endrep
+    add          dstq, strideq
+    dec            hd
+    jg .loop
+    RET
+%endmacro
+
+INIT_XMM avx2
+PRED_ANGULAR     8,  8
+PRED_ANGULAR    16,  8
+PRED_ANGULAR     8, 16
+TRANSPOSE        8
+TRANSPOSE       16
+PRED_DC_FILL    16,  8
+PRED_DC_FILL     8, 16
+
+INIT_YMM avx2
+PRED_ANGULAR    32,  8
+PRED_ANGULAR    16, 16
+PRED_ANGULAR    32, 16
+PRED_PLANAR      8,  8, 4
+PRED_PLANAR     16,  8, 5
+PRED_PLANAR     32,  8, 6
+PRED_PLANAR      8, 16, 4
+PRED_PLANAR     16, 16, 5
+PRED_PLANAR     32, 16, 6
+PRED_DC_FILL    32,  8
+PRED_DC_FILL    16, 16
+PRED_DC_FILL    32, 16
+
+%endif ; ARCH_X86_64 && HAVE_AVX2_EXTERNAL
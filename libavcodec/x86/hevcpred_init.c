@@ -0,0 +1,283 @@
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/hevcpred.h"
+
+#define PRED_ANGULAR_FUNC(size, bits)                                                   \
+void ff_hevc_pred_angular_ ## size ## _ ## bits ## _avx2(uint8_t *dst, ptrdiff_t stride, \
+                                                        const uint8_t *ref, int angle);
+
+#define PRED_PLANAR_FUNC(size, bits)                                                    \
+void ff_hevc_pred_planar_ ## size ## _ ## bits ## _avx2(uint8_t *dst, ptrdiff_t stride,  \
+                                                       const uint8_t *left, const int32_t *c);
+
+#define PRED_DC_FILL_FUNC(size, bits)                                                   \
+void ff_hevc_pred_dc_fill_ ## size ## _ ## bits ## _avx2(uint8_t *dst, ptrdiff_t stride, int dc);
+
+#define PRED_FUNCS(bits)            \
+    PRED_ANGULAR_FUNC(8,  bits)     \
+    PRED_ANGULAR_FUNC(16, bits)     \
+    PRED_ANGULAR_FUNC(32, bits)     \
+    PRED_PLANAR_FUNC(8,  bits)      \
+    PRED_PLANAR_FUNC(16, bits)      \
+    PRED_PLANAR_FUNC(32, bits)
+
+PRED_FUNCS(8)
+PRED_FUNCS(16)
+PRED_DC_FILL_FUNC(16, 8)
+PRED_DC_FILL_FUNC(32, 8)
+PRED_DC_FILL_FUNC(8,  16)
+PRED_DC_FILL_FUNC(16, 16)
+PRED_DC_FILL_FUNC(32, 16)
+
+void ff_hevc_transpose_8_avx2(uint8_t *dst, ptrdiff_t stride, const uint8_t *src, int size);
+void ff_hevc_transpose_16_avx2(uint8_t *dst, ptrdiff_t stride, const uint8_t *src, int size);
+
+#if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+
+static const int intra_pred_angle[] = {
+     32,  26,  21,  17, 13,  9,  5, 2, 0, -2, -5, -9, -13, -17, -21, -26, -32,
+    -26, -21, -17, -13, -9, -5, -2, 0, 2,  5,  9, 13,  17,  21,  26,  32
+};
+static const int inv_angle[] = {
+    -4096, -1638, -910, -630, -482, -390, -315, -256, -315, -390, -482,
+    -630, -910, -1638, -4096
+};
+
+static av_always_inline int get_pixel(const uint8_t *p, int i, int depth)
+{
+    return depth > 8 ? ((const uint16_t *)p)[i] : p[i];
+}
+
+static av_always_inline void set_pixel(uint8_t *p, int i, int v, int depth)
+{
+    if (depth > 8)
+        ((uint16_t *)p)[i] = v;
+    else
+        p[i] = v;
+}
+
+/*
+ * Same as the C version, except that the modes predicting from the left
+ * edge are predicted into a temporary block, which is then transposed
+ * into the destination.
+ */
+static av_always_inline void pred_angular_avx2(uint8_t *src, const uint8_t *top,
+                                               const uint8_t *left, ptrdiff_t stride,
+                                               int c_idx, int mode, int size, int depth,
+                                               void (*pred)(uint8_t *dst, ptrdiff_t stride,
+                                                            const uint8_t *ref, int angle),
+                                               void (*transpose)(uint8_t *dst, ptrdiff_t stride,
+                                                                 const uint8_t *src, int size))
+{
+    const int ps = depth > 8 ? 2 : 1;
+    int angle = intra_pred_angle[mode - 2];
+    int last  = (size * angle) >> 5;
+    const uint8_t *side  = mode >= 18 ? top : left;
+    const uint8_t *other = mode >= 18 ? left : top;
+    const uint8_t *ref   = side - ps;
+    LOCAL_ALIGNED_32(uint8_t, ref_array, [(3 * 32 + 4) * 2]);
+    LOCAL_ALIGNED_32(uint8_t, tmp, [32 * 32 * 2]);
+    uint8_t *ref_tmp = ref_array + size * ps;
+    int x, y;
+
+    if (angle < 0 && last < -1) {
+        memcpy(ref_tmp, side - ps, (size + 1) * ps);
+        for (x = last; x <= -1; x++)
+            set_pixel(ref_tmp, x,
+                      get_pixel(other, -1 + ((x * inv_angle[mode - 11] + 128) >> 8), depth),
+                      depth);
+        ref = ref_tmp;
+    }
+
+    if (mode >= 18) {
+        pred(src, stride * ps, ref, angle);
+
+        if (mode == 26 && c_idx == 0 && size < 32) {
+            for (y = 0; y < size; y++)
+                set_pixel(src, y * stride,
+                          av_clip_uintp2(get_pixel(top, 0, depth) +
+                                         ((get_pixel(left, y, depth) -
+                                           get_pixel(left, -1, depth)) >> 1), depth),
+                          depth);
+        }
+    } else {
+        pred(tmp, size * ps, ref, angle);
+        transpose(src, stride * ps, tmp, size);
+
+        if (mode == 10 && c_idx == 0 && size < 32) {
+            for (x = 0; x < size; x++)
+                set_pixel(src, x,
+                          av_clip_uintp2(get_pixel(left, 0, depth) +
+                                         ((get_pixel(top, x, depth) -
+                                           get_pixel(top, -1, depth)) >> 1), depth),
+                          depth);
+        }
+    }
+}
+
+#define PRED_ANGULAR(log2_size, size, depth, bits)                                  \
+static void pred_angular_ ## log2_size ## _ ## depth ## _avx2(uint8_t *src,         \
+                                                             const uint8_t *top,    \
+                                                             const uint8_t *left,   \
+                                                             ptrdiff_t stride,      \
+                                                             int c_idx, int mode)   \
+{                                                                                   \
+    pred_angular_avx2(src, top, left, stride, c_idx, mode, size, depth,             \
+                      ff_hevc_pred_angular_ ## size ## _ ## bits ## _avx2,          \
+                      ff_hevc_transpose_ ## bits ## _avx2);                         \
+}
+
+#define PRED_ANGULAR_DEPTH(depth, bits)     \
+    PRED_ANGULAR(1,  8, depth, bits)        \
+    PRED_ANGULAR(2, 16, depth, bits)        \
+    PRED_ANGULAR(3, 32, depth, bits)
+
+PRED_ANGULAR_DEPTH(8,  8)
+PRED_ANGULAR_DEPTH(9,  16)
+PRED_ANGULAR_DEPTH(10, 16)
+PRED_ANGULAR_DEPTH(12, 16)
+
+static av_always_inline void pred_planar_avx2(uint8_t *src, const uint8_t *top,
+                                              const uint8_t *left, ptrdiff_t stride,
+                                              int log2_size, int depth,
+                                              void (*pred)(uint8_t *dst, ptrdiff_t stride,
+                                                           const uint8_t *left,
+                                                           const int32_t *c))
+{
+    const int ps = depth > 8 ? 2 : 1;
+    int size  = 1 << log2_size;
+    int top_size  = get_pixel(top, size, depth);
+    int left_size = get_pixel(left, size, depth);
+    /* per column: the weight of left[y], the increment per row and the
+     * value for row 0 without the left[y] term */
+    LOCAL_ALIGNED_32(int32_t, c, [3 * 32]);
+    int x;
+
+    for (x = 0; x < size; x++) {
+        int t = get_pixel(top, x, depth);
+        c[x]      = size - 1 - x;
+        c[32 + x] = left_size - t;
+        c[64 + x] = (x + 1) * top_size + (size - 1) * t + left_size + size;
+    }
+
+    pred(src, stride * ps, left, c);
+}
+
+#define PRED_PLANAR(log2_size, size, depth, bits)                                   \
+static void pred_planar_ ## log2_size ## _ ## depth ## _avx2(uint8_t *src,          \
+                                                            const uint8_t *top,     \
+                                                            const uint8_t *left,    \
+                                                            ptrdiff_t stride)       \
+{                                                                                   \
+    pred_planar_avx2(src, top, left, stride, log2_size + 2, depth,                  \
+                     ff_hevc_pred_planar_ ## size ## _ ## bits ## _avx2);           \
+}
+
+#define PRED_PLANAR_DEPTH(depth, bits)      \
+    PRED_PLANAR(1,  8, depth, bits)         \
+    PRED_PLANAR(2, 16, depth, bits)         \
+    PRED_PLANAR(3, 32, depth, bits)
+
+PRED_PLANAR_DEPTH(8,  8)
+PRED_PLANAR_DEPTH(9,  16)
+PRED_PLANAR_DEPTH(10, 16)
+PRED_PLANAR_DEPTH(12, 16)
+
+static av_always_inline void pred_dc_avx2(uint8_t *src, const uint8_t *top,
+                                          const uint8_t *left, ptrdiff_t stride,
+                                          int log2_size, int c_idx, int depth)
+{
+    const int ps = depth > 8 ? 2 : 1;
+    int size = 1 << log2_size;
+    int dc   = size;
+    int i, x, y;
+
+    for (i = 0; i < size; i++)
+        dc += get_pixel(left, i, depth) + get_pixel(top, i, depth);
+    dc >>= log2_size + 1;
+
+    if (size * ps == 4) {
+        uint32_t a = dc * 0x01010101U;
+        for (y = 0; y < size; y++)
+            AV_WN32(src + y * stride, a);
+    } else if (size * ps == 8) {
+        uint64_t a = dc * (depth > 8 ? 0x0001000100010001ULL : 0x0101010101010101ULL);
+        for (y = 0; y < size; y++)
+            AV_WN64(src + y * stride * ps, a);
+    } else if (depth > 8) {
+        if (size == 8)
+            ff_hevc_pred_dc_fill_8_16_avx2(src, stride * ps, dc);
+        else if (size == 16)
+            ff_hevc_pred_dc_fill_16_16_avx2(src, stride * ps, dc);
+        else
+            ff_hevc_pred_dc_fill_32_16_avx2(src, stride * ps, dc);
+    } else {
+        if (size == 16)
+            ff_hevc_pred_dc_fill_16_8_avx2(src, stride, dc);
+        else
+            ff_hevc_pred_dc_fill_32_8_avx2(src, stride, dc);
+    }
+
+    if (c_idx == 0 && size < 32) {
+        set_pixel(src, 0, (get_pixel(left, 0, depth) + 2 * dc + get_pixel(top, 0, depth) + 2) >> 2, depth);
+        for (x = 1; x < size; x++)
+            set_pixel(src, x, (get_pixel(top, x, depth) + 3 * dc + 2) >> 2, depth);
+        for (y = 1; y < size; y++)
+            set_pixel(src, y * stride, (get_pixel(left, y, depth) + 3 * dc + 2) >> 2, depth);
+    }
+}
+
+#define PRED_DC(depth)                                                              \
+static void pred_dc_ ## depth ## _avx2(uint8_t *src, const uint8_t *top,            \
+                                       const uint8_t *left, ptrdiff_t stride,       \
+                                       int log2_size, int c_idx)                    \
+{                                                                                   \
+    pred_dc_avx2(src, top, left, stride, log2_size, c_idx, depth);                  \
+}
+
+PRED_DC(8)
+PRED_DC(9)
+PRED_DC(10)
+PRED_DC(12)
+
+#endif /* ARCH_X86_64 && HAVE_AVX2_EXTERNAL */
+
+av_cold void ff_hevc_pred_init_x86(HEVCPredContext *hpc, int bit_depth)
+{
+#if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+    int cpu_flags = av_get_cpu_flags();
+
+#define SET_PRED(depth)                                                 \
+    hpc->pred_planar[1]  = pred_planar_1_ ## depth ## _avx2;            \
+    hpc->pred_planar[2]  = pred_planar_2_ ## depth ## _avx2;            \
+    hpc->pred_planar[3]  = pred_planar_3_ ## depth ## _avx2;            \
+    hpc->pred_dc         = pred_dc_ ## depth ## _avx2;                  \
+    hpc->pred_angular[1] = pred_angular_1_ ## depth ## _avx2;           \
+    hpc->pred_angular[2] = pred_angular_2_ ## depth ## _avx2;           \
+    hpc->pred_angular[3] = pred_angular_3_ ## depth ## _avx2;
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        switch (bit_depth) {
+        case 8:
+            SET_PRED(8);
+            break;
+        case 9:
+            SET_PRED(9);
+            break;
+        case 10:
+            SET_PRED(10);
+            break;
+        case 12:
+            SET_PRED(12);
+            break;
+        }
+    }
+#endif
+}
@@ -149,14 +149,110 @@ static void lpc_compute_autocorr_sse2(const double *data, int len, int lag,
 
 #endif /* HAVE_SSE2_INLINE */
 
+#if HAVE_AVX_INLINE
+
+static void lpc_compute_autocorr_avx(const double *data, int len, int lag,
+                                     double *autoc)
+{
+    /* four products per iteration, the last len % 4 ones are added in C
+     * since the samples after len are not guaranteed to be zero */
+    int len4 = len & ~3;
+    int i, j;
+
+    for (j = 0; j < lag; j += 2) {
+        double sum[4] = { 0.0 };
+        int last = j == lag - 2;
+
+        if (len4) {
+            x86_reg k = -len4 * sizeof(double);
+            if (last) {
+                __asm__ volatile(
+                    "vxorpd        %%ymm0,  %%ymm0,  %%ymm0 \n\t"
+                    "vxorpd        %%ymm1,  %%ymm1,  %%ymm1 \n\t"
+                    "vxorpd        %%ymm2,  %%ymm2,  %%ymm2 \n\t"
+                    "1:                                     \n\t"
+                    "vmovupd      (%2,%0),  %%ymm3          \n\t"
+                    "vmulpd       (%3,%0),  %%ymm3,  %%ymm4 \n\t"
+                    "vmulpd     -8(%3,%0),  %%ymm3,  %%ymm5 \n\t"
+                    "vmulpd    -16(%3,%0),  %%ymm3,  %%ymm3 \n\t"
+                    "vaddpd        %%ymm4,  %%ymm0,  %%ymm0 \n\t"
+                    "vaddpd        %%ymm5,  %%ymm1,  %%ymm1 \n\t"
+                    "vaddpd        %%ymm3,  %%ymm2,  %%ymm2 \n\t"
+                    "add           $32,     %0              \n\t"
+                    "jl 1b                                  \n\t"
+                    "vextractf128  $1, %%ymm0,  %%xmm3      \n\t"
+                    "vextractf128  $1, %%ymm1,  %%xmm4      \n\t"
+                    "vextractf128  $1, %%ymm2,  %%xmm5      \n\t"
+                    "vaddpd        %%xmm3,  %%xmm0,  %%xmm0 \n\t"
+                    "vaddpd        %%xmm4,  %%xmm1,  %%xmm1 \n\t"
+                    "vaddpd        %%xmm5,  %%xmm2,  %%xmm2 \n\t"
+                    "vhaddpd       %%xmm1,  %%xmm0,  %%xmm0 \n\t"
+                    "vhaddpd       %%xmm2,  %%xmm2,  %%xmm2 \n\t"
+                    "vmovupd       %%xmm0,   (%1)           \n\t"
+                    "vmovsd        %%xmm2, 16(%1)           \n\t"
+                    "vzeroupper                             \n\t"
+                    :"+&r"(k)
+                    :"r"(sum), "r"(data + len4), "r"(data + len4 - j)
+                    :"memory"
+                     XMM_CLOBBERS(, "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5")
+                );
+            } else {
+                __asm__ volatile(
+                    "vxorpd        %%ymm0,  %%ymm0,  %%ymm0 \n\t"
+                    "vxorpd        %%ymm1,  %%ymm1,  %%ymm1 \n\t"
+                    "1:                                     \n\t"
+                    "vmovupd      (%2,%0),  %%ymm3          \n\t"
+                    "vmulpd     -8(%3,%0),  %%ymm3,  %%ymm4 \n\t"
+                    "vmulpd       (%3,%0),  %%ymm3,  %%ymm3 \n\t"
+                    "vaddpd        %%ymm4,  %%ymm1,  %%ymm1 \n\t"
+                    "vaddpd        %%ymm3,  %%ymm0,  %%ymm0 \n\t"
+                    "add           $32,     %0              \n\t"
+                    "jl 1b                                  \n\t"
+                    "vextractf128  $1, %%ymm0,  %%xmm3      \n\t"
+                    "vextractf128  $1, %%ymm1,  %%xmm4      \n\t"
+                    "vaddpd        %%xmm3,  %%xmm0,  %%xmm0 \n\t"
+                    "vaddpd        %%xmm4,  %%xmm1,  %%xmm1 \n\t"
+                    "vhaddpd       %%xmm1,  %%xmm0,  %%xmm0 \n\t"
+                    "vmovupd       %%xmm0,   (%1)           \n\t"
+                    "vzeroupper                             \n\t"
+                    :"+&r"(k)
+                    :"r"(sum), "r"(data + len4), "r"(data + len4 - j)
+                    :"memory"
+                     XMM_CLOBBERS(, "%xmm0", "%xmm1", "%xmm3", "%xmm4")
+                );
+            }
+        }
+
+        for (i = len4; i < len; i++) {
+            sum[0] += data[i] * data[i - j];
+            sum[1] += data[i] * data[i - j - 1];
+            if (last)
+                sum[2] += data[i] * data[i - j - 2];
+        }
+
+        autoc[j    ] = 1.0 + sum[0];
+        autoc[j + 1] = 1.0 + sum[1];
+        if (last)
+            autoc[j + 2] = 1.0 + sum[2];
+    }
+}
+
+#endif /* HAVE_AVX_INLINE */
+
 av_cold void ff_lpc_init_x86(LPCContext *c)
 {
-#if HAVE_SSE2_INLINE
+#if HAVE_INLINE_ASM
     int cpu_flags = av_get_cpu_flags();
 
+#if HAVE_SSE2_INLINE
     if (INLINE_SSE2(cpu_flags) || INLINE_SSE2_SLOW(cpu_flags)) {
         c->lpc_apply_welch_window = lpc_apply_welch_window_sse2;
         c->lpc_compute_autocorr   = lpc_compute_autocorr_sse2;
     }
 #endif /* HAVE_SSE2_INLINE */
+#if HAVE_AVX_INLINE
+    if (INLINE_AVX_FAST(cpu_flags))
+        c->lpc_compute_autocorr = lpc_compute_autocorr_avx;
+#endif /* HAVE_AVX_INLINE */
+#endif /* HAVE_INLINE_ASM */
 }
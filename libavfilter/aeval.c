@@ -271,11 +271,15 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_samplerates(ctx, formats);
 }
 
+#define SAMPLE_CHUNK 256
+
 static int request_frame(AVFilterLink *outlink)
 {
     EvalContext *eval = outlink->src->priv;
     AVFrame *samplesref;
-    int i, j;
+    double ns[SAMPLE_CHUNK], ts[SAMPLE_CHUNK];
+    const double *arrays[VAR_VARS_NB] = { NULL };
+    int i, j, k, n;
     int64_t t = av_rescale(eval->n, AV_TIME_BASE, eval->sample_rate);
     int nb_samples;
 
@@ -292,16 +296,20 @@ static int request_frame(AVFilterLink *outlink)
     samplesref = ff_get_audio_buffer(outlink, nb_samples);
     if (!samplesref)
         return AVERROR(ENOMEM);
-
-    /* evaluate expression for each single sample and for each channel */
-    for (i = 0; i < nb_samples; i++, eval->n++) {
-        eval->var_values[VAR_N] = eval->n;
-        eval->var_values[VAR_T] = eval->var_values[VAR_N] * (double)1/eval->sample_rate;
-
-        for (j = 0; j < eval->nb_channels; j++) {
-            *((double *) samplesref->extended_data[j] + i) =
-                av_expr_eval(eval->expr[j], eval->var_values, NULL);
+    arrays[VAR_N] = ns;
+    arrays[VAR_T] = ts;
+
+    /* evaluate expression for blocks of samples and for each channel */
+    for (i = 0; i < nb_samples; i += n) {
+        n = FFMIN(nb_samples - i, SAMPLE_CHUNK);
+        for (k = 0; k < n; k++, eval->n++) {
+            ns[k] = eval->n;
+            ts[k] = ns[k] * (double)1/eval->sample_rate;
         }
+
+        for (j = 0; j < eval->nb_channels; j++)
+            av_expr_eval_array(eval->expr[j], (double *)samplesref->extended_data[j] + i,
+                               n, eval->var_values, arrays, NULL);
     }
 
     samplesref->pts = eval->pts;
@@ -70,6 +70,10 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
         }
     }
 
+    if (link->graph && link->graph->shared_buffer_pool &&
+        ff_frame_pool_set_shared(link->frame_pool, link->graph->shared_buffer_pool) < 0)
+        return NULL;
+
     frame = ff_frame_pool_get(link->frame_pool);
     if (!frame)
         return NULL;
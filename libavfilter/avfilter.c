@@ -192,6 +192,10 @@ int avfilter_link_get_channels(AVFilterLink *link)
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
+    if (filter->graph && filter->graph->internal->sched_running) {
+        ff_graph_sched_set_ready(filter, priority);
+        return;
+    }
     filter->ready = FFMAX(filter->ready, priority);
 }
 
@@ -550,7 +554,8 @@ void ff_update_link_current_pts(AVFilterLink *link, int64_t pts)
     link->current_pts = pts;
     link->current_pts_us = av_rescale_q(pts, link->time_base, AV_TIME_BASE_Q);
     /* TODO use duration */
-    if (link->graph && link->age_index >= 0)
+    if (link->graph && link->age_index >= 0 &&
+        !link->graph->internal->sched_running)
         ff_avfilter_graph_update_heap(link->graph, link);
 }
 
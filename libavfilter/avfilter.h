@@ -332,6 +332,17 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Activate the filters of a graph one at a time, highest priority first.
+ */
+#define AVFILTER_SCHEDULER_SERIAL   0
+/**
+ * Activate independent filters (e.g. the branches after a split)
+ * concurrently, using a pool of AVFilterGraph.nb_threads threads. The frames on each link are
+ * produced and consumed in the same order as with the serial scheduler.
+ */
+#define AVFILTER_SCHEDULER_PARALLEL 1
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
@@ -907,6 +918,28 @@ typedef struct AVFilterGraph {
     int sink_links_count;
 
     unsigned disable_auto_convert;
+
+    /**
+     * Scheduler used to activate the filters of this graph, one of the
+     * AVFILTER_SCHEDULER_* constants. Must be set before
+     * avfilter_graph_config().
+     *
+     * With AVFILTER_SCHEDULER_PARALLEL, the execute callback may be called
+     * concurrently from several threads.
+     *
+     * Access through AVOptions ("scheduler").
+     */
+    int scheduler;
+
+    /**
+     * A reference to a shared buffer pool allocated with
+     * av_buffer_shared_pool_alloc(). When set, the default frame allocators
+     * of the filter links take their buffers from it instead of per-link
+     * pools. May be set by the caller at any time before the frames are
+     * allocated; the reference is owned by the graph and unreffed in
+     * avfilter_graph_free().
+     */
+    AVBufferRef *shared_buffer_pool;
 } AVFilterGraph;
 
 /**
@@ -56,6 +56,10 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
+    { "scheduler",   "Filter activation scheduler", OFFSET(scheduler),
+        AV_OPT_TYPE_INT,   { .i64 = AVFILTER_SCHEDULER_SERIAL }, 0, INT_MAX, F|V|A, "scheduler" },
+        { "serial",   NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_SCHEDULER_SERIAL   }, .flags = F|V|A, .unit = "scheduler" },
+        { "parallel", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_SCHEDULER_PARALLEL }, .flags = F|V|A, .unit = "scheduler" },
     { NULL },
 };
 
@@ -78,6 +82,25 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_sched_init(AVFilterGraph *graph)
+{
+    graph->scheduler = AVFILTER_SCHEDULER_SERIAL;
+    return 0;
+}
+
+void ff_graph_sched_free(AVFilterGraph *graph)
+{
+}
+
+int ff_graph_sched_run_once(AVFilterGraph *graph)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_graph_sched_set_ready(AVFilterContext *filter, unsigned priority)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -125,9 +148,11 @@ void avfilter_graph_free(AVFilterGraph **graph)
     while ((*graph)->nb_filters)
         avfilter_free((*graph)->filters[0]);
 
+    ff_graph_sched_free(*graph);
     ff_graph_thread_free(*graph);
 
     av_freep(&(*graph)->sink_links);
+    av_buffer_unref(&(*graph)->shared_buffer_pool);
 
     av_freep(&(*graph)->scale_sws_opts);
     av_freep(&(*graph)->aresample_swr_opts);
@@ -1280,6 +1305,8 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_graph_sched_init(graphctx)) < 0)
+        return ret;
 
     return 0;
 }
@@ -1445,6 +1472,8 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    if (graph->internal->sched)
+        return ff_graph_sched_run_once(graph);
     filter = graph->filters[0];
     for (i = 1; i < graph->nb_filters; i++)
         if (graph->filters[i]->ready > filter->ready)
@@ -24,8 +24,10 @@
  */
 
 #include "dnn_backend_native.h"
+#include "dnn_native_dsp.h"
 #include "dnn_srcnn.h"
 #include "dnn_espcn.h"
+#include "internal.h"
 #include "libavformat/avio.h"
 
 typedef enum {INPUT, CONV, DEPTH_TO_SPACE} LayerType;
@@ -43,6 +45,9 @@ typedef struct ConvolutionalParams{
     ActivationFunc activation;
     float *kernel;
     float *biases;
+    // kernel reordered to [kernel_y][kernel_x][input][output] for
+    // conv_accumulate(), NULL if output_num is not a multiple of 8
+    float *kernel_t;
 } ConvolutionalParams;
 
 typedef struct InputParams{
@@ -57,8 +62,32 @@ typedef struct DepthToSpaceParams{
 typedef struct ConvolutionalNetwork{
     Layer *layers;
     int32_t layers_num;
+    DNNNativeDSPContext dsp;
 } ConvolutionalNetwork;
 
+static DNNReturnType reorder_conv_kernel(ConvolutionalParams *conv_params)
+{
+    int filter_size = conv_params->kernel_size * conv_params->kernel_size * conv_params->input_num;
+    int n_filter, i;
+
+    if (conv_params->output_num % 8){
+        conv_params->kernel_t = NULL;
+        return DNN_SUCCESS;
+    }
+    conv_params->kernel_t = av_malloc_array(filter_size * conv_params->output_num, sizeof(float));
+    if (!conv_params->kernel_t){
+        return DNN_ERROR;
+    }
+    for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
+        for (i = 0; i < filter_size; ++i){
+            conv_params->kernel_t[i * conv_params->output_num + n_filter] =
+                conv_params->kernel[n_filter * filter_size + i];
+        }
+    }
+
+    return DNN_SUCCESS;
+}
+
 static DNNReturnType set_input_output_native(void *model, DNNData *input, DNNData *output)
 {
     ConvolutionalNetwork *network = (ConvolutionalNetwork *)model;
@@ -156,6 +185,8 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
         return NULL;
     }
     model->model = (void *)network;
+    model->filter_ctx = NULL;
+    ff_dnn_native_dsp_init(&network->dsp);
 
     network->layers_num = 1 + (int32_t)avio_rl32(model_file_context);
     dnn_size = 4;
@@ -206,6 +237,9 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
             }
             conv_params->kernel = av_malloc(kernel_size * sizeof(float));
             conv_params->biases = av_malloc(conv_params->output_num * sizeof(float));
+            conv_params->kernel_t = NULL;
+            network->layers[layer].type = CONV;
+            network->layers[layer].params = conv_params;
             if (!conv_params->kernel || !conv_params->biases){
                 avio_closep(&model_file_context);
                 ff_dnn_free_model_native(&model);
@@ -217,8 +251,11 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
             for (i = 0; i < conv_params->output_num; ++i){
                 conv_params->biases[i] = av_int2float(avio_rl32(model_file_context));
             }
-            network->layers[layer].type = CONV;
-            network->layers[layer].params = conv_params;
+            if (reorder_conv_kernel(conv_params) != DNN_SUCCESS){
+                avio_closep(&model_file_context);
+                ff_dnn_free_model_native(&model);
+                return NULL;
+            }
             break;
         case DEPTH_TO_SPACE:
             depth_to_space_params = av_malloc(sizeof(DepthToSpaceParams));
@@ -276,6 +313,12 @@ static int set_up_conv_layer(Layer *layer, const float *kernel, const float *bia
     }
     memcpy(conv_params->kernel, kernel, kernel_size * sizeof(float));
     memcpy(conv_params->biases, biases, output_num * sizeof(float));
+    if (reorder_conv_kernel(conv_params) != DNN_SUCCESS){
+        av_freep(&conv_params->kernel);
+        av_freep(&conv_params->biases);
+        av_freep(&conv_params);
+        return DNN_ERROR;
+    }
     layer->type = CONV;
     layer->params = conv_params;
 
@@ -300,6 +343,8 @@ DNNModel *ff_dnn_load_default_model_native(DNNDefaultModel model_type)
         return NULL;
     }
     model->model = (void *)network;
+    model->filter_ctx = NULL;
+    ff_dnn_native_dsp_init(&network->dsp);
 
     switch (model_type){
     case DNN_SRCNN:
@@ -365,28 +410,69 @@ DNNModel *ff_dnn_load_default_model_native(DNNDefaultModel model_type)
 
 #define CLAMP_TO_EDGE(x, w) ((x) < 0 ? 0 : ((x) >= (w) ? (w - 1) : (x)))
 
-static void convolve(const float *input, float *output, const ConvolutionalParams *conv_params, int width, int height)
+typedef struct ThreadData{
+    const float *input;
+    float *output;
+    const DNNNativeDSPContext *dsp;
+    const ConvolutionalParams *conv_params;
+    int block_size;
+    int width, height, channels;
+} ThreadData;
+
+static int convolve(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int y, x, n_filter, ch, kernel_y, kernel_x;
+    const ThreadData *td = arg;
+    const ConvolutionalParams *conv_params = td->conv_params;
+    const DNNNativeDSPContext *dsp = td->dsp;
+    const int width = td->width, height = td->height;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+    int y, x, n_filter, kernel_y, kernel_x;
     int radius = conv_params->kernel_size >> 1;
     int src_linesize = width * conv_params->input_num;
     int filter_linesize = conv_params->kernel_size * conv_params->input_num;
     int filter_size = conv_params->kernel_size * filter_linesize;
+    float *output = td->output + slice_start * width * conv_params->output_num;
 
-    for (y = 0; y < height; ++y){
+    for (y = slice_start; y < slice_end; ++y){
         for (x = 0; x < width; ++x){
-            for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
-                output[n_filter] = conv_params->biases[n_filter];
-                for (ch = 0; ch < conv_params->input_num; ++ch){
-                    for (kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y){
-                        for (kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x){
-                            output[n_filter] += input[CLAMP_TO_EDGE(y + kernel_y - radius, height) * src_linesize +
-                                                      CLAMP_TO_EDGE(x + kernel_x - radius, width) * conv_params->input_num + ch] *
-                                                conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
-                                                                    kernel_x * conv_params->input_num + ch];
+            // the whole kernel row is inside the picture, so its inputs are contiguous
+            int inside = x - radius >= 0 && x - radius + conv_params->kernel_size <= width;
+
+            memcpy(output, conv_params->biases, conv_params->output_num * sizeof(*output));
+            for (kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y){
+                const float *src_row = td->input + CLAMP_TO_EDGE(y + kernel_y - radius, height) * src_linesize;
+                if (inside){
+                    const float *src = src_row + (x - radius) * conv_params->input_num;
+                    if (conv_params->kernel_t){
+                        dsp->conv_accumulate(output, src, conv_params->kernel_t + kernel_y * filter_linesize * conv_params->output_num,
+                                             filter_linesize, conv_params->output_num);
+                    }
+                    else{
+                        for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
+                            output[n_filter] += dsp->dot_product(src, conv_params->kernel + n_filter * filter_size +
+                                                                 kernel_y * filter_linesize, filter_linesize);
+                        }
+                    }
+                    continue;
+                }
+                for (kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x){
+                    const float *src = src_row + CLAMP_TO_EDGE(x + kernel_x - radius, width) * conv_params->input_num;
+                    if (conv_params->kernel_t){
+                        dsp->conv_accumulate(output, src, conv_params->kernel_t +
+                                             (kernel_y * filter_linesize + kernel_x * conv_params->input_num) * conv_params->output_num,
+                                             conv_params->input_num, conv_params->output_num);
+                    }
+                    else{
+                        for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
+                            output[n_filter] += dsp->dot_product(src, conv_params->kernel + n_filter * filter_size +
+                                                                 kernel_y * filter_linesize + kernel_x * conv_params->input_num,
+                                                                 conv_params->input_num);
                         }
                     }
                 }
+            }
+            for (n_filter = 0; n_filter < conv_params->output_num; ++n_filter){
                 switch (conv_params->activation){
                 case RELU:
                     output[n_filter] = FFMAX(output[n_filter], 0.0);
@@ -401,29 +487,54 @@ static void convolve(const float *input, float *output, const ConvolutionalParam
             output += conv_params->output_num;
         }
     }
+
+    return 0;
 }
 
-static void depth_to_space(const float *input, float *output, int block_size, int width, int height, int channels)
+static int depth_to_space(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int y, x, by, bx, ch;
-    int new_channels = channels / (block_size * block_size);
-    int output_linesize = width * channels;
+    const ThreadData *td = arg;
+    const int block_size = td->block_size;
+    const int slice_start = (td->height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (td->height * (jobnr + 1)) / nb_jobs;
+    int y, x, by, i;
+    int new_channels = td->channels / (block_size * block_size);
+    int output_linesize = td->width * td->channels;
     int by_linesize = output_linesize / block_size;
+    // each input pixel holds block_size runs of x_linesize output values
     int x_linesize = new_channels * block_size;
-
-    for (y = 0; y < height; ++y){
-        for (x = 0; x < width; ++x){
-            for (by = 0; by < block_size; ++by){
-                for (bx = 0; bx < block_size; ++bx){
-                    for (ch = 0; ch < new_channels; ++ch){
-                        output[by * by_linesize + x * x_linesize + bx * new_channels + ch] = input[ch];
-                    }
-                    input += new_channels;
+    const float *input = td->input + slice_start * output_linesize;
+    float *output = td->output + slice_start * output_linesize;
+
+    for (y = slice_start; y < slice_end; ++y){
+        for (by = 0; by < block_size; ++by){
+            const float *src = input + by * x_linesize;
+            float *dst = output + by * by_linesize;
+            for (x = 0; x < td->width; ++x){
+                for (i = 0; i < x_linesize; ++i){
+                    dst[i] = src[i];
                 }
+                src += td->channels;
+                dst += x_linesize;
             }
         }
+        input += output_linesize;
         output += output_linesize;
     }
+
+    return 0;
+}
+
+static void execute_layer(const DNNModel *model, avfilter_action_func *func, ThreadData *td)
+{
+    AVFilterContext *ctx = model->filter_ctx;
+
+    if (ctx){
+        ctx->internal->execute(ctx, func, td, NULL, FFMIN(td->height, ff_filter_get_nb_threads(ctx)));
+    }
+    else{
+        func(NULL, td, 0, 1);
+    }
 }
 
 DNNReturnType ff_dnn_execute_model_native(const DNNModel *model)
@@ -434,6 +545,7 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model)
     InputParams *input_params;
     ConvolutionalParams *conv_params;
     DepthToSpaceParams *depth_to_space_params;
+    ThreadData td;
 
     if (network->layers_num <= 0 || network->layers[0].type != INPUT || !network->layers[0].output){
         return DNN_ERROR;
@@ -445,20 +557,27 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model)
         cur_channels = input_params->channels;
     }
 
+    td.dsp = &network->dsp;
     for (layer = 1; layer < network->layers_num; ++layer){
         if (!network->layers[layer].output){
             return DNN_ERROR;
         }
+        td.input = network->layers[layer - 1].output;
+        td.output = network->layers[layer].output;
+        td.width = cur_width;
+        td.height = cur_height;
+        td.channels = cur_channels;
         switch (network->layers[layer].type){
         case CONV:
             conv_params = (ConvolutionalParams *)network->layers[layer].params;
-            convolve(network->layers[layer - 1].output, network->layers[layer].output, conv_params, cur_width, cur_height);
+            td.conv_params = conv_params;
+            execute_layer(model, convolve, &td);
             cur_channels = conv_params->output_num;
             break;
         case DEPTH_TO_SPACE:
             depth_to_space_params = (DepthToSpaceParams *)network->layers[layer].params;
-            depth_to_space(network->layers[layer - 1].output, network->layers[layer].output,
-                           depth_to_space_params->block_size, cur_width, cur_height, cur_channels);
+            td.block_size = depth_to_space_params->block_size;
+            execute_layer(model, depth_to_space, &td);
             cur_height *= depth_to_space_params->block_size;
             cur_width *= depth_to_space_params->block_size;
             cur_channels /= depth_to_space_params->block_size * depth_to_space_params->block_size;
@@ -486,6 +605,7 @@ void ff_dnn_free_model_native(DNNModel **model)
                 conv_params = (ConvolutionalParams *)network->layers[layer].params;
                 av_freep(&conv_params->kernel);
                 av_freep(&conv_params->biases);
+                av_freep(&conv_params->kernel_t);
             }
             av_freep(&network->layers[layer].params);
         }
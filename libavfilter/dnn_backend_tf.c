@@ -198,6 +198,7 @@ DNNModel *ff_dnn_load_model_tf(const char *model_filename)
     }
 
     model->model = (void *)tf_model;
+    model->filter_ctx = NULL;
     model->set_input_output = &set_input_output_tf;
 
     return model;
@@ -524,6 +525,7 @@ DNNModel *ff_dnn_load_default_model_tf(DNNDefaultModel model_type)
     }
 
     model->model = (void *)tf_model;
+    model->filter_ctx = NULL;
     model->set_input_output = &set_input_output_tf;
 
     return model;
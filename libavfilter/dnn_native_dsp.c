@@ -0,0 +1,53 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "dnn_native_dsp.h"
+
+static void conv_accumulate_c(float *dst, const float *src, const float *kernel,
+                              int src_len, int dst_len)
+{
+    int i, n;
+
+    for (i = 0; i < src_len; i++) {
+        for (n = 0; n < dst_len; n++)
+            dst[n] += src[i] * kernel[n];
+        kernel += dst_len;
+    }
+}
+
+static float dot_product_c(const float *a, const float *b, int len)
+{
+    float sum = 0.0f;
+    int i;
+
+    for (i = 0; i < len; i++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+av_cold void ff_dnn_native_dsp_init(DNNNativeDSPContext *dsp)
+{
+    dsp->conv_accumulate = conv_accumulate_c;
+    dsp->dot_product     = dot_product_c;
+
+    if (ARCH_X86)
+        ff_dnn_native_dsp_init_x86(dsp);
+}
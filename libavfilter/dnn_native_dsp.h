@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_DNN_NATIVE_DSP_H
+#define AVFILTER_DNN_NATIVE_DSP_H
+
+typedef struct DNNNativeDSPContext {
+    /**
+     * Accumulate a vector-matrix product into dst:
+     * dst[n] += sum(src[i] * kernel[i * dst_len + n]) for 0 <= i < src_len
+     * and 0 <= n < dst_len.
+     * src_len must be positive and dst_len a multiple of 8.
+     */
+    void (*conv_accumulate)(float *dst, const float *src, const float *kernel,
+                            int src_len, int dst_len);
+
+    /**
+     * Return sum(a[i] * b[i]) for 0 <= i < len.
+     */
+    float (*dot_product)(const float *a, const float *b, int len);
+} DNNNativeDSPContext;
+
+void ff_dnn_native_dsp_init(DNNNativeDSPContext *dsp);
+void ff_dnn_native_dsp_init_x86(DNNNativeDSPContext *dsp);
+
+#endif /* AVFILTER_DNN_NATIVE_DSP_H */
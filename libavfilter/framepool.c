@@ -45,6 +45,10 @@ struct FFFramePool {
     int align;
     int linesize[4];
     AVBufferPool *pools[4];
+    int pool_size[4];
+
+    /* shared pool the buffers are taken from instead of pools, if set */
+    AVBufferRef *shared;
 
 };
 
@@ -96,14 +100,15 @@ FFFramePool *ff_frame_pool_video_init(AVBufferRef* (*alloc)(int size),
         if (i == 1 || i == 2)
             h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
 
-        pool->pools[i] = av_buffer_pool_init(pool->linesize[i] * h + 16 + 16 - 1,
-                                             alloc);
+        pool->pool_size[i] = pool->linesize[i] * h + 16 + 16 - 1;
+        pool->pools[i] = av_buffer_pool_init(pool->pool_size[i], alloc);
         if (!pool->pools[i])
             goto fail;
     }
 
     if (desc->flags & AV_PIX_FMT_FLAG_PAL ||
         desc->flags & FF_PSEUDOPAL) {
+        pool->pool_size[1] = AVPALETTE_SIZE;
         pool->pools[1] = av_buffer_pool_init(AVPALETTE_SIZE, alloc);
         if (!pool->pools[1])
             goto fail;
@@ -143,6 +148,7 @@ FFFramePool *ff_frame_pool_audio_init(AVBufferRef* (*alloc)(int size),
     if (ret < 0)
         goto fail;
 
+    pool->pool_size[0] = pool->linesize[0];
     pool->pools[0] = av_buffer_pool_init(pool->linesize[0], NULL);
     if (!pool->pools[0])
         goto fail;
@@ -192,6 +198,27 @@ int ff_frame_pool_get_audio_config(FFFramePool *pool,
     return 0;
 }
 
+int ff_frame_pool_set_shared(FFFramePool *pool, AVBufferRef *shared)
+{
+    if (shared && pool->shared && shared->data == pool->shared->data)
+        return 0;
+
+    av_buffer_unref(&pool->shared);
+    if (shared) {
+        pool->shared = av_buffer_ref(shared);
+        if (!pool->shared)
+            return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+static AVBufferRef *pool_get_buffer(FFFramePool *pool, int plane)
+{
+    if (pool->shared)
+        return av_buffer_shared_pool_get(pool->shared, pool->pool_size[plane]);
+    return av_buffer_pool_get(pool->pools[plane]);
+}
+
 AVFrame *ff_frame_pool_get(FFFramePool *pool)
 {
     int i;
@@ -219,7 +246,7 @@ AVFrame *ff_frame_pool_get(FFFramePool *pool)
             if (!pool->pools[i])
                 break;
 
-            frame->buf[i] = av_buffer_pool_get(pool->pools[i]);
+            frame->buf[i] = pool_get_buffer(pool, i);
             if (!frame->buf[i])
                 goto fail;
 
@@ -258,13 +285,13 @@ AVFrame *ff_frame_pool_get(FFFramePool *pool)
         }
 
         for (i = 0; i < FFMIN(pool->planes, AV_NUM_DATA_POINTERS); i++) {
-            frame->buf[i] = av_buffer_pool_get(pool->pools[0]);
+            frame->buf[i] = pool_get_buffer(pool, 0);
             if (!frame->buf[i])
                 goto fail;
             frame->extended_data[i] = frame->data[i] = frame->buf[i]->data;
         }
         for (i = 0; i < frame->nb_extended_buf; i++) {
-            frame->extended_buf[i] = av_buffer_pool_get(pool->pools[0]);
+            frame->extended_buf[i] = pool_get_buffer(pool, 0);
             if (!frame->extended_buf[i])
                 goto fail;
             frame->extended_data[i + AV_NUM_DATA_POINTERS] = frame->extended_buf[i]->data;
@@ -291,6 +318,7 @@ void ff_frame_pool_uninit(FFFramePool **pool)
     for (i = 0; i < 4; i++) {
         av_buffer_pool_uninit(&(*pool)->pools[i]);
     }
+    av_buffer_unref(&(*pool)->shared);
 
     av_freep(pool);
 }
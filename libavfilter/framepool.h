@@ -75,6 +75,17 @@ FFFramePool *ff_frame_pool_audio_init(AVBufferRef* (*alloc)(int size),
  */
 void ff_frame_pool_uninit(FFFramePool **pool);
 
+/**
+ * Make the frame pool take its buffers from a shared buffer pool.
+ *
+ * @param pool the frame pool
+ * @param shared a shared pool allocated with av_buffer_shared_pool_alloc(),
+ * or NULL to go back to the private pools. A new reference is created,
+ * unless the frame pool already uses this shared pool.
+ * @return 0 on success, a negative AVERROR on error.
+ */
+int ff_frame_pool_set_shared(FFFramePool *pool, AVBufferRef *shared);
+
 /**
  * Get the video frame pool configuration.
  *
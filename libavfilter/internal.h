@@ -149,10 +149,17 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+    void *sched;
+    /**
+     * Set while the parallel scheduler activates several filters at once;
+     * updates of the sink links heap are then deferred to the scheduler.
+     */
+    int sched_running;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+    unsigned sched_mark;
 };
 
 /**
@@ -384,6 +391,12 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter accesses other filters of its graph (e.g. to send them
+ * commands). The parallel scheduler only activates it alone.
+ */
+#define FF_FILTER_FLAG_GRAPH_WIDE    (1 << 1)
+
 /**
  * Run one round of processing on a filter graph.
  */
@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_H
+#define AVFILTER_PALETTEUSE_H
+
+#include <stdint.h>
+
+/* Component value of the unused entries at the end of the arrays passed to
+ * nearest(), far enough from any color to never be the nearest entry. */
+#define PALETTEUSE_PAD_VALUE 1023
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Find the entry of a palette nearest to a color.
+     *
+     * @param rg         red and green component of each entry, interleaved
+     * @param b          blue component of each entry, interleaved with zeroes
+     * @param nb_entries number of entries, a non-zero multiple of 8; unused
+     *                   entries have all components set to PALETTEUSE_PAD_VALUE
+     *                   (the zeroes in b excepted)
+     * @return the index of the first entry at the smallest distance
+     */
+    int (*nearest)(const int16_t *rg, const int16_t *b, int nb_entries,
+                   int r, int g, int b_);
+} PaletteUseDSPContext;
+
+void ff_paletteuse_dsp_init(PaletteUseDSPContext *dsp);
+void ff_paletteuse_dsp_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSE_H */
@@ -37,6 +37,8 @@ typedef struct ThreadContext {
     AVFilterGraph *graph;
     AVSliceThread *thread;
     avfilter_action_func *func;
+    /* serializes execute calls coming from concurrently activated filters */
+    pthread_mutex_t lock;
 
     /* per-execute parameters */
     AVFilterContext *ctx;
@@ -55,6 +57,7 @@ static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb
 static void slice_thread_uninit(ThreadContext *c)
 {
     avpriv_slicethread_free(&c->thread);
+    pthread_mutex_destroy(&c->lock);
 }
 
 static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
@@ -64,20 +67,27 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
 
     if (nb_jobs <= 0)
         return 0;
+    pthread_mutex_lock(&c->lock);
     c->ctx         = ctx;
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
 
     avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+    pthread_mutex_unlock(&c->lock);
     return 0;
 }
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
+    int ret = pthread_mutex_init(&c->lock, NULL);
+    if (ret)
+        return AVERROR(ret);
     nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
-    if (nb_threads <= 1)
+    if (nb_threads <= 1) {
         avpriv_slicethread_free(&c->thread);
+        pthread_mutex_destroy(&c->lock);
+    }
     return FFMAX(nb_threads, 1);
 }
 
@@ -114,3 +124,194 @@ void ff_graph_thread_free(AVFilterGraph *graph)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
 }
+
+typedef struct SchedContext {
+    AVSliceThread *thread;
+    /* protects the ready field of filters shared by a batch */
+    pthread_mutex_t lock;
+    AVFilterContext **ready;   ///< ready filters, by decreasing priority
+    AVFilterContext **batch;   ///< filters activated concurrently
+    int *rets;
+    unsigned nb_batch;
+    unsigned size;
+    unsigned mark;
+} SchedContext;
+
+static void sched_worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    SchedContext *s = priv;
+    s->rets[jobnr] = ff_filter_activate(s->batch[jobnr]);
+}
+
+int ff_graph_sched_init(AVFilterGraph *graph)
+{
+    SchedContext *s;
+    int ret;
+
+    if (graph->scheduler != AVFILTER_SCHEDULER_PARALLEL || graph->internal->sched)
+        return 0;
+
+    s = av_mallocz(sizeof(*s));
+    if (!s)
+        return AVERROR(ENOMEM);
+
+    ret = pthread_mutex_init(&s->lock, NULL);
+    if (ret) {
+        av_free(s);
+        return AVERROR(ret);
+    }
+    ret = avpriv_slicethread_create(&s->thread, s, sched_worker_func, NULL,
+                                    graph->nb_threads);
+    if (ret <= 1) {
+        avpriv_slicethread_free(&s->thread);
+        pthread_mutex_destroy(&s->lock);
+        av_free(s);
+        if (ret < 0)
+            return ret;
+        av_log(graph, AV_LOG_VERBOSE,
+               "Single thread available, using the serial scheduler.\n");
+        graph->scheduler = AVFILTER_SCHEDULER_SERIAL;
+        return 0;
+    }
+    av_log(graph, AV_LOG_VERBOSE, "Parallel scheduler using %d threads.\n", ret);
+
+    graph->internal->sched = s;
+    return 0;
+}
+
+void ff_graph_sched_free(AVFilterGraph *graph)
+{
+    SchedContext *s = graph->internal->sched;
+
+    if (!s)
+        return;
+    avpriv_slicethread_free(&s->thread);
+    pthread_mutex_destroy(&s->lock);
+    av_freep(&s->ready);
+    av_freep(&s->batch);
+    av_freep(&s->rets);
+    av_freep(&graph->internal->sched);
+}
+
+void ff_graph_sched_set_ready(AVFilterContext *filter, unsigned priority)
+{
+    SchedContext *s = filter->graph->internal->sched;
+
+    pthread_mutex_lock(&s->lock);
+    filter->ready = FFMAX(filter->ready, priority);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/* Marks set on the filters around the members of the current batch. */
+#define MARK_EXCLUSIVE(s) (2 * (s)->mark)
+#define MARK_SHARED(s)    (2 * (s)->mark + 1)
+
+/**
+ * Reserve a filter and its neighbours for the current batch.
+ *
+ * A filter being activated touches the links around it, the outputs of
+ * the filters it feeds (when unblocking them) and the ready field of all
+ * its neighbours. Filters of a batch are therefore never adjacent and never
+ * feed a common filter. They may have a common source (e.g. the outputs of
+ * split): each of them only touches its own link from that source, and the
+ * ready field of the source is updated under the scheduler lock.
+ */
+static int sched_claim(SchedContext *s, AVFilterContext *f)
+{
+    unsigned i;
+
+    if (f->internal->sched_mark >= MARK_EXCLUSIVE(s))
+        return 0;
+    for (i = 0; i < f->nb_inputs; i++)
+        if (f->inputs[i] && f->inputs[i]->src->internal->sched_mark == MARK_EXCLUSIVE(s))
+            return 0;
+    for (i = 0; i < f->nb_outputs; i++)
+        if (f->outputs[i] && f->outputs[i]->dst->internal->sched_mark >= MARK_EXCLUSIVE(s))
+            return 0;
+
+    f->internal->sched_mark = MARK_EXCLUSIVE(s);
+    for (i = 0; i < f->nb_inputs; i++)
+        if (f->inputs[i])
+            f->inputs[i]->src->internal->sched_mark = MARK_SHARED(s);
+    for (i = 0; i < f->nb_outputs; i++)
+        if (f->outputs[i])
+            f->outputs[i]->dst->internal->sched_mark = MARK_EXCLUSIVE(s);
+    return 1;
+}
+
+static void sched_update_heap(AVFilterGraph *graph, AVFilterContext *f)
+{
+    unsigned i;
+
+    for (i = 0; i < f->nb_inputs; i++)
+        if (f->inputs[i] && f->inputs[i]->age_index >= 0)
+            ff_avfilter_graph_update_heap(graph, f->inputs[i]);
+    for (i = 0; i < f->nb_outputs; i++)
+        if (f->outputs[i] && f->outputs[i]->age_index >= 0)
+            ff_avfilter_graph_update_heap(graph, f->outputs[i]);
+}
+
+int ff_graph_sched_run_once(AVFilterGraph *graph)
+{
+    SchedContext *s = graph->internal->sched;
+    unsigned i, j, nb_ready = 0;
+    int ret = 0;
+
+    if (s->size < graph->nb_filters) {
+        unsigned size = graph->nb_filters;
+        if ((ret = av_reallocp_array(&s->ready, size, sizeof(*s->ready))) < 0 ||
+            (ret = av_reallocp_array(&s->batch, size, sizeof(*s->batch))) < 0 ||
+            (ret = av_reallocp_array(&s->rets,  size, sizeof(*s->rets)))  < 0) {
+            s->size = 0;
+            return ret;
+        }
+        s->size = size;
+    }
+
+    /* Stable insertion sort: among equal priorities, the graph order used by
+       the serial scheduler is kept. */
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+        if (!f->ready)
+            continue;
+        for (j = nb_ready; j > 0 && s->ready[j - 1]->ready < f->ready; j--)
+            s->ready[j] = s->ready[j - 1];
+        s->ready[j] = f;
+        nb_ready++;
+    }
+    if (!nb_ready)
+        return AVERROR(EAGAIN);
+
+    if (++s->mark > UINT_MAX / 2 - 1) {
+        for (i = 0; i < graph->nb_filters; i++)
+            graph->filters[i]->internal->sched_mark = 0;
+        s->mark = 1;
+    }
+    s->nb_batch = 0;
+    for (i = 0; i < nb_ready; i++) {
+        AVFilterContext *f = s->ready[i];
+        int exclusive = f->filter->flags_internal & FF_FILTER_FLAG_GRAPH_WIDE;
+
+        if (exclusive && s->nb_batch)
+            continue;
+        if (!sched_claim(s, f))
+            continue;
+        s->batch[s->nb_batch++] = f;
+        if (exclusive)
+            break;
+    }
+
+    if (s->nb_batch == 1)
+        return ff_filter_activate(s->batch[0]);
+
+    graph->internal->sched_running = 1;
+    avpriv_slicethread_execute(s->thread, s->nb_batch, 0);
+    graph->internal->sched_running = 0;
+
+    for (i = 0; i < s->nb_batch; i++) {
+        sched_update_heap(graph, s->batch[i]);
+        if (s->rets[i] < 0 && !ret)
+            ret = s->rets[i];
+    }
+    return ret;
+}
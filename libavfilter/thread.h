@@ -25,4 +25,26 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Set up the scheduler selected by AVFilterGraph.scheduler.
+ * Falls back to the serial scheduler if only one thread is available.
+ */
+int ff_graph_sched_init(AVFilterGraph *graph);
+
+void ff_graph_sched_free(AVFilterGraph *graph);
+
+/**
+ * Activate concurrently a set of ready filters that do not interfere.
+ * The filter with the highest ready priority is always part of the set.
+ *
+ * @return  the first error returned by an activated filter, 0 if all
+ *          succeeded, AVERROR(EAGAIN) if no filter was ready
+ */
+int ff_graph_sched_run_once(AVFilterGraph *graph);
+
+/**
+ * ff_filter_set_ready() while the scheduler runs several filters.
+ */
+void ff_graph_sched_set_ready(AVFilterContext *filter, unsigned priority);
+
 #endif /* AVFILTER_THREAD_H */
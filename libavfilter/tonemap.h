@@ -0,0 +1,51 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_TONEMAP_H
+#define AVFILTER_TONEMAP_H
+
+/**
+ * Tone mapping curve of the form
+ * out = (num[0] * sig^2 + num[1] * sig + num[2]) /
+ *       (den[0] * sig^2 + den[1] * sig + den[2]) + offset
+ * for sig > knee, and out = sig otherwise, where sig is the brightest
+ * component of the (desaturated) pixel.
+ */
+typedef struct TonemapCurve {
+    float coeff[3];     ///< luma weight of each plane
+    float desat;        ///< desaturation strength, 0 to disable
+    float knee;
+    float num[3];
+    float den[3];
+    float offset;
+} TonemapCurve;
+
+typedef struct TonemapDSPContext {
+    /**
+     * Tone map one row of 3 float planes with the given curve.
+     * width must be a multiple of 8.
+     */
+    void (*tonemap_curve)(float *dst0, float *dst1, float *dst2,
+                          const float *src0, const float *src1, const float *src2,
+                          int width, const TonemapCurve *curve);
+} TonemapDSPContext;
+
+void ff_tonemap_dsp_init(TonemapDSPContext *dsp);
+void ff_tonemap_dsp_init_x86(TonemapDSPContext *dsp);
+
+#endif /* AVFILTER_TONEMAP_H */
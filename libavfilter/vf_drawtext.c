@@ -148,7 +148,15 @@ typedef struct DrawTextContext {
     AVBPrint expanded_fontcolor;    ///< used to contain the expanded fontcolor spec
     int ft_load_flags;              ///< flags used for loading fonts, see FT_LOAD_*
     FT_Vector *positions;           ///< positions for each element in the text
-    size_t nb_positions;            ///< number of elements of positions array
+    struct Glyph **layout_glyphs;   ///< glyph for each element in the text
+    size_t nb_positions;            ///< number of elements of positions and layout_glyphs arrays
+    int layout_nb_glyphs;           ///< number of used elements of positions and layout_glyphs
+    char *layout_str;               ///< expanded text the current layout was computed for
+    unsigned int layout_fontsize;   ///< font size the current layout was computed for
+    int layout_w, layout_h;         ///< size of the laid out text
+    int layout_ascent;              ///< maximum glyph ascent of the laid out text
+    int layout_descent;             ///< minimum glyph descent of the laid out text
+    int layout_top, layout_bottom;  ///< rows covered by the glyph bitmaps, relative to y
     char *textfile;                 ///< file with text to be drawn
     int x;                          ///< x position to start drawing text
     int y;                          ///< y position to start drawing text
@@ -805,6 +813,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     s->x_pexpr = s->y_pexpr = s->a_pexpr = s->fontsize_pexpr = NULL;
 
     av_freep(&s->positions);
+    av_freep(&s->layout_glyphs);
+    av_freep(&s->layout_str);
     s->nb_positions = 0;
 
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
@@ -1174,51 +1184,92 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+static void draw_glyphs(DrawTextContext *s, uint8_t *data[], int linesize[],
+                        int width, int height,
+                        FFDrawColor *color,
+                        int x, int y, int borderw)
 {
-    char *text = s->expanded_text.str;
-    uint32_t code = 0;
     int i, x1, y1;
-    uint8_t *p;
-    Glyph *glyph = NULL;
 
-    for (i = 0, p = text; *p; i++) {
-        FT_Bitmap bitmap;
-        Glyph dummy = { 0 };
-        GET_UTF8(code, *p++, continue;);
+    for (i = 0; i < s->layout_nb_glyphs; i++) {
+        const Glyph *glyph = s->layout_glyphs[i];
+        const FT_Bitmap *bitmap;
 
-        /* skip new line chars, just go to new line */
-        if (code == '\n' || code == '\r' || code == '\t')
+        /* new line and tab chars have no glyph to draw */
+        if (!glyph)
             continue;
 
-        dummy.code = code;
-        dummy.fontsize = s->fontsize;
-        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
-
-        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
-
-        if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
-            glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
-            return AVERROR(EINVAL);
+        bitmap = borderw ? &glyph->border_bitmap : &glyph->bitmap;
 
         x1 = s->positions[i].x+s->x+x - borderw;
         y1 = s->positions[i].y+s->y+y - borderw;
 
         ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
+                      data, linesize, width, height,
+                      bitmap->buffer, bitmap->pitch,
+                      bitmap->width, bitmap->rows,
+                      bitmap->pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
                       0, x1, y1);
     }
+}
+
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width, height;
+    int y0, nb_groups;
+    int box_w, box_h;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+} ThreadData;
+
+/**
+ * Draw the box, shadow, border and text over a band of rows. Bands are
+ * aligned to the chroma subsampling so that every chroma sample is
+ * blended by exactly one job, in the same order as the unthreaded case.
+ */
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int shift = s->dc.vsub_max;
+    const int start = td->y0 + ((td->nb_groups *  jobnr     ) / nb_jobs << shift);
+    const int end   = FFMIN(td->y0 + ((td->nb_groups * (jobnr + 1)) / nb_jobs << shift),
+                            td->height);
+    uint8_t *data[4] = { NULL };
+    int linesize[4] = { 0 };
+    int p;
+
+    if (end <= start)
+        return 0;
+
+    for (p = 0; p < s->dc.nb_planes; p++) {
+        data[p]     = frame->data[p] + (start >> s->dc.vsub[p]) * frame->linesize[p];
+        linesize[p] = frame->linesize[p];
+    }
+
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, linesize, td->width, end - start,
+                           s->x - s->boxborderw, s->y - s->boxborderw - start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(s, data, linesize, td->width, end - start,
+                    &td->shadowcolor, s->shadowx, s->shadowy - start, 0);
+
+    if (s->borderw)
+        draw_glyphs(s, data, linesize, td->width, end - start,
+                    &td->bordercolor, 0, -start, s->borderw);
+
+    draw_glyphs(s, data, linesize, td->width, end - start,
+                &td->fontcolor, 0, -start, 0);
 
     return 0;
 }
 
-
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
     *color = incolor;
@@ -1241,89 +1292,40 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_text(AVFilterContext *ctx, AVFrame *frame,
-                     int width, int height)
+/**
+ * Load the glyphs of the expanded text and compute their positions. The
+ * result only depends on the text and the font size, so it is kept until
+ * either of them changes.
+ */
+static int layout_text(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
-    AVFilterLink *inlink = ctx->inputs[0];
-
+    char *text = s->expanded_text.str;
+    int len = s->expanded_text.len;
     uint32_t code = 0, prev_code = 0;
     int x = 0, y = 0, i = 0, ret;
-    int max_text_line_w = 0, len;
-    int box_w, box_h;
-    char *text;
-    uint8_t *p;
+    int max_text_line_w = 0;
     int y_min = 32000, y_max = -32000;
     int x_min = 32000, x_max = -32000;
+    int top = INT_MAX, bottom = INT_MIN;
+    uint8_t *p;
     FT_Vector delta;
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
 
-    time_t now = time(0);
-    struct tm ltime;
-    AVBPrint *bp = &s->expanded_text;
+    av_freep(&s->layout_str);
+    s->layout_nb_glyphs = 0;
 
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
-    av_bprint_clear(bp);
-
-    if(s->basetime != AV_NOPTS_VALUE)
-        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
-
-    switch (s->exp_mode) {
-    case EXP_NONE:
-        av_bprintf(bp, "%s", s->text);
-        break;
-    case EXP_NORMAL:
-        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
-            return ret;
-        break;
-    case EXP_STRFTIME:
-        localtime_r(&now, &ltime);
-        av_bprint_strftime(bp, s->text, &ltime);
-        break;
-    }
-
-    if (s->tc_opt_string) {
-        char tcbuf[AV_TIMECODE_STR_SIZE];
-        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
-        av_bprint_clear(bp);
-        av_bprintf(bp, "%s%s", s->text, tcbuf);
-    }
-
-    if (!av_bprint_is_complete(bp))
-        return AVERROR(ENOMEM);
-    text = s->expanded_text.str;
-    if ((len = s->expanded_text.len) > s->nb_positions) {
+    if (len > s->nb_positions) {
         if (!(s->positions =
               av_realloc(s->positions, len*sizeof(*s->positions))))
             return AVERROR(ENOMEM);
-        s->nb_positions = len;
-    }
-
-    if (s->fontcolor_expr[0]) {
-        /* If expression is set, evaluate and replace the static value */
-        av_bprint_clear(&s->expanded_fontcolor);
-        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
-            return ret;
-        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+        if (!(s->layout_glyphs =
+              av_realloc(s->layout_glyphs, len*sizeof(*s->layout_glyphs))))
             return AVERROR(ENOMEM);
-        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
-        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
-        if (ret)
-            return ret;
-        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+        s->nb_positions = len;
     }
 
-    x = 0;
-    y = 0;
-
-    if ((ret = update_fontsize(ctx)) < 0)
-        return ret;
-
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
         GET_UTF8(code, *p++, continue;);
@@ -1349,6 +1351,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     /* compute and save position for each glyph */
     glyph = NULL;
     for (i = 0, p = text; *p; i++) {
+        s->layout_glyphs[i] = NULL;
         GET_UTF8(code, *p++, continue;);
 
         /* skip the \n in the sequence \r\n */
@@ -1380,19 +1383,118 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
         /* save position */
         s->positions[i].x = x + glyph->bitmap_left;
         s->positions[i].y = y - glyph->bitmap_top + y_max;
-        if (code == '\t') x  = (x / s->tabsize + 1)*s->tabsize;
-        else              x += glyph->advance;
+        if (code == '\t') {
+            x  = (x / s->tabsize + 1)*s->tabsize;
+        } else {
+            x += glyph->advance;
+
+            if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
+                glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+                return AVERROR(EINVAL);
+            s->layout_glyphs[i] = glyph;
+
+            /* rows touched by the glyph and its border */
+            top    = FFMIN(top, s->positions[i].y);
+            bottom = FFMAX(bottom, s->positions[i].y + (int)glyph->bitmap.rows);
+            if (s->borderw) {
+                top    = FFMIN(top, s->positions[i].y - s->borderw);
+                bottom = FFMAX(bottom, s->positions[i].y - s->borderw +
+                                       (int)glyph->border_bitmap.rows);
+            }
+        }
     }
 
-    max_text_line_w = FFMAX(x, max_text_line_w);
+    s->layout_nb_glyphs = i;
+    s->layout_w         = FFMAX(x, max_text_line_w);
+    s->layout_h         = y + s->max_glyph_h;
+    s->layout_ascent    = y_max;
+    s->layout_descent   = y_min;
+    s->layout_top       = top <= bottom ? top    : 0;
+    s->layout_bottom    = top <= bottom ? bottom : 0;
+    s->layout_fontsize  = s->fontsize;
+
+    if (!(s->layout_str = av_strdup(text))) {
+        s->layout_nb_glyphs = 0;
+        return AVERROR(ENOMEM);
+    }
 
-    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = max_text_line_w;
-    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = y + s->max_glyph_h;
+    return 0;
+}
+
+static int draw_text(AVFilterContext *ctx, AVFrame *frame,
+                     int width, int height)
+{
+    DrawTextContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+
+    int ret;
+    int box_w, box_h;
+    int y0, y1, nb_jobs;
+    ThreadData td;
+
+    time_t now = time(0);
+    struct tm ltime;
+    AVBPrint *bp = &s->expanded_text;
+
+    av_bprint_clear(bp);
+
+    if(s->basetime != AV_NOPTS_VALUE)
+        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
+
+    switch (s->exp_mode) {
+    case EXP_NONE:
+        av_bprintf(bp, "%s", s->text);
+        break;
+    case EXP_NORMAL:
+        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
+            return ret;
+        break;
+    case EXP_STRFTIME:
+        localtime_r(&now, &ltime);
+        av_bprint_strftime(bp, s->text, &ltime);
+        break;
+    }
+
+    if (s->tc_opt_string) {
+        char tcbuf[AV_TIMECODE_STR_SIZE];
+        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
+        av_bprint_clear(bp);
+        av_bprintf(bp, "%s%s", s->text, tcbuf);
+    }
+
+    if (!av_bprint_is_complete(bp))
+        return AVERROR(ENOMEM);
+
+    if (s->fontcolor_expr[0]) {
+        /* If expression is set, evaluate and replace the static value */
+        av_bprint_clear(&s->expanded_fontcolor);
+        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
+            return ret;
+        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+            return AVERROR(ENOMEM);
+        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
+        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
+        if (ret)
+            return ret;
+        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+    }
+
+    if ((ret = update_fontsize(ctx)) < 0)
+        return ret;
+
+    if (!s->layout_str || s->layout_fontsize != s->fontsize ||
+        strcmp(s->layout_str, s->expanded_text.str)) {
+        if ((ret = layout_text(ctx)) < 0)
+            return ret;
+    }
+
+    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = s->layout_w;
+    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = s->layout_h;
 
     s->var_values[VAR_MAX_GLYPH_W] = s->max_glyph_w;
     s->var_values[VAR_MAX_GLYPH_H] = s->max_glyph_h;
-    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = y_max;
-    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = y_min;
+    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = s->layout_ascent;
+    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = s->layout_descent;
 
     s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
 
@@ -1402,13 +1504,13 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
-    box_w = max_text_line_w;
-    box_h = y + s->max_glyph_h;
+    box_w = s->layout_w;
+    box_h = s->layout_h;
 
     if (s->fix_bounds) {
 
@@ -1436,27 +1538,32 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
+    /* rows covered by the box, shadow, border and text */
+    y0 = s->y + s->layout_top;
+    y1 = s->y + s->layout_bottom;
     if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
+        y0 = FFMIN(y0, y0 + s->shadowy);
+        y1 = FFMAX(y1, y1 + s->shadowy);
     }
-
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
+    if (s->draw_box) {
+        y0 = FFMIN(y0, s->y - s->boxborderw);
+        y1 = FFMAX(y1, s->y + box_h + s->boxborderw);
     }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    y0 = av_clip(y0, 0, height) >> s->dc.vsub_max << s->dc.vsub_max;
+    y1 = av_clip(y1, 0, height);
+    if (y1 <= y0)
+        return 0;
+
+    td.frame     = frame;
+    td.width     = width;
+    td.height    = height;
+    td.box_w     = box_w;
+    td.box_h     = box_h;
+    td.y0        = y0;
+    td.nb_groups = (y1 - y0 + (1 << s->dc.vsub_max) - 1) >> s->dc.vsub_max;
+    nb_jobs      = FFMIN(ff_filter_get_nb_threads(ctx), td.nb_groups);
+
+    ctx->internal->execute(ctx, draw_text_slice, &td, NULL, nb_jobs);
 
     return 0;
 }
@@ -1529,5 +1636,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -85,7 +85,8 @@ static inline double getpix(void *priv, double x, double y, int plane)
     const int w = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(picref->width,  geq->hsub) : picref->width;
     const int h = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(picref->height, geq->vsub) : picref->height;
 
-    if (!src)
+    /* may also be called for untaken branches, so guard against NaN */
+    if (!src || isnan(x) || isnan(y))
         return 0;
 
     xi = x = av_clipf(x, 0, w - 2);
@@ -234,6 +235,8 @@ static int geq_config_props(AVFilterLink *inlink)
     return 0;
 }
 
+#define ROW_CHUNK 256
+
 typedef struct ThreadData {
     int height;
     int width;
@@ -251,37 +254,38 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    int x, y, i, n;
     uint8_t *ptr;
     uint16_t *ptr16;
 
     double values[VAR_VARS_NB];
+    double xs[ROW_CHUNK], res[ROW_CHUNK];
+    const double *arrays[VAR_VARS_NB] = { NULL };
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
     values[VAR_N] = geq->values[VAR_N];
     values[VAR_SW] = geq->values[VAR_SW];
     values[VAR_SH] = geq->values[VAR_SH];
     values[VAR_T] = geq->values[VAR_T];
-
-    if (geq->bps == 8) {
-        for (y = slice_start; y < slice_end; y++) {
-            ptr = geq->dst + linesize * y;
-            values[VAR_Y] = y;
-
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane], values, geq);
-            }
-            ptr += linesize;
-        }
-    }
-    else {
-        for (y = slice_start; y < slice_end; y++) {
-            ptr16 = geq->dst16 + (linesize/2) * y;
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane], values, geq);
+    arrays[VAR_X] = xs;
+
+    /* evaluate the expression for up to ROW_CHUNK pixels of a row at once */
+    for (y = slice_start; y < slice_end; y++) {
+        ptr = geq->dst + linesize * y;
+        ptr16 = geq->dst16 + (linesize/2) * y;
+        values[VAR_Y] = y;
+
+        for (x = 0; x < width; x += n) {
+            n = FFMIN(width - x, ROW_CHUNK);
+            for (i = 0; i < n; i++)
+                xs[i] = x + i;
+            av_expr_eval_array(geq->e[plane], res, n, values, arrays, geq);
+            if (geq->bps == 8) {
+                for (i = 0; i < n; i++)
+                    ptr[x + i] = res[i];
+            } else {
+                for (i = 0; i < n; i++)
+                    ptr16[x + i] = res[i];
             }
         }
     }
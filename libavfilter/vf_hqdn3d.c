@@ -120,8 +120,125 @@ static void denoise_spatial(HQDN3DContext *s,
     }
 }
 
+/*
+ * The horizontal IIR of a row only depends on the input row, while the
+ * vertical one only runs down each column. So the threaded spatial path
+ * first runs the horizontal pass on slices of rows, then the vertical and
+ * temporal ones on bands of columns, which gives the same output as the
+ * serial path.
+ */
+av_always_inline
+static void denoise_spatial_hpass(uint8_t *src, uint16_t *hpass,
+                                  int w, int y0, int y1, int sstride,
+                                  int16_t *spatial, int depth)
+{
+    long x, y;
+    uint32_t pixel_ant;
+
+    spatial += 256 << LUT_BITS;
+
+    src   += y0 * sstride;
+    hpass += y0 * w;
+    for (y = y0; y < y1; y++) {
+        pixel_ant = LOAD(0);
+        /* the first line is also filtered against its own first pixel */
+        if (!y)
+            pixel_ant = lowpass(pixel_ant, LOAD(0), spatial, depth);
+        hpass[0] = pixel_ant;
+        for (x = 1; x < w; x++)
+            hpass[x] = pixel_ant = lowpass(pixel_ant, LOAD(x), spatial, depth);
+        src   += sstride;
+        hpass += w;
+    }
+}
+
+av_always_inline
+static void denoise_spatial_vpass(uint16_t *hpass, uint8_t *dst,
+                                  uint16_t *line_ant, uint16_t *frame_ant,
+                                  int w, int h, int dstride, int x0, int x1,
+                                  int16_t *spatial, int16_t *temporal, int depth)
+{
+    long x, y;
+    uint32_t tmp;
+
+    spatial  += 256 << LUT_BITS;
+    temporal += 256 << LUT_BITS;
+
+    for (x = x0; x < x1; x++) {
+        line_ant[x] = tmp = hpass[x];
+        frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+        STORE(x, tmp);
+    }
+
+    for (y = 1; y < h; y++) {
+        hpass += w;
+        dst += dstride;
+        frame_ant += w;
+        for (x = x0; x < x1; x++) {
+            line_ant[x] = tmp = lowpass(line_ant[x], hpass[x], spatial, depth);
+            frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
+            STORE(x, tmp);
+        }
+    }
+}
+
+typedef struct ThreadData {
+    uint8_t *src, *dst;
+    uint16_t *frame_ant;
+    int w, h, sstride, dstride;
+    int16_t *spatial, *temporal;
+} ThreadData;
+
+#define DEPTH_SWITCH(func, ...)                                               \
+    do {                                                                      \
+        switch (s->depth) {                                                   \
+            case  8: func(__VA_ARGS__,  8); break;                            \
+            case  9: func(__VA_ARGS__,  9); break;                            \
+            case 10: func(__VA_ARGS__, 10); break;                            \
+            case 16: func(__VA_ARGS__, 16); break;                            \
+        }                                                                     \
+    } while (0)
+
+static int temporal_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int y0 = (td->h *  jobnr     ) / nb_jobs;
+    const int y1 = (td->h * (jobnr + 1)) / nb_jobs;
+
+    DEPTH_SWITCH(denoise_temporal, td->src + y0 * td->sstride,
+                 td->dst + y0 * td->dstride, td->frame_ant + y0 * td->w,
+                 td->w, y1 - y0, td->sstride, td->dstride, td->temporal);
+    emms_c();
+    return 0;
+}
+
+static int spatial_hpass_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int y0 = (td->h *  jobnr     ) / nb_jobs;
+    const int y1 = (td->h * (jobnr + 1)) / nb_jobs;
+
+    DEPTH_SWITCH(denoise_spatial_hpass, td->src, s->hpass,
+                 td->w, y0, y1, td->sstride, td->spatial);
+    return 0;
+}
+
+static int spatial_vpass_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int x0 = (td->w *  jobnr     ) / nb_jobs;
+    const int x1 = (td->w * (jobnr + 1)) / nb_jobs;
+
+    DEPTH_SWITCH(denoise_spatial_vpass, s->hpass, td->dst, s->line, td->frame_ant,
+                 td->w, td->h, td->dstride, x0, x1, td->spatial, td->temporal);
+    return 0;
+}
+
 av_always_inline
-static int denoise_depth(HQDN3DContext *s,
+static int denoise_depth(AVFilterContext *ctx,
                          uint8_t *src, uint8_t *dst,
                          uint16_t *line_ant, uint16_t **frame_ant_ptr,
                          int w, int h, int sstride, int dstride,
@@ -129,6 +246,7 @@ static int denoise_depth(HQDN3DContext *s,
 {
     // FIXME: For 16-bit depth, frame_ant could be a pointer to the previous
     // filtered frame rather than a separate buffer.
+    HQDN3DContext *s = ctx->priv;
     long x, y;
     uint16_t *frame_ant = *frame_ant_ptr;
     if (!frame_ant) {
@@ -143,6 +261,27 @@ static int denoise_depth(HQDN3DContext *s,
         frame_ant = *frame_ant_ptr;
     }
 
+    if (s->nb_threads > 1) {
+        ThreadData td = {
+            .src      = src,     .dst      = dst,
+            .frame_ant = frame_ant,
+            .w        = w,       .h        = h,
+            .sstride  = sstride, .dstride  = dstride,
+            .spatial  = spatial, .temporal = temporal,
+        };
+
+        if (spatial[0]) {
+            ctx->internal->execute(ctx, spatial_hpass_slice, &td, NULL,
+                                   FFMIN(h, s->nb_threads));
+            ctx->internal->execute(ctx, spatial_vpass_slice, &td, NULL,
+                                   FFMIN(w, s->nb_threads));
+        } else {
+            ctx->internal->execute(ctx, temporal_slice, &td, NULL,
+                                   FFMIN(h, s->nb_threads));
+        }
+        return 0;
+    }
+
     if (spatial[0])
         denoise_spatial(s, src, dst, line_ant, frame_ant,
                         w, h, sstride, dstride, spatial, temporal, depth);
@@ -224,6 +363,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->coefs[2]);
     av_freep(&s->coefs[3]);
     av_freep(&s->line);
+    av_freep(&s->hpass);
     av_freep(&s->frame_prev[0]);
     av_freep(&s->frame_prev[1]);
     av_freep(&s->frame_prev[2]);
@@ -271,10 +411,18 @@ static int config_input(AVFilterLink *inlink)
     s->vsub  = desc->log2_chroma_h;
     s->depth = desc->comp[0].depth;
 
+    s->nb_threads = ff_filter_get_nb_threads(inlink->dst);
+
     s->line = av_malloc_array(inlink->w, sizeof(*s->line));
     if (!s->line)
         return AVERROR(ENOMEM);
 
+    if (s->nb_threads > 1) {
+        s->hpass = av_malloc_array(inlink->w, inlink->h * sizeof(*s->hpass));
+        if (!s->hpass)
+            return AVERROR(ENOMEM);
+    }
+
     for (i = 0; i < 4; i++) {
         s->coefs[i] = precalc_coefs(s->strength[i], s->depth);
         if (!s->coefs[i])
@@ -309,7 +457,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
 
     for (c = 0; c < 3; c++) {
-        denoise(s, in->data[c], out->data[c],
+        denoise(ctx, in->data[c], out->data[c],
                 s->line, &s->frame_prev[c],
                 AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
                 AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)),
@@ -370,5 +518,5 @@ AVFilter ff_vf_hqdn3d = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_hqdn3d_inputs,
     .outputs       = avfilter_vf_hqdn3d_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -27,6 +27,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixelutils.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
@@ -163,6 +164,23 @@ typedef struct Frame {
     Block *blocks;
 } Frame;
 
+/* Motion search progress of a job, as the index of the block following the
+ * last one it has searched. */
+typedef struct Wavefront {
+#if HAVE_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+    int pos;
+} Wavefront;
+
+typedef struct ThreadData {
+    Block *blocks;
+    int dir;
+    int alpha;
+    AVFrame *out;
+} ThreadData;
+
 typedef struct MIContext {
     const AVClass *class;
     AVMotionEstContext me_ctx;
@@ -195,6 +213,9 @@ typedef struct MIContext {
     int log2_chroma_w;
     int log2_chroma_h;
     int nb_planes;
+
+    int nb_threads;
+    Wavefront *wavefront;
 } MIContext;
 
 #define OFFSET(x) offsetof(MIContext, x)
@@ -262,20 +283,16 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - me_ctx->x_min, me_ctx->x_max - x), FFMIN(x - me_ctx->x_min, me_ctx->x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - me_ctx->y_min, me_ctx->y_max - y), FFMIN(y - me_ctx->y_min, me_ctx->y_max - y));
 
-    data_cur += (y + mv_y) * linesize;
-    data_next += (y - mv_y) * linesize;
-
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_block_sad(me_ctx, data_cur + x + mv_x + (y + mv_y) * linesize,
+                           data_next + x - mv_x + (y - mv_y) * linesize, me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -289,19 +306,20 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
+    int ob = me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    sbad = ff_me_block_sad(me_ctx, data_cur + x + mv_x - ob + (y + mv_y - ob) * linesize,
+                           data_next + x - mv_x - ob + (y - mv_y - ob) * linesize,
+                           me_ctx->mb_size * 3 / 2 + ob);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -315,26 +333,42 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
+    int ob = me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = ff_me_block_sad(me_ctx, data_ref + x_mv - ob + (y_mv - ob) * linesize,
+                          data_cur + x - ob + (y - ob) * linesize,
+                          me_ctx->mb_size * 3 / 2 + ob);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
 
+static void free_wavefront(MIContext *mi_ctx)
+{
+#if HAVE_THREADS
+    int i;
+
+    if (mi_ctx->wavefront) {
+        for (i = 0; i < mi_ctx->nb_threads; i++) {
+            pthread_mutex_destroy(&mi_ctx->wavefront[i].lock);
+            pthread_cond_destroy(&mi_ctx->wavefront[i].cond);
+        }
+    }
+#endif
+    av_freep(&mi_ctx->wavefront);
+}
+
 static int config_input(AVFilterLink *inlink)
 {
-    MIContext *mi_ctx = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    MIContext *mi_ctx = ctx->priv;
     AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     const int height = inlink->h;
@@ -380,6 +414,24 @@ static int config_input(AVFilterLink *inlink)
                     return AVERROR(ENOMEM);
             }
         }
+
+        /* the motion search jobs wait on each other, so they must run
+         * concurrently */
+        free_wavefront(mi_ctx);
+        mi_ctx->nb_threads = 1;
+        if (ctx->thread_type & AVFILTER_THREAD_SLICE)
+            mi_ctx->nb_threads = FFMAX(1, FFMIN(ff_filter_get_nb_threads(ctx), mi_ctx->b_height));
+        if (mi_ctx->nb_threads > 1) {
+            mi_ctx->wavefront = av_calloc(mi_ctx->nb_threads, sizeof(*mi_ctx->wavefront));
+            if (!mi_ctx->wavefront)
+                return AVERROR(ENOMEM);
+#if HAVE_THREADS
+            for (i = 0; i < mi_ctx->nb_threads; i++) {
+                pthread_mutex_init(&mi_ctx->wavefront[i].lock, NULL);
+                pthread_cond_init(&mi_ctx->wavefront[i].cond, NULL);
+            }
+#endif
+        }
     }
 
     if (mi_ctx->scd_method == SCD_METHOD_FDIFF) {
@@ -422,9 +474,9 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx, Block *blocks,
+                      int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -564,27 +616,100 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+#if HAVE_THREADS
+static void report_progress(Wavefront *wf, int pos)
 {
-    Block *block;
-    int mb_x, mb_y;
+    pthread_mutex_lock(&wf->lock);
+    wf->pos = pos;
+    pthread_cond_broadcast(&wf->cond);
+    pthread_mutex_unlock(&wf->lock);
+}
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
+static int await_progress(Wavefront *wf, int pos)
+{
+    pthread_mutex_lock(&wf->lock);
+    while (wf->pos < pos)
+        pthread_cond_wait(&wf->cond, &wf->lock);
+    pos = wf->pos;
+    pthread_mutex_unlock(&wf->lock);
+    return pos;
+}
+#else
+static void report_progress(Wavefront *wf, int pos)
+{
+}
+
+static int await_progress(Wavefront *wf, int pos)
+{
+    return INT_MAX;
+}
+#endif
+
+/**
+ * Search the motion vectors of the macroblock rows of a job. The rows are
+ * interleaved between the jobs and a block is only searched once the row
+ * above is done up to its top-right neighbour, so the predictors are the
+ * same as with a single job. Each job searches with its own copy of the
+ * motion estimation context; the one doing the last row stores its median
+ * predictor back, as later cost evaluations depend on it.
+ */
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext me_ctx = mi_ctx->me_ctx;
+    Wavefront *cur  = nb_jobs > 1 ? &mi_ctx->wavefront[jobnr] : NULL;
+    Wavefront *prev = nb_jobs > 1 ? &mi_ctx->wavefront[(jobnr + nb_jobs - 1) % nb_jobs] : NULL;
+    int mb_x, mb_y, avail = 0;
+
+    for (mb_y = jobnr; mb_y < mi_ctx->b_height; mb_y += nb_jobs) {
         for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-            block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+            if (prev && mb_y > 0) {
+                int need = (mb_y - 1) * mi_ctx->b_width + FFMIN(mb_x + 2, mi_ctx->b_width);
+                if (avail < need)
+                    avail = await_progress(prev, need);
+            }
 
-            block->cid = 0;
-            block->sb = 0;
+            if (mi_ctx->me_mode == ME_MODE_BILAT) {
+                Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
 
-            block->mvs[0][0] = 0;
-            block->mvs[0][1] = 0;
+                block->cid = 0;
+                block->sb = 0;
+
+                block->mvs[0][0] = 0;
+                block->mvs[0][1] = 0;
+            }
+
+            search_mv(mi_ctx, &me_ctx, td->blocks, mb_x, mb_y, td->dir);
+
+            if (cur)
+                report_progress(cur, mb_y * mi_ctx->b_width + mb_x + 1);
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+        if (mb_y == mi_ctx->b_height - 1) {
+            mi_ctx->me_ctx.pred_x = me_ctx.pred_x;
+            mi_ctx->me_ctx.pred_y = me_ctx.pred_y;
+        }
+    }
+
+    emms_c();
+    return 0;
+}
+
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td = { .blocks = blocks, .dir = dir };
+    int i;
+
+    for (i = 0; i < mi_ctx->nb_threads && mi_ctx->wavefront; i++)
+        mi_ctx->wavefront[i].pos = 0;
+    ctx->internal->execute(ctx, search_mv_slice, &td, NULL, mi_ctx->nb_threads);
 }
 
+/* Not threaded: the cost of the whole block includes the distance to the
+ * predictor left in me_ctx by the previous call, so the blocks depend on
+ * each other in raster order. */
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
 {
     AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
@@ -765,9 +890,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -782,7 +905,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
+            search_mvs(ctx, mi_ctx->int_blocks, 0);
 
             if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
 
@@ -867,17 +990,13 @@ static int detect_scene_change(MIContext *mi_ctx)
         pixel_refs->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int y0, int y1)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixel_refs[x + y * width].nb = 0;
-
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
             for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
@@ -894,6 +1013,8 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 startc_y = av_clip(start_y, 0, height - 1);
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
                 endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+                startc_y = FFMAX(startc_y, y0);
+                endc_y = FFMIN(endc_y, y1);
 
                 if (dir) {
                     mv_x = -mv_x;
@@ -917,43 +1038,57 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+/**
+ * Blend the motion compensated pixels of rows y0 to y1 into all planes at
+ * once. A chroma pixel is computed from the last luma pixel of its
+ * subsampled group, as the group members overwrite each other.
+ */
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out, int y0, int y1)
 {
     int x, y, plane;
+    int width = avf_out->width;
+    int height = avf_out->height;
+    int mask_w = (1 << mi_ctx->log2_chroma_w) - 1;
+    int mask_h = (1 << mi_ctx->log2_chroma_h) - 1;
+
+    for (y = y0; y < y1; y++) {
+        int last_y = (y & mask_h) == mask_h || y == height - 1;
+        for (x = 0; x < width; x++) {
+            int last_x = (x & mask_w) == mask_w || x == width - 1;
+            int weight_sum = 0;
+            int i;
+            PixelMVS *pixel_mvs = &mi_ctx->pixel_mvs[x + y * width];
+            PixelWeights *pixel_weights = &mi_ctx->pixel_weights[x + y * width];
+            PixelRefs *pixel_refs = &mi_ctx->pixel_refs[x + y * width];
 
-    for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
-        int width = avf_out->width;
-        int height = avf_out->height;
-        int chroma = plane == 1 || plane == 2;
-
-        for (y = 0; y < height; y++)
-            for (x = 0; x < width; x++) {
-                int x_mv, y_mv;
-                int weight_sum = 0;
-                int i, val = 0;
-                PixelMVS *pixel_mvs = &mi_ctx->pixel_mvs[x + y * avf_out->width];
-                PixelWeights *pixel_weights = &mi_ctx->pixel_weights[x + y * avf_out->width];
-                PixelRefs *pixel_refs = &mi_ctx->pixel_refs[x + y * avf_out->width];
-
-                for (i = 0; i < pixel_refs->nb; i++)
-                    weight_sum += pixel_weights->weights[i];
-
-                if (!weight_sum || !pixel_refs->nb) {
-                    pixel_weights->weights[0] = ALPHA_MAX - alpha;
-                    pixel_refs->refs[0] = 1;
-                    pixel_mvs->mvs[0][0] = 0;
-                    pixel_mvs->mvs[0][1] = 0;
-                    pixel_weights->weights[1] = alpha;
-                    pixel_refs->refs[1] = 2;
-                    pixel_mvs->mvs[1][0] = 0;
-                    pixel_mvs->mvs[1][1] = 0;
-                    pixel_refs->nb = 2;
-
-                    weight_sum = ALPHA_MAX;
-                }
+            for (i = 0; i < pixel_refs->nb; i++)
+                weight_sum += pixel_weights->weights[i];
+
+            if (!weight_sum || !pixel_refs->nb) {
+                pixel_weights->weights[0] = ALPHA_MAX - alpha;
+                pixel_refs->refs[0] = 1;
+                pixel_mvs->mvs[0][0] = 0;
+                pixel_mvs->mvs[0][1] = 0;
+                pixel_weights->weights[1] = alpha;
+                pixel_refs->refs[1] = 2;
+                pixel_mvs->mvs[1][0] = 0;
+                pixel_mvs->mvs[1][1] = 0;
+                pixel_refs->nb = 2;
+
+                weight_sum = ALPHA_MAX;
+            }
+
+            for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
+                int chroma = plane == 1 || plane == 2;
+                int val = 0;
+
+                if (chroma && !(last_x && last_y))
+                    continue;
 
                 for (i = 0; i < pixel_refs->nb; i++) {
                     Frame *frame = &mi_ctx->frames[pixel_refs->refs[i]];
+                    int x_mv, y_mv;
+
                     if (chroma) {
                         x_mv = (x >> mi_ctx->log2_chroma_w) + pixel_mvs->mvs[i][0] / (1 << mi_ctx->log2_chroma_w);
                         y_mv = (y >> mi_ctx->log2_chroma_h) + pixel_mvs->mvs[i][1] / (1 << mi_ctx->log2_chroma_h);
@@ -972,10 +1107,12 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
                 else
                     avf_out->data[plane][x + y * avf_out->linesize[plane]] = val;
             }
+        }
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha,
+                         int y0, int y1)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -986,16 +1123,16 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha, y0, y1);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
                 int mv_y = sb->mvs[0][1] * 2;
 
                 int start_x = x_mb + (sb_x << (n - 1));
-                int start_y = y_mb + (sb_y << (n - 1));
+                int start_y = FFMAX(y_mb + (sb_y << (n - 1)), y0);
                 int end_x = start_x + (1 << (n - 1));
-                int end_y = start_y + (1 << (n - 1));
+                int end_y = FFMIN(y_mb + (sb_y << (n - 1)) + (1 << (n - 1)), y1);
 
                 for (y = start_y; y < end_y; y++)  {
                     int y_min = -y;
@@ -1014,7 +1151,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha,
+                           int y0, int y1)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1029,6 +1167,17 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     int start_x, start_y;
     int startc_x, startc_y, endc_x, endc_y;
 
+    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+
+    startc_x = av_clip(start_x, 0, width - 1);
+    startc_y = FFMAX(av_clip(start_y, 0, height - 1), y0);
+    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
+    endc_y = FFMIN(av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1), y1);
+
+    if (startc_y >= endc_y)
+        return;
+
     if (mi_ctx->mc_mode == MC_MODE_AOBMC)
         for (nb_y = FFMAX(0, mb_y - 1); nb_y < FFMIN(mb_y + 2, mi_ctx->b_height); nb_y++)
             for (nb_x = FFMAX(0, mb_x - 1); nb_x < FFMIN(mb_x + 2, mi_ctx->b_width); nb_x++) {
@@ -1039,14 +1188,6 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
                     sbads[nb_x - mb_x + 1 + (nb_y - mb_y + 1) * 3] = get_sbad(&mi_ctx->me_ctx, x_nb, y_nb, x_nb + block->mvs[0][0], y_nb + block->mvs[0][1]);
             }
 
-    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-
-    startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
-    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
-
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
         int y_max = height - y - 1;
@@ -1078,6 +1219,52 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+/**
+ * Motion compensate the rows of a band of macroblock rows. Each block is
+ * clipped to the band, so the pixels gather their predictions in the same
+ * order as with a single job.
+ */
+static int interpolate_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    int width = mi_ctx->frames[0].avf->width;
+    int height = mi_ctx->frames[0].avf->height;
+    int y0 = (mi_ctx->b_height *  jobnr     / nb_jobs) << mi_ctx->log2_mb_size;
+    int y1 = (mi_ctx->b_height * (jobnr + 1) / nb_jobs) << mi_ctx->log2_mb_size;
+    int x, y;
+
+    if (jobnr == nb_jobs - 1)
+        y1 = height;
+
+    for (y = y0; y < y1; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixel_refs[x + y * width].nb = 0;
+
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, y0, y1);
+
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        int mb_x, mb_y;
+        Block *block;
+
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, td->alpha, y0, y1);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, y0, y1);
+            }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, td->out, y0, y1);
+
+    emms_c();
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1129,34 +1316,14 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
             }
 
             break;
-        case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
-
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
-
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixel_refs[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+        case MI_MODE_MCI: {
+            ThreadData td = { .alpha = alpha, .out = avf_out };
 
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+            ctx->internal->execute(ctx, interpolate_slice, &td, NULL,
+                                   FFMIN(ff_filter_get_nb_threads(ctx), FFMAX(1, mi_ctx->b_height)));
 
             break;
+        }
     }
 }
 
@@ -1239,6 +1406,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     for (i = 0; i < 3; i++)
         av_freep(&mi_ctx->mv_table[i]);
+
+    free_wavefront(mi_ctx);
 }
 
 static const AVFilterPad minterpolate_inputs[] = {
@@ -1269,4 +1438,5 @@ AVFilter ff_vf_minterpolate = {
     .query_formats = query_formats,
     .inputs        = minterpolate_inputs,
     .outputs       = minterpolate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -27,10 +27,12 @@
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "framesync.h"
 #include "internal.h"
+#include "paletteuse.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -75,17 +77,45 @@ struct cache_node {
     int nb_entries;
 };
 
+/* Number of pixels an error diffusion row must stay behind the row above it,
+ * and granularity at which the progress within a row is published. */
+#define WAVEFRONT_LAG       5
+#define WAVEFRONT_INTERVAL 32
+
+struct wavefront {
+#if HAVE_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+    int pos;
+};
+
 struct PaletteUseContext;
 
 typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+                              int x_start, int y_start, int width, int height,
+                              int jobnr, int nb_jobs);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
     struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*slice_caches)[CACHE_SIZE]; /* lookup caches of the other slice jobs */
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
+    int nb_opaque;                          /* number of palette entries above the alpha threshold */
+    DECLARE_ALIGNED(32, int16_t, opaque_rg)[AVPALETTE_COUNT * 2]; /* components of these entries, */
+    DECLARE_ALIGNED(32, int16_t, opaque_b)[AVPALETTE_COUNT * 2];  /* in the layout of dsp.nearest() */
+    uint8_t opaque_id[AVPALETTE_COUNT];     /* index of these entries in the palette */
+    PaletteUseDSPContext dsp;
+    int nb_threads;
+    struct wavefront *wavefront;            /* per job row progress for error diffusion */
+#if HAVE_THREADS
+    pthread_mutex_t rows_lock;              /* protects next_row and last_row_job */
+#endif
+    int next_row;                           /* next error diffusion row to claim */
+    int last_row_job;                       /* job which claimed the row before it */
+    int *jobs_ret;
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
     int palette_loaded;
@@ -206,6 +236,43 @@ static av_always_inline uint8_t colormap_nearest_bruteforce(const uint32_t *pale
     return pal_id;
 }
 
+static int nearest_c(const int16_t *rg, const int16_t *b, int nb_entries,
+                     int r, int g, int b_)
+{
+    int i, best = 0, min_dist = INT_MAX;
+
+    for (i = 0; i < nb_entries; i++) {
+        const int dr = rg[2*i    ] - r;
+        const int dg = rg[2*i + 1] - g;
+        const int db = b [2*i    ] - b_;
+        const int d  = dr*dr + dg*dg + db*db;
+
+        if (d < min_dist) {
+            best = i;
+            min_dist = d;
+        }
+    }
+    return best;
+}
+
+/**
+ * Same result as colormap_nearest_bruteforce(), but scanning only the opaque
+ * entries with dsp.nearest().
+ */
+static av_always_inline uint8_t colormap_nearest_linear(const PaletteUseContext *s, const uint8_t *argb)
+{
+    if (!s->nb_opaque)
+        return colormap_nearest_bruteforce(s->palette, argb, s->trans_thresh);
+
+    /* a transparent target is equally far from every opaque entry */
+    if (argb[0] < s->trans_thresh)
+        return s->opaque_id[0];
+
+    return s->opaque_id[s->dsp.nearest(s->opaque_rg, s->opaque_b,
+                                       FFALIGN(s->nb_opaque, 8),
+                                       argb[1], argb[2], argb[3])];
+}
+
 /* Recursive form, simpler but a bit slower. Kept for reference. */
 struct nearest_color {
     int node_pos;
@@ -338,7 +405,8 @@ end:
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color,
                                       uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
@@ -348,7 +416,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -367,12 +435,15 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     if (!e)
         return AVERROR(ENOMEM);
     e->color = color;
-    e->pal_entry = COLORMAP_NEAREST(search_method, s->palette, s->map, argb_elts, s->trans_thresh);
+    if (search_method == COLOR_SEARCH_BRUTEFORCE)
+        e->pal_entry = colormap_nearest_linear(s, argb_elts);
+    else
+        e->pal_entry = COLORMAP_NEAREST(search_method, s->palette, s->map, argb_elts, s->trans_thresh);
 
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -381,7 +452,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -391,24 +462,110 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
+#if HAVE_THREADS
+static void report_progress(struct wavefront *wf, int pos)
+{
+    pthread_mutex_lock(&wf->lock);
+    wf->pos = pos;
+    pthread_cond_broadcast(&wf->cond);
+    pthread_mutex_unlock(&wf->lock);
+}
+
+static int await_progress(struct wavefront *wf, int pos)
+{
+    pthread_mutex_lock(&wf->lock);
+    while (wf->pos < pos)
+        pthread_cond_wait(&wf->cond, &wf->lock);
+    pos = wf->pos;
+    pthread_mutex_unlock(&wf->lock);
+    return pos;
+}
+#else
+static void report_progress(struct wavefront *wf, int pos)
+{
+}
+
+static int await_progress(struct wavefront *wf, int pos)
+{
+    return INT_MAX;
+}
+#endif
+
+/**
+ * Claim the next error diffusion row to map, and set prev to the progress of
+ * the job mapping the row above it. That job is running since it claimed its
+ * row earlier, so the jobs never wait on one which has not started, however
+ * execute() schedules them.
+ */
+static int claim_row(PaletteUseContext *s, int jobnr, struct wavefront **prev)
+{
+    int row;
+
+#if HAVE_THREADS
+    pthread_mutex_lock(&s->rows_lock);
+#endif
+    row = s->next_row++;
+    *prev = s->last_row_job >= 0 ? &s->wavefront[s->last_row_job] : NULL;
+    s->last_row_job = jobnr;
+#if HAVE_THREADS
+    pthread_mutex_unlock(&s->rows_lock);
+#endif
+    return row;
+}
+
+/**
+ * Map the pixels of a slice job. Without error diffusion every job maps its
+ * own band of rows. With error diffusion, the jobs claim the rows one after
+ * the other and each row is processed as a wavefront: a pixel is only mapped
+ * once the row above is done up to the last pixel diffusing into it and its
+ * right neighbours, so the errors are accumulated in the same order as with
+ * a single job.
+ */
 static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
+                                      int jobnr, int nb_jobs,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
 {
-    int x, y;
+    int x, y, y0, y1;
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
+    const int diffusion = dither != DITHERING_NONE && dither != DITHERING_BAYER;
+    const int claim = diffusion && nb_jobs > 1;
+    const int width = w;
+    struct cache_node *cache = jobnr ? s->slice_caches[jobnr - 1] : s->cache;
+    struct wavefront *cur  = NULL;
+    struct wavefront *prev = NULL;
+
+    if (claim) {
+        cur = &s->wavefront[jobnr];
+        y0  = y_start + claim_row(s, jobnr, &prev);
+        y1  = y_start + h;
+    } else if (diffusion) {
+        y0  = y_start;
+        y1  = y_start + h;
+    } else {
+        y0  = y_start + (h *  jobnr     ) / nb_jobs;
+        y1  = y_start + (h * (jobnr + 1)) / nb_jobs;
+    }
 
     w += x_start;
     h += y_start;
 
-    for (y = y_start; y < h; y++) {
+    for (y = y0; y < y1; y = claim ? y_start + claim_row(s, jobnr, &prev) : y + 1) {
+        uint32_t *src = ((uint32_t *)in ->data[0]) + y*src_linesize;
+        uint8_t  *dst =              out->data[0]  + y*dst_linesize;
+        const int row_pos = (y - y_start) * width;
+        int avail = y > y_start ? 0 : width;
+
         for (x = x_start; x < w; x++) {
             int er, eg, eb;
 
+            if (prev && x - x_start + WAVEFRONT_LAG > avail) {
+                const int need = FFMIN(x - x_start + WAVEFRONT_LAG, width);
+                avail = await_progress(prev, row_pos - width + need) - (row_pos - width);
+            }
+
             if (dither == DITHERING_BAYER) {
                 const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
                 const uint8_t a8 = src[x] >> 24 & 0xff;
@@ -418,7 +575,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = av_clip_uint8(r8 + d);
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
-                const int color = color_get(s, src[x], a8, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a8, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -426,7 +583,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -438,7 +595,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -452,7 +609,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -471,7 +628,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -486,15 +643,16 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
                 dst[x] = color;
             }
+
+            if (cur && ((x - x_start + 1) % WAVEFRONT_INTERVAL == 0 || x == w - 1))
+                report_progress(cur, row_pos + x - x_start + 1);
         }
-        src += src_linesize;
-        dst += dst_linesize;
     }
     return 0;
 }
@@ -761,6 +919,23 @@ static void load_colormap(PaletteUseContext *s)
         }
     }
 
+    s->nb_opaque = 0;
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        s->opaque_rg[2*i] = s->opaque_rg[2*i + 1] = PALETTEUSE_PAD_VALUE;
+        s->opaque_b [2*i] = PALETTEUSE_PAD_VALUE;
+        s->opaque_b [2*i + 1] = 0;
+    }
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        const uint32_t c = s->palette[i];
+        if (c >> 24 >= s->trans_thresh) {
+            s->opaque_rg[2*s->nb_opaque    ] = c >> 16 & 0xff;
+            s->opaque_rg[2*s->nb_opaque + 1] = c >>  8 & 0xff;
+            s->opaque_b [2*s->nb_opaque    ] = c       & 0xff;
+            s->opaque_id[s->nb_opaque] = i;
+            s->nb_opaque++;
+        }
+    }
+
     box.min[0] = box.min[1] = box.min[2] = 0x00;
     box.max[0] = box.max[1] = box.max[2] = 0xff;
 
@@ -894,6 +1069,49 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int ret = s->set_frame(s, td->out, td->in, td->x, td->y, td->w, td->h,
+                           jobnr, nb_jobs);
+
+    /* do not leave the job mapping the next rows waiting */
+    if (ret < 0 && s->wavefront)
+        report_progress(&s->wavefront[jobnr], INT_MAX);
+    return ret;
+}
+
+static int set_frame_threaded(AVFilterContext *ctx, AVFrame *out, AVFrame *in,
+                              int x, int y, int w, int h)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData td = { .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+    int i, nb_jobs = FFMIN(s->nb_threads, h);
+
+    /* The cache entries of bayer dithering depend on the order in which the
+     * pixels are visited, so it is kept on a single job. */
+    if (s->dither == DITHERING_BAYER || nb_jobs <= 1)
+        return s->set_frame(s, out, in, x, y, w, h, 0, 1);
+
+    for (i = 0; i < nb_jobs; i++) {
+        s->wavefront[i].pos = 0;
+        s->jobs_ret[i] = 0;
+    }
+    s->next_row     = 0;
+    s->last_row_job = -1;
+    ctx->internal->execute(ctx, set_frame_slice, &td, s->jobs_ret, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (s->jobs_ret[i] < 0)
+            return s->jobs_ret[i];
+    return 0;
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
     int x, y, w, h, ret;
@@ -926,7 +1144,7 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    ret = set_frame_threaded(ctx, out, in, x, y, w, h);
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -959,6 +1177,31 @@ static int config_output(AVFilterLink *outlink)
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
+
+    if (!s->nb_threads) {
+        s->nb_threads = ff_filter_get_nb_threads(ctx);
+        if (s->nb_threads > 1) {
+            s->slice_caches = av_calloc(s->nb_threads - 1, sizeof(*s->slice_caches));
+            s->wavefront    = av_calloc(s->nb_threads,     sizeof(*s->wavefront));
+            s->jobs_ret     = av_calloc(s->nb_threads,     sizeof(*s->jobs_ret));
+            if (!s->slice_caches || !s->wavefront || !s->jobs_ret) {
+                av_freep(&s->slice_caches);
+                av_freep(&s->wavefront);
+                av_freep(&s->jobs_ret);
+                return AVERROR(ENOMEM);
+            }
+#if HAVE_THREADS
+            {
+                int i;
+                for (i = 0; i < s->nb_threads; i++) {
+                    pthread_mutex_init(&s->wavefront[i].lock, NULL);
+                    pthread_cond_init(&s->wavefront[i].cond, NULL);
+                }
+                pthread_mutex_init(&s->rows_lock, NULL);
+            }
+#endif
+        }
+    }
     return 0;
 }
 
@@ -977,6 +1220,20 @@ static int config_input_palette(AVFilterLink *inlink)
     return 0;
 }
 
+static void free_caches(PaletteUseContext *s)
+{
+    int i, j;
+
+    for (i = 0; i < CACHE_SIZE; i++)
+        av_freep(&s->cache[i].entries);
+    memset(s->cache, 0, sizeof(s->cache));
+    for (j = 0; s->slice_caches && j < s->nb_threads - 1; j++) {
+        for (i = 0; i < CACHE_SIZE; i++)
+            av_freep(&s->slice_caches[j][i].entries);
+        memset(s->slice_caches[j], 0, sizeof(s->slice_caches[j]));
+    }
+}
+
 static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
 {
     int i, x, y;
@@ -988,9 +1245,7 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        free_caches(s);
     }
 
     i = 0;
@@ -1042,9 +1297,11 @@ error:
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
 static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+                            int x_start, int y_start, int w, int h,             \
+                            int jobnr, int nb_jobs)                             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, out, in, x_start, y_start, w, h,                        \
+                     jobnr, nb_jobs, value, color_search);                      \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1087,6 +1344,7 @@ static av_cold int init(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     s->set_frame = set_frame_lut[s->color_search_method][s->dither];
+    ff_paletteuse_dsp_init(&s->dsp);
 
     if (s->dither == DITHERING_BAYER) {
         int i;
@@ -1099,6 +1357,14 @@ static av_cold int init(AVFilterContext *ctx)
     return 0;
 }
 
+void ff_paletteuse_dsp_init(PaletteUseDSPContext *dsp)
+{
+    dsp->nearest = nearest_c;
+
+    if (ARCH_X86)
+        ff_paletteuse_dsp_init_x86(dsp);
+}
+
 static int activate(AVFilterContext *ctx)
 {
     PaletteUseContext *s = ctx->priv;
@@ -1107,12 +1373,23 @@ static int activate(AVFilterContext *ctx)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    free_caches(s);
+    av_freep(&s->slice_caches);
+#if HAVE_THREADS
+    if (s->wavefront) {
+        int i;
+        for (i = 0; i < s->nb_threads; i++) {
+            pthread_mutex_destroy(&s->wavefront[i].lock);
+            pthread_cond_destroy(&s->wavefront[i].cond);
+        }
+        pthread_mutex_destroy(&s->rows_lock);
+    }
+#endif
+    av_freep(&s->wavefront);
+    av_freep(&s->jobs_ret);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1149,4 +1426,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -37,6 +37,7 @@
 #include "colorspace.h"
 #include "formats.h"
 #include "internal.h"
+#include "tonemap.h"
 #include "video.h"
 
 enum TonemapAlgorithm {
@@ -69,6 +70,8 @@ typedef struct TonemapContext {
     double peak;
 
     const struct LumaCoefficients *coeffs;
+
+    TonemapDSPContext dsp;
 } TonemapContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -104,6 +107,8 @@ static av_cold int init(AVFilterContext *ctx)
     if (isnan(s->param))
         s->param = 1.0f;
 
+    ff_tonemap_dsp_init(&s->dsp);
+
     return 0;
 }
 
@@ -191,6 +196,162 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
     *b_out *= sig / sig_orig;
 }
 
+/**
+ * Express the tone mapping as a TonemapCurve.
+ * Return 0 if the algorithm cannot be expressed that way.
+ */
+static int get_curve(TonemapContext *s, TonemapCurve *c, double peak)
+{
+    memset(c, 0, sizeof(*c));
+
+    c->coeff[0] = s->coeffs->cr;
+    c->coeff[1] = s->coeffs->cb;
+    c->coeff[2] = s->coeffs->cg;
+    c->desat    = FFMAX(s->desat, 0);
+    c->den[2]   = 1.0f;
+
+    switch (s->tonemap) {
+    case TONEMAP_NONE:
+        c->knee   = FLT_MAX;
+        break;
+    case TONEMAP_LINEAR:
+        c->num[1] = s->param / peak;
+        break;
+    case TONEMAP_REINHARD:
+        c->num[1] = (peak + s->param) / peak;
+        c->den[1] = 1.0f;
+        c->den[2] = s->param;
+        break;
+    case TONEMAP_HABLE: {
+        /* same constants as in hable() */
+        const float a = 0.15f, b = 0.50f, cc = 0.10f, d = 0.20f, e = 0.02f, f = 0.30f;
+        const float scale = 1.0f / hable(peak);
+        c->num[0] = a * scale;
+        c->num[1] = b * cc * scale;
+        c->num[2] = d * e * scale;
+        c->den[0] = a;
+        c->den[1] = b;
+        c->den[2] = d * f;
+        c->offset = -e / f * scale;
+        break;
+    }
+    case TONEMAP_MOBIUS: {
+        const float j = s->param;
+        float a, b;
+
+        a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+        b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+
+        c->knee   = j;
+        c->num[1] = (b * b + 2.0f * b * j + j * j) / (b - a);
+        c->num[2] = c->num[1] * a;
+        c->den[1] = 1.0f;
+        c->den[2] = b;
+        break;
+    }
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+static void tonemap_curve_c(float *dst0, float *dst1, float *dst2,
+                            const float *src0, const float *src1, const float *src2,
+                            int width, const TonemapCurve *c)
+{
+    int x;
+
+    for (x = 0; x < width; x++) {
+        float p0 = src0[x], p1 = src1[x], p2 = src2[x];
+        float sig, out;
+
+        /* desaturate to prevent unnatural colors */
+        if (c->desat > 0) {
+            float luma = c->coeff[0] * p0 + c->coeff[1] * p1 + c->coeff[2] * p2;
+            float overbright = FFMAX(luma - c->desat, 1e-6f) / FFMAX(luma, 1e-6f);
+            p0 = MIX(p0, luma, overbright);
+            p1 = MIX(p1, luma, overbright);
+            p2 = MIX(p2, luma, overbright);
+        }
+
+        sig = FFMAX(FFMAX3(p0, p1, p2), 1e-6f);
+        if (sig <= c->knee)
+            out = sig;
+        else
+            out = ((c->num[0] * sig + c->num[1]) * sig + c->num[2]) /
+                  ((c->den[0] * sig + c->den[1]) * sig + c->den[2]) + c->offset;
+
+        dst0[x] = p0 * (out / sig);
+        dst1[x] = p1 * (out / sig);
+        dst2[x] = p2 * (out / sig);
+    }
+}
+
+av_cold void ff_tonemap_dsp_init(TonemapDSPContext *dsp)
+{
+    dsp->tonemap_curve = tonemap_curve_c;
+
+    if (ARCH_X86)
+        ff_tonemap_dsp_init_x86(dsp);
+}
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    const AVPixFmtDescriptor *desc, *odesc;
+    double peak;
+    const TonemapCurve *curve;
+} ThreadData;
+
+static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TonemapContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    const int slice_start = (out->height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (out->height * (jobnr + 1)) / nb_jobs;
+    int x, y;
+
+    /* do the tone map */
+    for (y = slice_start; y < slice_end; y++) {
+        if (td->curve) {
+            const int w8 = out->width & ~7;
+            float *dst[3];
+            const float *src[3];
+            int p;
+
+            for (p = 0; p < 3; p++) {
+                dst[p] = (float *)(out->data[p] + y * out->linesize[p]);
+                src[p] = (const float *)(in->data[p] + y * in->linesize[p]);
+            }
+            s->dsp.tonemap_curve(dst[0], dst[1], dst[2], src[0], src[1], src[2],
+                                 w8, td->curve);
+            tonemap_curve_c(dst[0] + w8, dst[1] + w8, dst[2] + w8,
+                            src[0] + w8, src[1] + w8, src[2] + w8,
+                            out->width - w8, td->curve);
+        } else {
+            for (x = 0; x < out->width; x++)
+                tonemap(s, out, in, td->desc, x, y, td->peak);
+        }
+    }
+
+    /* copy/generate alpha if needed */
+    if (td->desc->flags & AV_PIX_FMT_FLAG_ALPHA && td->odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        av_image_copy_plane(out->data[3] + slice_start * out->linesize[3], out->linesize[3],
+                            in->data[3] + slice_start * in->linesize[3], in->linesize[3],
+                            out->linesize[3], slice_end - slice_start);
+    } else if (td->odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        for (y = slice_start; y < slice_end; y++) {
+            for (x = 0; x < out->width; x++) {
+                AV_WN32(out->data[3] + x * td->odesc->comp[3].step + y * out->linesize[3],
+                        av_float2int(1.0f));
+            }
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     TonemapContext *s = link->dst->priv;
@@ -198,7 +359,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     AVFrame *out;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
-    int ret, x, y;
+    AVFilterContext *ctx = link->dst;
+    ThreadData td;
+    TonemapCurve curve;
+    int ret;
     double peak = s->peak;
 
     if (!desc || !odesc) {
@@ -244,24 +408,14 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         s->desat = 0;
     }
 
-    /* do the tone map */
-    for (y = 0; y < out->height; y++)
-        for (x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
-
-    /* copy/generate alpha if needed */
-    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        av_image_copy_plane(out->data[3], out->linesize[3],
-                            in->data[3], in->linesize[3],
-                            out->linesize[3], outlink->h);
-    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        for (y = 0; y < out->height; y++) {
-            for (x = 0; x < out->width; x++) {
-                AV_WN32(out->data[3] + x * odesc->comp[3].step + y * out->linesize[3],
-                        av_float2int(1.0f));
-            }
-        }
-    }
+    td.in    = in;
+    td.out   = out;
+    td.desc  = desc;
+    td.odesc = odesc;
+    td.peak  = peak;
+    td.curve = get_curve(s, &curve, peak) ? &curve : NULL;
+    ctx->internal->execute(ctx, tonemap_slice, &td, NULL,
+                           FFMIN(outlink->h, ff_filter_get_nb_threads(ctx)));
 
     av_frame_free(&in);
 
@@ -321,4 +475,5 @@ AVFilter ff_vf_tonemap = {
     .priv_class      = &tonemap_class,
     .inputs          = tonemap_inputs,
     .outputs         = tonemap_outputs,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
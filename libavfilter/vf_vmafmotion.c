@@ -129,18 +129,19 @@ static void convolution_x(const uint16_t *filter, int filt_w, const uint16_t *sr
 static void convolution_y_##bits##bit(const uint16_t *filter, int filt_w, \
                                       const uint8_t *_src, uint16_t *dst, \
                                       int w, int h, ptrdiff_t _src_stride, \
-                                      ptrdiff_t _dst_stride) \
+                                      ptrdiff_t _dst_stride, \
+                                      int y_start, int y_end) \
 { \
     const type *src = (const type *) _src; \
     ptrdiff_t src_stride = _src_stride / sizeof(*src); \
     ptrdiff_t dst_stride = _dst_stride / sizeof(*dst); \
     int radius = filt_w / 2; \
-    int borders_top = radius; \
-    int borders_bottom = h - (filt_w - radius); \
+    int borders_top = FFMIN(radius, y_end); \
+    int borders_bottom = FFMAX(h - (filt_w - radius), borders_top); \
     int i, j, k; \
     int sum = 0; \
     \
-    for (i = 0; i < borders_top; i++) { \
+    for (i = y_start; i < borders_top; i++) { \
         for (j = 0; j < w; j++) { \
             sum = 0; \
             for (k = 0; k < filt_w; k++) { \
@@ -153,7 +154,7 @@ static void convolution_y_##bits##bit(const uint16_t *filter, int filt_w, \
             dst[i * dst_stride + j] = sum >> bits; \
         } \
     } \
-    for (i = borders_top; i < borders_bottom; i++) { \
+    for (i = FFMAX(borders_top, y_start); i < FFMIN(borders_bottom, y_end); i++) { \
         for (j = 0; j < w; j++) { \
             sum = 0; \
             for (k = 0; k < filt_w; k++) { \
@@ -162,7 +163,7 @@ static void convolution_y_##bits##bit(const uint16_t *filter, int filt_w, \
             dst[i * dst_stride + j] = sum >> bits; \
         } \
     } \
-    for (i = borders_bottom; i < h; i++) { \
+    for (i = FFMAX(borders_bottom, y_start); i < y_end; i++) { \
         for (j = 0; j < w; j++) { \
             sum = 0; \
             for (k = 0; k < filt_w; k++) { \
@@ -186,20 +187,51 @@ static void vmafmotiondsp_init(VMAFMotionDSPContext *dsp, int bpp) {
     dsp->sad = image_sad;
 }
 
-double ff_vmafmotion_process(VMAFMotionData *s, AVFrame *ref)
+typedef struct ThreadData {
+    VMAFMotionData *s;
+    AVFrame *ref;
+} ThreadData;
+
+static int vmafmotion_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    ThreadData *td = arg;
+    VMAFMotionData *s = td->s;
+    const int slice_start = (s->height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (s->height * (jobnr + 1)) / nb_jobs;
+    const ptrdiff_t offset = slice_start * s->stride;
+
+    s->vmafdsp.convolution_y(s->filter, 5, td->ref->data[0], s->temp_data,
+                             s->width, s->height, td->ref->linesize[0], s->stride,
+                             slice_start, slice_end);
+    s->vmafdsp.convolution_x(s->filter, 5,
+                             (uint16_t *)((uint8_t *)s->temp_data + offset),
+                             (uint16_t *)((uint8_t *)s->blur_data[0] + offset),
+                             s->width, slice_end - slice_start, s->stride, s->stride);
+
+    if (s->nb_frames)
+        s->sad[jobnr] = s->vmafdsp.sad((uint16_t *)((uint8_t *)s->blur_data[1] + offset),
+                                       (uint16_t *)((uint8_t *)s->blur_data[0] + offset),
+                                       s->width, slice_end - slice_start,
+                                       s->stride, s->stride);
+    return 0;
+}
+
+double ff_vmafmotion_process(AVFilterContext *ctx, VMAFMotionData *s, AVFrame *ref)
+{
+    ThreadData td = { .s = s, .ref = ref };
+    const int nb_jobs = FFMIN(s->height, s->nb_threads);
     double score;
+    int i;
 
-    s->vmafdsp.convolution_y(s->filter, 5, ref->data[0], s->temp_data,
-                             s->width, s->height, ref->linesize[0], s->stride);
-    s->vmafdsp.convolution_x(s->filter, 5, s->temp_data, s->blur_data[0],
-                             s->width, s->height, s->stride, s->stride);
+    ctx->internal->execute(ctx, vmafmotion_slice, &td, NULL, nb_jobs);
 
     if (!s->nb_frames) {
         score = 0.0;
     } else {
-        uint64_t sad = s->vmafdsp.sad(s->blur_data[1], s->blur_data[0],
-                                      s->width, s->height, s->stride, s->stride);
+        uint64_t sad = 0;
+
+        for (i = 0; i < nb_jobs; i++)
+            sad += s->sad[i];
         // the output score is always normalized to 8 bits
         score = (double) (sad * 1.0 / (s->width * s->height << (BIT_SHIFT - 8)));
     }
@@ -223,7 +255,7 @@ static void do_vmafmotion(AVFilterContext *ctx, AVFrame *ref)
     VMAFMotionContext *s = ctx->priv;
     double score;
 
-    score = ff_vmafmotion_process(&s->data, ref);
+    score = ff_vmafmotion_process(ctx, &s->data, ref);
     set_meta(&ref->metadata, "lavfi.vmafmotion.score", score);
     if (s->stats_file) {
         fprintf(s->stats_file,
@@ -233,7 +265,7 @@ static void do_vmafmotion(AVFilterContext *ctx, AVFrame *ref)
 
 
 int ff_vmafmotion_init(VMAFMotionData *s,
-                       int w, int h, enum AVPixelFormat fmt)
+                       int w, int h, enum AVPixelFormat fmt, int nb_threads)
 {
     size_t data_sz;
     int i;
@@ -246,9 +278,11 @@ int ff_vmafmotion_init(VMAFMotionData *s,
     data_sz = (size_t) s->stride * h;
     if (!(s->blur_data[0] = av_malloc(data_sz)) ||
         !(s->blur_data[1] = av_malloc(data_sz)) ||
-        !(s->temp_data    = av_malloc(data_sz))) {
+        !(s->temp_data    = av_malloc(data_sz)) ||
+        !(s->sad          = av_calloc(nb_threads, sizeof(*s->sad)))) {
         return AVERROR(ENOMEM);
     }
+    s->nb_threads = nb_threads;
 
     for (i = 0; i < 5; i++) {
         s->filter[i] = lrint(FILTER_5[i] * (1 << BIT_SHIFT));
@@ -283,7 +317,8 @@ static int config_input_ref(AVFilterLink *inlink)
     VMAFMotionContext *s = ctx->priv;
 
     return ff_vmafmotion_init(&s->data, ctx->inputs[0]->w,
-                              ctx->inputs[0]->h, ctx->inputs[0]->format);
+                              ctx->inputs[0]->h, ctx->inputs[0]->format,
+                              ff_filter_get_nb_threads(ctx));
 }
 
 double ff_vmafmotion_uninit(VMAFMotionData *s)
@@ -291,6 +326,7 @@ double ff_vmafmotion_uninit(VMAFMotionData *s)
     av_free(s->blur_data[0]);
     av_free(s->blur_data[1]);
     av_free(s->temp_data);
+    av_freep(&s->sad);
 
     return s->nb_frames > 0 ? s->motion_sum / s->nb_frames : 0.0;
 }
@@ -366,4 +402,5 @@ AVFilter ff_vf_vmafmotion = {
     .priv_class    = &vmafmotion_class,
     .inputs        = vmafmotion_inputs,
     .outputs       = vmafmotion_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
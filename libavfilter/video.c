@@ -87,6 +87,10 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
         }
     }
 
+    if (link->graph && link->graph->shared_buffer_pool &&
+        ff_frame_pool_set_shared(link->frame_pool, link->graph->shared_buffer_pool) < 0)
+        return NULL;
+
     frame = ff_frame_pool_get(link->frame_pool);
     if (!frame)
         return NULL;
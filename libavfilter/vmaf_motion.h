@@ -32,9 +32,12 @@ typedef struct VMAFMotionDSPContext {
     void (*convolution_x)(const uint16_t *filter, int filt_w, const uint16_t *src,
                           uint16_t *dst, int w, int h, ptrdiff_t src_stride,
                           ptrdiff_t dst_stride);
+    /**
+     * Filter the rows y_start to y_end - 1 of a plane of height h.
+     */
     void (*convolution_y)(const uint16_t *filter, int filt_w, const uint8_t *src,
                           uint16_t *dst, int w, int h, ptrdiff_t src_stride,
-                          ptrdiff_t dst_stride);
+                          ptrdiff_t dst_stride, int y_start, int y_end);
 } VMAFMotionDSPContext;
 
 void ff_vmafmotion_init_x86(VMAFMotionDSPContext *dsp);
@@ -46,13 +49,16 @@ typedef struct VMAFMotionData {
     ptrdiff_t stride;
     uint16_t *blur_data[2 /* cur, prev */];
     uint16_t *temp_data;
+    uint64_t *sad;      ///< per slice sum of absolute differences
+    int nb_threads;
     double motion_sum;
     uint64_t nb_frames;
     VMAFMotionDSPContext vmafdsp;
 } VMAFMotionData;
 
-int ff_vmafmotion_init(VMAFMotionData *data, int w, int h, enum AVPixelFormat fmt);
-double ff_vmafmotion_process(VMAFMotionData *data, AVFrame *frame);
+int ff_vmafmotion_init(VMAFMotionData *data, int w, int h, enum AVPixelFormat fmt,
+                       int nb_threads);
+double ff_vmafmotion_process(AVFilterContext *ctx, VMAFMotionData *data, AVFrame *frame);
 double ff_vmafmotion_uninit(VMAFMotionData *data);
 
 #endif /* AVFILTER_VMAF_MOTION_H */
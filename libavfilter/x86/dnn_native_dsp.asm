@@ -0,0 +1,137 @@
+;*****************************************************************************
+;* x86-optimized functions for the native DNN backend
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+;------------------------------------------------------------------------------
+; void ff_dnn_conv_accumulate(float *dst, const float *src, const float *kernel,
+;                             int src_len, int dst_len)
+;------------------------------------------------------------------------------
+
+INIT_YMM fma3
+cglobal dnn_conv_accumulate, 5, 8, 5, dst, src, kernel, src_len, dst_len, k, i, cnt
+    movsxdifnidn src_lenq, src_lend
+    movsxdifnidn dst_lenq, dst_lend
+    lea           srcq, [srcq + src_lenq * 4]
+    neg       src_lenq
+    mov           cntq, dst_lenq
+    shl       dst_lenq, 2 ; kernel row stride
+
+    ; 32 outputs per pass while possible, then 8
+    sub           cntq, 32
+    jl .tail
+.loop32:
+    movu            m0, [dstq + 0 * mmsize]
+    movu            m1, [dstq + 1 * mmsize]
+    movu            m2, [dstq + 2 * mmsize]
+    movu            m3, [dstq + 3 * mmsize]
+    mov             kq, kernelq
+    mov             iq, src_lenq
+.inner32:
+    vbroadcastss    m4, [srcq + iq * 4]
+    fmaddps         m0, m4, [kq + 0 * mmsize], m0
+    fmaddps         m1, m4, [kq + 1 * mmsize], m1
+    fmaddps         m2, m4, [kq + 2 * mmsize], m2
+    fmaddps         m3, m4, [kq + 3 * mmsize], m3
+    add             kq, dst_lenq
+    inc             iq
+    jl .inner32
+    movu [dstq + 0 * mmsize], m0
+    movu [dstq + 1 * mmsize], m1
+    movu [dstq + 2 * mmsize], m2
+    movu [dstq + 3 * mmsize], m3
+    add           dstq, 4 * mmsize
+    add        kernelq, 4 * mmsize
+    sub           cntq, 32
+    jge .loop32
+.tail:
+    add           cntq, 32
+    jz .end
+.loop8:
+    movu            m0, [dstq]
+    mov             kq, kernelq
+    mov             iq, src_lenq
+.inner8:
+    vbroadcastss    m4, [srcq + iq * 4]
+    fmaddps         m0, m4, [kq], m0
+    add             kq, dst_lenq
+    inc             iq
+    jl .inner8
+    movu        [dstq], m0
+    add           dstq, mmsize
+    add        kernelq, mmsize
+    sub           cntq, 8
+    jg .loop8
+.end:
+    RET
+%endif
+
+;------------------------------------------------------------------------------
+; float ff_dnn_dot_product(const float *a, const float *b, int len)
+;------------------------------------------------------------------------------
+
+INIT_YMM fma3
+cglobal dnn_dot_product, 3, 4, 4, a, b, len, i
+    movsxdifnidn  lenq, lend
+    xorps           m0, m0
+    xorps           m1, m1
+    mov             iq, lenq
+    and             iq, ~15
+    jz .reduce
+    shl             iq, 2
+    add             aq, iq
+    add             bq, iq
+    neg             iq
+.loop:
+    movu            m2, [aq + iq]
+    movu            m3, [aq + iq + mmsize]
+    fmaddps         m0, m2, [bq + iq], m0
+    fmaddps         m1, m3, [bq + iq + mmsize], m1
+    add             iq, 2 * mmsize
+    jl .loop
+.reduce:
+    addps           m0, m1
+    vextractf128   xm1, m0, 1
+    addps          xm0, xm1
+    movhlps        xm1, xm0
+    addps          xm0, xm1
+    movshdup       xm1, xm0
+    addss          xm0, xm1
+
+    ; the remaining len % 16 products one at a time
+    and           lend, 15
+    jz .end
+.tail:
+    movss          xm1, [aq]
+    mulss          xm1, [bq]
+    addss          xm0, xm1
+    add             aq, 4
+    add             bq, 4
+    dec           lend
+    jg .tail
+.end:
+%if ARCH_X86_64 == 0
+    movss          r0m, xm0
+    fld      dword r0m
+%endif
+    RET
@@ -0,0 +1,38 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/dnn_native_dsp.h"
+
+void ff_dnn_conv_accumulate_fma3(float *dst, const float *src, const float *kernel,
+                                 int src_len, int dst_len);
+float ff_dnn_dot_product_fma3(const float *a, const float *b, int len);
+
+av_cold void ff_dnn_native_dsp_init_x86(DNNNativeDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_FMA3_FAST(cpu_flags)) {
+        if (ARCH_X86_64)
+            dsp->conv_accumulate = ff_dnn_conv_accumulate_fma3;
+        dsp->dot_product = ff_dnn_dot_product_fma3;
+    }
+}
@@ -0,0 +1,102 @@
+;*****************************************************************************
+;* x86-optimized functions for paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_0to7: dd 0, 1, 2, 3, 4, 5, 6, 7
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; int ff_paletteuse_nearest(const int16_t *rg, const int16_t *b, int nb_entries,
+;                           int r, int g, int b_)
+;
+; The squared distance of each entry is shifted left by 8 and its index put
+; in the low bits, so a plain minimum gives the first of the nearest entries.
+; The distances are at most 3 * PALETTEUSE_PAD_VALUE^2, which leaves room for
+; that in 31 bits.
+;------------------------------------------------------------------------------
+
+%macro NEAREST 0
+cglobal paletteuse_nearest, 6, 6, 7, rg, b, n, tr, tg, tb
+    shl          tgd, 16
+    or           trd, tgd
+    movd         xm0, trd                       ; r, g
+    movd         xm1, tbd                       ; b, 0
+%if cpuflag(avx2)
+    vpbroadcastd  m0, xm0
+    vpbroadcastd  m1, xm1
+%else
+    pshufd        m0, m0, 0
+    pshufd        m1, m1, 0
+%endif
+    mova          m2, [pd_0to7]                 ; entry indices
+    pcmpeqd       m3, m3
+    psrld         m3, 1                         ; running minimum, INT_MAX
+    pcmpeqd       m5, m5
+    psrld         m5, 31
+%if mmsize == 32
+    pslld         m5, 3                         ; 8 entries per iteration
+%else
+    pslld         m5, 2                         ; 4 entries per iteration
+%endif
+    movsxdifnidn  nq, nd
+    shl           nq, 2
+    add          rgq, nq
+    add           bq, nq
+    neg           nq
+
+.loop:
+    movu          m4, [rgq+nq]
+    movu          m6, [bq+nq]
+    psubw         m4, m0
+    psubw         m6, m1
+    pmaddwd       m4, m4                        ; dr*dr + dg*dg
+    pmaddwd       m6, m6                        ; db*db
+    paddd         m4, m6
+    pslld         m4, 8
+    por           m4, m2
+    pminsd        m3, m4
+    paddd         m2, m5
+    add           nq, mmsize
+    jl .loop
+
+%if mmsize == 32
+    vextracti128 xm4, m3, 1
+    pminsd       xm3, xm4
+%endif
+    pshufd       xm4, xm3, q1032
+    pminsd       xm3, xm4
+    pshufd       xm4, xm3, q2301
+    pminsd       xm3, xm4
+    movd         eax, xm3
+    and          eax, 0xff
+    RET
+%endmacro
+
+INIT_XMM sse4
+NEAREST
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+NEAREST
+%endif
@@ -22,11 +22,13 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
+ssim_c1: times 8 dd 416 ;(.01*.01*255*255*64 + .5)
+ssim_c2: times 8 dd 235963 ;(.03*.03*255*255*64*63 + .5)
+; index of the block in each dword of the avx2 ssim_end_line
+pd_ssim_blocks: dd 0, 2, 4, 6, 1, 3, 5, 7
 pw_1: times 8 dw 1
-ssim_c1: times 4 dd 416 ;(.01*.01*255*255*64 + .5)
-ssim_c2: times 4 dd 235963 ;(.03*.03*255*255*64*63 + .5)
 
 SECTION .text
 
@@ -168,6 +170,64 @@ INIT_XMM xop
 SSIM_4X4_LINE 8
 %endif
 
+%macro SSIM_4X4_ROW 2 ; buf offset, ref offset
+    pmovzxbw          m4, [bufq+%1]
+    pmovzxbw          m5, [refq+%2]
+    paddw             m0, m4                    ; s1
+    paddw             m1, m5                    ; s2
+    pmaddwd           m6, m4, m5                ; a * b
+    pmaddwd           m4, m4                    ; a * a
+    pmaddwd           m5, m5                    ; b * b
+    paddd             m3, m6                    ; s12
+    paddd             m2, m4
+    paddd             m2, m5                    ; ss
+%endmacro
+
+; 4 blocks per iteration, the sums of two of them in each lane
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal ssim_4x4_line, 6, 8, 8, buf, buf_stride, ref, ref_stride, sums, w, buf_stride3, ref_stride3
+    lea     ref_stride3q, [ref_strideq*3]
+    lea     buf_stride3q, [buf_strideq*3]
+    pcmpeqw           m7, m7
+    psrlw             m7, 15                    ; pw_1
+
+.loop:
+    pxor              m0, m0
+    pxor              m1, m1
+    pxor              m2, m2
+    pxor              m3, m3
+    SSIM_4X4_ROW buf_strideq*0, ref_strideq*0
+    SSIM_4X4_ROW buf_strideq*1, ref_strideq*1
+    SSIM_4X4_ROW buf_strideq*2, ref_strideq*2
+    SSIM_4X4_ROW buf_stride3q,  ref_stride3q
+
+    ; m0 = [word] s1 a,a,a,a,b,b,b,b | c,c,c,c,d,d,d,d
+    ; m1 = [word] s2 a,a,a,a,b,b,b,b | c,c,c,c,d,d,d,d
+    ; m2 = [dword] ss a,a,b,b | c,c,d,d
+    ; m3 = [dword] s12 a,a,b,b | c,c,d,d
+    pmaddwd           m0, m7                    ; [dword] s1 a,a,b,b | c,c,d,d
+    pmaddwd           m1, m7                    ; [dword] s2 a,a,b,b | c,c,d,d
+    phaddd            m0, m2                    ; [dword] s1 a, b, ss a, b | c, d
+    phaddd            m1, m3                    ; [dword] s2 a, b, s12 a, b | c, d
+    punpckhdq     m2, m0, m1                    ; [dword] ss a, s12 a, ss b, s12 b | c, d
+    punpckldq         m0, m1                    ; [dword] s1 a, s2 a, s1 b, s2 b | c, d
+    punpckhqdq    m1, m0, m2                    ; [dword] b s1, s2, ss, s12 | d
+    punpcklqdq        m0, m2                    ; [dword] a s1, s2, ss, s12 | c
+    vperm2i128        m2, m0, m1, 0x20          ; a, b
+    vperm2i128        m3, m0, m1, 0x31          ; c, d
+
+    movu  [sumsq+     0], m2
+    movu  [sumsq+mmsize], m3
+
+    add             bufq, mmsize/2
+    add             refq, mmsize/2
+    add            sumsq, mmsize*2
+    sub               wd, mmsize/8
+    jg .loop
+    RET
+%endif
+
 INIT_XMM sse4
 cglobal ssim_end_line, 3, 3, 6, sum0, sum1, w
     pxor              m0, m0
@@ -245,3 +305,81 @@ cglobal ssim_end_line, 3, 3, 6, sum0, sum1, w
     fld             r0mp
 %endif
     RET
+
+; 8 blocks per iteration, the even ones in the low lanes and the odd ones in
+; the high lanes. The blocks past w are masked out, so the sums arrays must
+; have room for w rounded up to 8, plus one.
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal ssim_end_line, 3, 3, 10, sum0, sum1, w
+    xorps             m8, m8
+    mova              m9, [pd_ssim_blocks]
+.loop:
+    movu              m0, [sum0q+mmsize*0]
+    movu              m1, [sum0q+mmsize*1]
+    movu              m2, [sum0q+mmsize*2]
+    movu              m3, [sum0q+mmsize*3]
+    paddd             m0, [sum1q+mmsize*0]
+    paddd             m1, [sum1q+mmsize*1]
+    paddd             m2, [sum1q+mmsize*2]
+    paddd             m3, [sum1q+mmsize*3]
+    paddd             m0, [sum0q+mmsize*0+16]
+    paddd             m1, [sum0q+mmsize*1+16]
+    paddd             m2, [sum0q+mmsize*2+16]
+    paddd             m3, [sum0q+mmsize*3+16]
+    paddd             m0, [sum1q+mmsize*0+16]
+    paddd             m1, [sum1q+mmsize*1+16]
+    paddd             m2, [sum1q+mmsize*2+16]
+    paddd             m3, [sum1q+mmsize*3+16]
+    punpckldq         m4, m0, m1
+    punpckhdq         m5, m0, m1
+    punpckldq         m6, m2, m3
+    punpckhdq         m7, m2, m3
+    punpcklqdq        m0, m4, m6                ; fs1
+    punpckhqdq        m1, m4, m6                ; fs2
+    punpcklqdq        m2, m5, m7                ; fss
+    punpckhqdq        m3, m5, m7                ; fs12
+
+    pslld             m2, 6
+    pslld             m3, 6
+    pmulld            m4, m0, m1                ; fs1 * fs2
+    pmulld            m0, m0                    ; fs1 * fs1
+    pmulld            m1, m1                    ; fs2 * fs2
+    psubd             m2, m0
+    psubd             m3, m4                    ; covariance
+    psubd             m2, m1                    ; variance
+
+    paddd             m3, m3                    ; 2 * covariance
+    paddd             m4, m4                    ; 2 * fs1 * fs2
+    paddd             m0, m1                    ; fs1 * fs1 + fs2 * fs2
+    paddd             m2, [ssim_c2]             ; variance + ssim_c2
+    paddd             m3, [ssim_c2]             ; 2 * covariance + ssim_c2
+    paddd             m4, [ssim_c1]             ; 2 * fs1 * fs2 + ssim_c1
+    paddd             m0, [ssim_c1]             ; fs1 * fs1 + fs2 * fs2 + ssim_c1
+
+    cvtdq2ps          m2, m2
+    cvtdq2ps          m3, m3
+    cvtdq2ps          m4, m4
+    cvtdq2ps          m0, m0
+    mulps             m3, m4
+    mulps             m2, m0
+    divps             m3, m2                    ; ssim_endl
+
+    movd             xm5, wd
+    vpbroadcastd      m5, xm5
+    pcmpgtd           m5, m9                    ; blocks before w
+    andps             m3, m5
+    addps             m8, m3                    ; ssim
+    add            sum0q, mmsize*4
+    add            sum1q, mmsize*4
+    sub               wd, 8
+    jg .loop
+
+    vextractf128     xm0, m8, 1
+    addps            xm8, xm0
+    movhlps          xm0, xm8
+    addps            xm8, xm0
+    movshdup         xm0, xm8
+    addss            xm0, xm8
+    RET
+%endif
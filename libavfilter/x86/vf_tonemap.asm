@@ -0,0 +1,145 @@
+;*****************************************************************************
+;* x86-optimized functions for tonemap filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+%if ARCH_X86_64
+
+SECTION_RODATA 32
+
+pf_eps: times 8 dd 1.0e-6
+pf_1:   times 8 dd 1.0
+
+; offsets in TonemapCurve
+%define CURVE_COEFF0  0
+%define CURVE_COEFF1  4
+%define CURVE_COEFF2  8
+%define CURVE_DESAT  12
+%define CURVE_KNEE   16
+%define CURVE_NUM0   20
+%define CURVE_NUM1   24
+%define CURVE_NUM2   28
+%define CURVE_DEN0   32
+%define CURVE_DEN1   36
+%define CURVE_DEN2   40
+%define CURVE_OFFSET 44
+
+SECTION .text
+
+; m6 = eps, m7 = 1.0, m8 = knee, m9-m11 = num, m12-m14 = den, m15 = offset;
+; the luma coefficients and desat are kept on the stack
+%macro TONEMAP_ROW 1 ; desat
+.loop%1:
+    movu          m0, [src0q + wq]
+    movu          m1, [src1q + wq]
+    movu          m2, [src2q + wq]
+%if %1
+    ; p = p * (1 - overbright) + luma * overbright
+    mulps         m3, m0, [rsp + 0 * mmsize]
+    fmaddps       m3, m1, [rsp + 1 * mmsize], m3
+    fmaddps       m3, m2, [rsp + 2 * mmsize], m3
+    subps         m4, m3, [rsp + 3 * mmsize]
+    maxps         m4, m4, m6
+    maxps         m5, m3, m6
+    divps         m4, m5
+    subps         m5, m7, m4
+    mulps         m3, m4
+    fmaddps       m0, m0, m5, m3
+    fmaddps       m1, m1, m5, m3
+    fmaddps       m2, m2, m5, m3
+%endif
+    ; scale the pixel by curve(sig) / sig
+    maxps         m3, m0, m1
+    maxps         m3, m2
+    maxps         m3, m6
+    mova          m4, m9
+    fmaddps       m4, m4, m3, m10
+    fmaddps       m4, m4, m3, m11
+    mova          m5, m12
+    fmaddps       m5, m5, m3, m13
+    fmaddps       m5, m5, m3, m14
+    divps         m4, m5
+    addps         m4, m15
+    cmpps         m5, m3, m8, 14 ; sig > knee
+    blendvps      m4, m3, m4, m5
+    divps         m4, m3
+    mulps         m0, m4
+    mulps         m1, m4
+    mulps         m2, m4
+    movu [dst0q + wq], m0
+    movu [dst1q + wq], m1
+    movu [dst2q + wq], m2
+    add           wq, mmsize
+    jl .loop%1
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_tonemap_curve(float *dst0, float *dst1, float *dst2,
+;                       const float *src0, const float *src1, const float *src2,
+;                       int width, const TonemapCurve *c)
+;------------------------------------------------------------------------------
+
+INIT_YMM fma3
+cglobal tonemap_curve, 8, 8, 16, 4 * mmsize, dst0, dst1, dst2, src0, src1, src2, w, c
+    movsxdifnidn  wq, wd
+    test          wq, wq
+    jz .end
+    shl           wq, 2
+    add        dst0q, wq
+    add        dst1q, wq
+    add        dst2q, wq
+    add        src0q, wq
+    add        src1q, wq
+    add        src2q, wq
+    neg           wq
+
+    mova          m6, [pf_eps]
+    mova          m7, [pf_1]
+    vbroadcastss  m8, [cq + CURVE_KNEE]
+    vbroadcastss  m9, [cq + CURVE_NUM0]
+    vbroadcastss m10, [cq + CURVE_NUM1]
+    vbroadcastss m11, [cq + CURVE_NUM2]
+    vbroadcastss m12, [cq + CURVE_DEN0]
+    vbroadcastss m13, [cq + CURVE_DEN1]
+    vbroadcastss m14, [cq + CURVE_DEN2]
+    vbroadcastss m15, [cq + CURVE_OFFSET]
+
+    movss        xm0, [cq + CURVE_DESAT]
+    xorps        xm1, xm1
+    comiss       xm0, xm1
+    jbe .nodesat
+
+    vbroadcastss  m0, [cq + CURVE_COEFF0]
+    vbroadcastss  m1, [cq + CURVE_COEFF1]
+    vbroadcastss  m2, [cq + CURVE_COEFF2]
+    vbroadcastss  m3, [cq + CURVE_DESAT]
+    mova [rsp + 0 * mmsize], m0
+    mova [rsp + 1 * mmsize], m1
+    mova [rsp + 2 * mmsize], m2
+    mova [rsp + 3 * mmsize], m3
+    TONEMAP_ROW 1
+    RET
+
+.nodesat:
+    TONEMAP_ROW 0
+.end:
+    RET
+
+%endif ; ARCH_X86_64
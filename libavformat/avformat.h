@@ -1494,6 +1494,13 @@ typedef struct AVFormatContext {
 #define AVFMT_FLAG_FAST_SEEK   0x80000 ///< Enable fast, but inaccurate seeks for some formats
 #define AVFMT_FLAG_SHORTEST   0x100000 ///< Stop muxing when the shortest stream stops.
 #define AVFMT_FLAG_AUTO_BSF   0x200000 ///< Add bitstream filters as requested by the muxer
+/**
+ * Make avformat_find_stream_info() take the codec parameters from the
+ * parsers instead of decoding frames where possible, and return as soon as
+ * every stream not discarded with AVDISCARD_ALL has them, without analyzing
+ * more frames for the frame rate and decoding delay.
+ */
+#define AVFMT_FLAG_FAST_PROBE 0x400000
 
     /**
      * Maximum size of the data read from input for determining
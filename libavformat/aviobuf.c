@@ -22,10 +22,12 @@
 #include "libavutil/bprint.h"
 #include "libavutil/crc.h"
 #include "libavutil/dict.h"
+#include "libavutil/fifo.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
 #include "libavutil/opt.h"
 #include "libavutil/avassert.h"
+#include "libavutil/thread.h"
 #include "avformat.h"
 #include "avio.h"
 #include "avio_internal.h"
@@ -42,8 +44,16 @@
  */
 #define SHORT_SEEK_THRESHOLD 4096
 
+/**
+ * Largest single protocol call issued by the read-ahead / write-behind
+ * thread. Write-behind coalesces the queued buffers into calls of up to
+ * this size.
+ */
+#define ASYNC_CHUNK_SIZE (256 * 1024)
+
 typedef struct AVIOInternal {
     URLContext *h;
+    struct IOAsync *async;
 } AVIOInternal;
 
 static void *ff_avio_child_next(void *obj, void *prev)
@@ -938,27 +948,414 @@ uint64_t ffio_read_varlen(AVIOContext *bc){
     return val;
 }
 
+#if HAVE_THREADS
+/**
+ * Background read-ahead or write-behind state. While the worker thread is
+ * running it is the only one calling into the URLContext; the AVIOContext
+ * callbacks only move data in and out of the FIFO and post seek requests.
+ */
+typedef struct IOAsync {
+    URLContext      *h;
+    AVIOInterruptCB  interrupt_callback; ///< original callback of h
+    AVFifoBuffer    *fifo;
+    uint8_t         *chunk;
+    int              chunk_size;
+    int              write;
+    int64_t          pos;            ///< logical read position (FIFO read end)
+    int              eof;
+    int              io_error;
+    int              quit;
+    int              short_seek;     ///< ffurl_get_short_seek(), updated by the worker
+
+    int              seek_request;
+    int64_t          seek_offset;
+    int              seek_whence;
+    int64_t          seek_ret;
+
+    pthread_mutex_t  mutex;
+    pthread_cond_t   cond_wakeup_main;
+    pthread_cond_t   cond_wakeup_worker;
+    pthread_t        worker;
+} IOAsync;
+
+static int io_async_check_interrupt(void *arg)
+{
+    IOAsync *a = arg;
+
+    /* pending writes are always drained, only read-ahead is abandoned */
+    if (a->quit && !a->write)
+        return 1;
+    return ff_check_interrupt(&a->interrupt_callback);
+}
+
+static void *io_async_worker(void *arg)
+{
+    IOAsync *a = arg;
+    int ret, short_seek;
+
+    pthread_mutex_lock(&a->mutex);
+    for (;;) {
+        int fifo_size = av_fifo_size(a->fifo);
+
+        if (a->seek_request && (!a->write || !fifo_size || a->io_error)) {
+            int64_t offset = a->seek_offset;
+            int whence     = a->seek_whence;
+            int64_t pos;
+
+            int short_seek;
+
+            pthread_mutex_unlock(&a->mutex);
+            pos = ffurl_seek(a->h, offset, whence);
+            short_seek = ffurl_get_short_seek(a->h);
+            pthread_mutex_lock(&a->mutex);
+
+            a->short_seek = short_seek;
+
+            if (pos >= 0 && !(whence & AVSEEK_SIZE)) {
+                av_fifo_reset(a->fifo);
+                a->pos      = pos;
+                a->eof      = 0;
+                a->io_error = 0;
+            }
+            a->seek_ret     = pos;
+            a->seek_request = 0;
+            pthread_cond_signal(&a->cond_wakeup_main);
+            continue;
+        }
+
+        if (a->write) {
+            int len = FFMIN(fifo_size, a->chunk_size);
+
+            if (!len || a->io_error) {
+                if (a->quit)
+                    break;
+                pthread_cond_wait(&a->cond_wakeup_worker, &a->mutex);
+                continue;
+            }
+
+            av_fifo_generic_read(a->fifo, a->chunk, len, NULL);
+            pthread_cond_signal(&a->cond_wakeup_main);
+            pthread_mutex_unlock(&a->mutex);
+            ret = ffurl_write(a->h, a->chunk, len);
+            short_seek = ffurl_get_short_seek(a->h);
+            pthread_mutex_lock(&a->mutex);
+
+            a->short_seek = short_seek;
+
+            if (ret < 0) {
+                a->io_error = ret;
+                pthread_cond_signal(&a->cond_wakeup_main);
+            }
+        } else {
+            int len = FFMIN(av_fifo_space(a->fifo), a->chunk_size);
+
+            if (a->quit)
+                break;
+            if (!len || a->eof || a->io_error) {
+                pthread_cond_wait(&a->cond_wakeup_worker, &a->mutex);
+                continue;
+            }
+
+            pthread_mutex_unlock(&a->mutex);
+            ret = ffurl_read(a->h, a->chunk, len);
+            short_seek = ffurl_get_short_seek(a->h);
+            pthread_mutex_lock(&a->mutex);
+
+            a->short_seek = short_seek;
+
+            if (ret > 0)
+                av_fifo_generic_write(a->fifo, a->chunk, ret, NULL);
+            else if (!ret || ret == AVERROR_EOF)
+                a->eof = 1;
+            else
+                a->io_error = ret;
+            pthread_cond_signal(&a->cond_wakeup_main);
+        }
+    }
+    pthread_mutex_unlock(&a->mutex);
+
+    return NULL;
+}
+
+static int io_async_read(IOAsync *a, uint8_t *buf, int buf_size)
+{
+    int ret;
+
+    pthread_mutex_lock(&a->mutex);
+    while (!av_fifo_size(a->fifo) && !a->eof && !a->io_error)
+        pthread_cond_wait(&a->cond_wakeup_main, &a->mutex);
+
+    if (av_fifo_size(a->fifo)) {
+        ret = FFMIN(buf_size, av_fifo_size(a->fifo));
+        av_fifo_generic_read(a->fifo, buf, ret, NULL);
+        a->pos += ret;
+    } else {
+        /* report the condition once and let the worker retry afterwards,
+         * like a direct protocol read would */
+        ret = a->io_error ? a->io_error : AVERROR_EOF;
+        a->eof      = 0;
+        a->io_error = 0;
+    }
+    pthread_cond_signal(&a->cond_wakeup_worker);
+    pthread_mutex_unlock(&a->mutex);
+
+    return ret;
+}
+
+static int io_async_write(IOAsync *a, const uint8_t *buf, int buf_size)
+{
+    int done = 0, ret;
+
+    pthread_mutex_lock(&a->mutex);
+    while (done < buf_size && !a->io_error) {
+        int len = FFMIN(buf_size - done, av_fifo_space(a->fifo));
+
+        if (!len) {
+            pthread_cond_wait(&a->cond_wakeup_main, &a->mutex);
+            continue;
+        }
+        av_fifo_generic_write(a->fifo, (void *)(buf + done), len, NULL);
+        done += len;
+        pthread_cond_signal(&a->cond_wakeup_worker);
+    }
+    ret = a->io_error ? a->io_error : buf_size;
+    pthread_mutex_unlock(&a->mutex);
+
+    return ret;
+}
+
+static int64_t io_async_seek(IOAsync *a, int64_t offset, int whence)
+{
+    int64_t ret;
+
+    pthread_mutex_lock(&a->mutex);
+    if (!a->write && (whence & ~AVSEEK_FORCE) == SEEK_CUR) {
+        offset += a->pos;
+        whence  = SEEK_SET | (whence & AVSEEK_FORCE);
+    }
+
+    /* forward seeks inside the read-ahead window just drop data */
+    if (!a->write && (whence & ~AVSEEK_FORCE) == SEEK_SET &&
+        offset >= a->pos && offset - a->pos <= av_fifo_size(a->fifo)) {
+        av_fifo_drain(a->fifo, offset - a->pos);
+        a->pos = offset;
+        pthread_cond_signal(&a->cond_wakeup_worker);
+        pthread_mutex_unlock(&a->mutex);
+        return offset;
+    }
+
+    if (a->write && a->io_error) {
+        ret = a->io_error;
+        pthread_mutex_unlock(&a->mutex);
+        return ret;
+    }
+
+    /* the worker drains pending writes before it executes the seek */
+    a->seek_request = 1;
+    a->seek_offset  = offset;
+    a->seek_whence  = whence;
+    pthread_cond_signal(&a->cond_wakeup_worker);
+    while (a->seek_request)
+        pthread_cond_wait(&a->cond_wakeup_main, &a->mutex);
+    ret = a->seek_ret;
+    pthread_mutex_unlock(&a->mutex);
+
+    return ret;
+}
+
+/* The URLContext belongs to the worker, which may be inside the protocol
+ * without holding the mutex, so use the value it cached after its last
+ * operation instead of querying the protocol from this thread. */
+static int io_async_short_seek(IOAsync *a)
+{
+    int ret;
+
+    pthread_mutex_lock(&a->mutex);
+    ret = a->short_seek;
+    pthread_mutex_unlock(&a->mutex);
+
+    return ret;
+}
+
+static int io_async_start(AVIOInternal *internal)
+{
+    URLContext *h = internal->h;
+    IOAsync *a;
+    int write = h->flags & AVIO_FLAG_WRITE;
+    int size  = write ? h->writebehind_size : h->readahead_size;
+    int ret;
+
+    if (!size || (h->flags & AVIO_FLAG_READ_WRITE) == AVIO_FLAG_READ_WRITE)
+        return 0;
+    /* packet boundaries must be kept; equal min and max packet sizes are
+     * only a block size hint */
+    if ((h->max_packet_size && h->max_packet_size != h->min_packet_size) ||
+        (h->prot && (h->prot->url_read_pause || h->prot->url_read_seek))) {
+        av_log(h, AV_LOG_VERBOSE, "Background %s not supported by protocol %s\n",
+               write ? "write-behind" : "read-ahead", h->prot->name);
+        return 0;
+    }
+
+    a = av_mallocz(sizeof(*a));
+    if (!a)
+        return AVERROR(ENOMEM);
+    a->h          = h;
+    a->write      = write;
+    a->chunk_size = FFMIN(size, ASYNC_CHUNK_SIZE);
+    a->fifo       = av_fifo_alloc(size);
+    a->chunk      = av_malloc(a->chunk_size);
+    if (!a->fifo || !a->chunk) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    if (!write)
+        a->pos = ffurl_seek(h, 0, SEEK_CUR);
+    a->short_seek = ffurl_get_short_seek(h);
+
+    if ((ret = pthread_mutex_init(&a->mutex, NULL))) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    if ((ret = pthread_cond_init(&a->cond_wakeup_main, NULL))) {
+        ret = AVERROR(ret);
+        goto cond_main_fail;
+    }
+    if ((ret = pthread_cond_init(&a->cond_wakeup_worker, NULL))) {
+        ret = AVERROR(ret);
+        goto cond_worker_fail;
+    }
+
+    a->interrupt_callback = h->interrupt_callback;
+    h->interrupt_callback = (AVIOInterruptCB){ io_async_check_interrupt, a };
+
+    if ((ret = pthread_create(&a->worker, NULL, io_async_worker, a))) {
+        ret = AVERROR(ret);
+        h->interrupt_callback = a->interrupt_callback;
+        goto thread_fail;
+    }
+
+    if (a->pos < 0)
+        a->pos = 0;
+    internal->async = a;
+    av_log(h, AV_LOG_DEBUG, "Background %s enabled with a %d byte buffer\n",
+           write ? "write-behind" : "read-ahead", size);
+    return 0;
+
+thread_fail:
+    pthread_cond_destroy(&a->cond_wakeup_worker);
+cond_worker_fail:
+    pthread_cond_destroy(&a->cond_wakeup_main);
+cond_main_fail:
+    pthread_mutex_destroy(&a->mutex);
+fail:
+    av_fifo_freep(&a->fifo);
+    av_freep(&a->chunk);
+    av_freep(&a);
+    return ret;
+}
+
+/**
+ * Stop the worker thread, draining pending writes.
+ *
+ * @param resync if set, reposition the URLContext at the logical read
+ *               position so it can be used directly afterwards
+ * @return the first write error, if any
+ */
+static int io_async_stop(AVIOInternal *internal, int resync)
+{
+    IOAsync *a = internal->async;
+    int ret;
+
+    if (!a)
+        return 0;
+
+    pthread_mutex_lock(&a->mutex);
+    a->quit = 1;
+    pthread_cond_signal(&a->cond_wakeup_worker);
+    pthread_mutex_unlock(&a->mutex);
+    pthread_join(a->worker, NULL);
+
+    a->h->interrupt_callback = a->interrupt_callback;
+    ret = a->write ? a->io_error : 0;
+    if (resync && !a->write && (av_fifo_size(a->fifo) || a->eof) &&
+        ffurl_seek(a->h, a->pos, SEEK_SET) < 0)
+        av_log(a->h, AV_LOG_WARNING,
+               "Could not restore position after stopping read-ahead\n");
+
+    pthread_cond_destroy(&a->cond_wakeup_worker);
+    pthread_cond_destroy(&a->cond_wakeup_main);
+    pthread_mutex_destroy(&a->mutex);
+    av_fifo_freep(&a->fifo);
+    av_freep(&a->chunk);
+    av_freep(&internal->async);
+
+    return ret;
+}
+#else
+static int io_async_read(struct IOAsync *a, uint8_t *buf, int buf_size)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int io_async_write(struct IOAsync *a, const uint8_t *buf, int buf_size)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int64_t io_async_seek(struct IOAsync *a, int64_t offset, int whence)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int io_async_short_seek(struct IOAsync *a)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int io_async_start(AVIOInternal *internal)
+{
+    URLContext *h = internal->h;
+    if (h->readahead_size || h->writebehind_size)
+        av_log(h, AV_LOG_WARNING,
+               "Background read-ahead and write-behind require threads\n");
+    return 0;
+}
+
+static int io_async_stop(AVIOInternal *internal, int resync)
+{
+    return 0;
+}
+#endif
+
 static int io_read_packet(void *opaque, uint8_t *buf, int buf_size)
 {
     AVIOInternal *internal = opaque;
+    if (internal->async)
+        return io_async_read(internal->async, buf, buf_size);
     return ffurl_read(internal->h, buf, buf_size);
 }
 
 static int io_write_packet(void *opaque, uint8_t *buf, int buf_size)
 {
     AVIOInternal *internal = opaque;
+    if (internal->async)
+        return io_async_write(internal->async, buf, buf_size);
     return ffurl_write(internal->h, buf, buf_size);
 }
 
 static int64_t io_seek(void *opaque, int64_t offset, int whence)
 {
     AVIOInternal *internal = opaque;
+    if (internal->async)
+        return io_async_seek(internal->async, offset, whence);
     return ffurl_seek(internal->h, offset, whence);
 }
 
 static int io_short_seek(void *opaque)
 {
     AVIOInternal *internal = opaque;
+    if (internal->async)
+        return io_async_short_seek(internal->async);
     return ffurl_get_short_seek(internal->h);
 }
 
@@ -982,7 +1379,7 @@ int ffio_fdopen(AVIOContext **s, URLContext *h)
 {
     AVIOInternal *internal = NULL;
     uint8_t *buffer = NULL;
-    int buffer_size, max_packet_size;
+    int buffer_size, max_packet_size, ret;
 
     max_packet_size = h->max_packet_size;
     if (max_packet_size) {
@@ -1029,6 +1426,10 @@ int ffio_fdopen(AVIOContext **s, URLContext *h)
     }
     (*s)->short_seek_get = io_short_seek;
     (*s)->av_class = &ff_avio_class;
+
+    if ((ret = io_async_start(internal)) < 0)
+        av_log(h, AV_LOG_WARNING, "Could not start background I/O: %s\n",
+               av_err2str(ret));
     return 0;
 fail:
     av_freep(&internal);
@@ -1043,8 +1444,13 @@ URLContext* ffio_geturlcontext(AVIOContext *s)
         return NULL;
 
     internal = s->opaque;
-    if (internal && s->read_packet == io_read_packet)
+    if (internal && s->read_packet == io_read_packet) {
+        /* the caller is going to use the URLContext directly */
+        int ret = io_async_stop(internal, 1);
+        if (ret < 0 && !s->error)
+            s->error = ret;
         return internal->h;
+    }
     else
         return NULL;
 }
@@ -1191,6 +1597,7 @@ int avio_close(AVIOContext *s)
 {
     AVIOInternal *internal;
     URLContext *h;
+    int ret, async_ret;
 
     if (!s)
         return 0;
@@ -1199,6 +1606,11 @@ int avio_close(AVIOContext *s)
     internal = s->opaque;
     h        = internal->h;
 
+    async_ret = io_async_stop(internal, 0);
+    if (async_ret < 0)
+        av_log(s, AV_LOG_ERROR, "Error writing buffered data: %s\n",
+               av_err2str(async_ret));
+
     av_freep(&s->opaque);
     av_freep(&s->buffer);
     if (s->write_flag)
@@ -1209,7 +1621,8 @@ int avio_close(AVIOContext *s)
 
     avio_context_free(&s);
 
-    return ffurl_close(h);
+    ret = ffurl_close(h);
+    return ret < 0 ? ret : async_ret;
 }
 
 int avio_closep(AVIOContext **s)
@@ -1292,6 +1705,7 @@ int avio_handshake(AVIOContext *c)
 {
     AVIOInternal *internal = c->opaque;
     URLContext *cc = internal->h;
+    io_async_stop(internal, 1);
     return ffurl_handshake(cc);
 }
 
@@ -33,6 +33,8 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
+#include "libavutil/fifo.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "avformat.h"
 #include "internal.h"
@@ -43,6 +45,7 @@
 
 #define MAX_FIELD_LEN 64
 #define MAX_CHARACTERISTICS_LEN 512
+#define MAX_INIT_SECTION_SIZE (1024*1024)
 
 #define MPEG_TIME_BASE 90000
 #define MPEG_TIME_BASE_Q (AVRational){1, MPEG_TIME_BASE}
@@ -79,6 +82,41 @@ struct segment {
 
 struct rendition;
 
+enum PrefetchState {
+    PREFETCH_IDLE,      /* slot free, not assigned to any segment */
+    PREFETCH_QUEUED,    /* segment assigned, worker has not started yet */
+    PREFETCH_OPENING,   /* worker is fetching the init section/opening */
+    PREFETCH_READING,   /* segment open, data is being buffered */
+    PREFETCH_DONE,      /* segment fully buffered or failed */
+};
+
+/*
+ * A prefetch slot downloads one segment (and, if needed, its Media
+ * Initialization Section) in a background thread into a bounded FIFO.
+ * The segment description is a private copy, since the playlist segment
+ * list may be replaced by a reload while the download is in progress.
+ */
+struct prefetch_slot {
+    struct playlist *pls;
+    int seq_no;
+    enum PrefetchState state;
+    int cancel;
+    int error;              /* final status, AVERROR_EOF on success */
+    struct segment seg;
+    struct segment init;    /* init.url is NULL if no init section is needed */
+    struct segment *init_section; /* identity of the playlist init section */
+    uint8_t *init_buf;
+    int init_len;
+    AVFifoBuffer *fifo;
+    AVIOContext *in;
+    int opened;
+    int64_t offset;
+#if HAVE_THREADS
+    pthread_t thread;
+#endif
+    int thread_created;
+};
+
 enum PlaylistType {
     PLS_TYPE_UNSPECIFIED,
     PLS_TYPE_EVENT,
@@ -157,6 +195,18 @@ struct playlist {
      * playlist, if any. */
     int n_init_sections;
     struct segment **init_sections;
+
+    /* Segment prefetching, see prefetch_schedule() */
+    struct prefetch_slot *prefetch_slots;
+    struct prefetch_slot *cur_slot;
+    int n_prefetch_slots;
+    int prefetch_quit;
+    int64_t prefetch_buffered;
+#if HAVE_THREADS
+    pthread_mutex_t prefetch_mutex;
+    pthread_cond_t prefetch_cond_main;
+    pthread_cond_t prefetch_cond_worker;
+#endif
 };
 
 /*
@@ -209,6 +259,16 @@ typedef struct HLSContext {
     int http_persistent;
     int http_multiple;
     AVIOContext *playlist_pb;
+    int prefetch_segments;
+    int prefetch_buffer_size;
+    int64_t prefetch_bytes_buffered;
+    int64_t prefetch_stall_time;
+#if HAVE_THREADS
+    /* protects avio_opts and the per-playlist key cache against the
+     * prefetch threads */
+    pthread_mutex_t shared_lock;
+#endif
+    int shared_lock_inited;
 } HLSContext;
 
 static void free_segment_dynarray(struct segment **segments, int n_segments)
@@ -239,11 +299,14 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void prefetch_uninit(struct playlist *pls);
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_playlists; i++) {
         struct playlist *pls = c->playlists[i];
+        prefetch_uninit(pls);
         free_segment_list(pls);
         free_init_section_list(pls);
         av_freep(&pls->main_streams);
@@ -589,6 +652,22 @@ static int ensure_playlist(HLSContext *c, struct playlist **pls, const char *url
     return 0;
 }
 
+static void shared_lock(HLSContext *c)
+{
+#if HAVE_THREADS
+    if (c->shared_lock_inited)
+        pthread_mutex_lock(&c->shared_lock);
+#endif
+}
+
+static void shared_unlock(HLSContext *c)
+{
+#if HAVE_THREADS
+    if (c->shared_lock_inited)
+        pthread_mutex_unlock(&c->shared_lock);
+#endif
+}
+
 static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
                               const char *url)
 {
@@ -616,7 +695,9 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     int ret;
     int is_http = 0;
 
+    shared_lock(c);
     av_dict_copy(&tmp, opts, 0);
+    shared_unlock(c);
     av_dict_copy(&tmp, opts2, 0);
 
     if (av_strstart(url, "crypto", NULL)) {
@@ -672,8 +753,11 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
         if (!(s->flags & AVFMT_FLAG_CUSTOM_IO))
             av_opt_get(*pb, "cookies", AV_OPT_SEARCH_CHILDREN, (uint8_t**)&new_cookies);
 
-        if (new_cookies)
+        if (new_cookies) {
+            shared_lock(c);
             av_dict_set(&opts, "cookies", new_cookies, AV_DICT_DONT_STRDUP_VAL);
+            shared_unlock(c);
+        }
     }
 
     av_dict_free(&tmp);
@@ -723,7 +807,9 @@ static int parse_playlist(HLSContext *c, const char *url,
 
     if (!in) {
         AVDictionary *opts = NULL;
+        shared_lock(c);
         av_dict_copy(&opts, c->avio_opts, 0);
+        shared_unlock(c);
 
         if (c->http_persistent)
             av_dict_set(&opts, "multiple_requests", "1", 0);
@@ -939,11 +1025,16 @@ static struct segment *next_segment(struct playlist *pls)
     return pls->segments[n];
 }
 
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size);
+
 static int read_from_url(struct playlist *pls, struct segment *seg,
                          uint8_t *buf, int buf_size)
 {
     int ret;
 
+    if (pls->cur_slot)
+        return prefetch_read(pls, buf, buf_size);
+
      /* limit read if the segment was only a part of a file */
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, seg->size - pls->cur_seg_offset);
@@ -1153,7 +1244,7 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
         pls->is_id3_timestamped = (pls->id3_mpegts_timestamp != AV_NOPTS_VALUE);
 }
 
-static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg, AVIOContext **in)
+static int open_segment(HLSContext *c, struct playlist *pls, struct segment *seg, AVIOContext **in)
 {
     AVDictionary *opts = NULL;
     int ret;
@@ -1176,11 +1267,20 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
         ret = open_url(pls->parent, in, seg->url, c->avio_opts, opts, &is_http);
     } else if (seg->key_type == KEY_AES_128) {
         char iv[33], key[33], url[MAX_URL_SIZE];
-        if (strcmp(seg->key, pls->key_url)) {
+        uint8_t key_data[sizeof(pls->key)];
+        int new_key;
+
+        /* open_url() takes the shared lock, so the key is fetched without
+         * holding it and only stored in the cache under it */
+        shared_lock(c);
+        new_key = strcmp(seg->key, pls->key_url);
+        memcpy(key_data, pls->key, sizeof(key_data));
+        shared_unlock(c);
+        if (new_key) {
             AVIOContext *pb = NULL;
             if (open_url(pls->parent, &pb, seg->key, c->avio_opts, opts, NULL) == 0) {
-                ret = avio_read(pb, pls->key, sizeof(pls->key));
-                if (ret != sizeof(pls->key)) {
+                ret = avio_read(pb, key_data, sizeof(key_data));
+                if (ret != sizeof(key_data)) {
                     av_log(NULL, AV_LOG_ERROR, "Unable to read key file %s\n",
                            seg->key);
                 }
@@ -1189,10 +1289,13 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
                 av_log(NULL, AV_LOG_ERROR, "Unable to open key file %s\n",
                        seg->key);
             }
+            shared_lock(c);
+            memcpy(pls->key, key_data, sizeof(pls->key));
             av_strlcpy(pls->key_url, seg->key, sizeof(pls->key_url));
+            shared_unlock(c);
         }
         ff_data_to_hex(iv, seg->iv, sizeof(seg->iv), 0);
-        ff_data_to_hex(key, pls->key, sizeof(pls->key), 0);
+        ff_data_to_hex(key, key_data, sizeof(key_data), 0);
         iv[32] = key[32] = '\0';
         if (strstr(seg->url, "://"))
             snprintf(url, sizeof(url), "crypto+%s", seg->url);
@@ -1236,13 +1339,18 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
 
 cleanup:
     av_dict_free(&opts);
+    return ret;
+}
+
+static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg, AVIOContext **in)
+{
+    int ret = open_segment(c, pls, seg, in);
     pls->cur_seg_offset = 0;
     return ret;
 }
 
 static int update_init_section(struct playlist *pls, struct segment *seg)
 {
-    static const int max_init_section_size = 1024*1024;
     HLSContext *c = pls->parent->priv_data;
     int64_t sec_size;
     int64_t urlsize;
@@ -1269,13 +1377,13 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
     else if ((urlsize = avio_size(pls->input)) >= 0)
         sec_size = urlsize;
     else
-        sec_size = max_init_section_size;
+        sec_size = MAX_INIT_SECTION_SIZE;
 
     av_log(pls->parent, AV_LOG_DEBUG,
            "Downloading an initialization section of size %"PRId64"\n",
            sec_size);
 
-    sec_size = FFMIN(sec_size, max_init_section_size);
+    sec_size = FFMIN(sec_size, MAX_INIT_SECTION_SIZE);
 
     av_fast_malloc(&pls->init_sec_buf, &pls->init_sec_buf_size, sec_size);
 
@@ -1297,6 +1405,477 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
     return 0;
 }
 
+#if HAVE_THREADS
+static void prefetch_reset_slot(struct prefetch_slot *slot)
+{
+    av_freep(&slot->seg.url);
+    av_freep(&slot->seg.key);
+    av_freep(&slot->init.url);
+    av_freep(&slot->init_buf);
+    slot->init_len     = 0;
+    slot->init_section = NULL;
+    slot->pls->prefetch_buffered -= av_fifo_size(slot->fifo);
+    av_fifo_reset(slot->fifo);
+    slot->seq_no = -1;
+    slot->cancel = 0;
+    slot->opened = 0;
+    slot->error  = 0;
+    slot->state  = PREFETCH_IDLE;
+}
+
+/* Must be called with the playlist prefetch mutex held. */
+static void prefetch_cancel_slot(struct prefetch_slot *slot)
+{
+    if (slot->state == PREFETCH_QUEUED || slot->state == PREFETCH_DONE)
+        prefetch_reset_slot(slot);
+    else if (slot->state != PREFETCH_IDLE)
+        slot->cancel = 1;
+}
+
+static int prefetch_fetch_init_section(HLSContext *c, struct prefetch_slot *slot)
+{
+    AVIOContext *in = NULL;
+    int64_t sec_size, urlsize;
+    int ret;
+
+    ret = open_segment(c, slot->pls, &slot->init, &in);
+    if (ret < 0)
+        return ret;
+
+    if (slot->init.size >= 0)
+        sec_size = slot->init.size;
+    else if ((urlsize = avio_size(in)) >= 0)
+        sec_size = urlsize;
+    else
+        sec_size = MAX_INIT_SECTION_SIZE;
+    sec_size = FFMIN(sec_size, MAX_INIT_SECTION_SIZE);
+
+    slot->init_buf = av_malloc(FFMAX(sec_size, 1));
+    if (!slot->init_buf) {
+        ret = AVERROR(ENOMEM);
+    } else {
+        ret = avio_read(in, slot->init_buf, sec_size);
+        if (ret >= 0)
+            slot->init_len = ret;
+        else
+            av_freep(&slot->init_buf);
+    }
+    ff_format_io_close(slot->pls->parent, &in);
+
+    return ret < 0 ? ret : 0;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    struct prefetch_slot *slot = arg;
+    struct playlist *pls = slot->pls;
+    HLSContext *c = pls->parent->priv_data;
+    uint8_t buf[16384];
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    while (!pls->prefetch_quit) {
+        struct segment *seg = &slot->seg;
+        int ret = 0, len, is_http;
+
+        if (slot->state != PREFETCH_QUEUED) {
+            pthread_cond_wait(&pls->prefetch_cond_worker, &pls->prefetch_mutex);
+            continue;
+        }
+        slot->state = PREFETCH_OPENING;
+        is_http = av_strstart(seg->url, "http", NULL);
+        pthread_mutex_unlock(&pls->prefetch_mutex);
+
+        /* a failed init section download is retried synchronously by
+         * the reader, so the error is not propagated */
+        if (slot->init.url)
+            prefetch_fetch_init_section(c, slot);
+
+        /* a kept-alive connection can only be reused for HTTP */
+        if (slot->in && !is_http)
+            ff_format_io_close(pls->parent, &slot->in);
+        if (ff_check_interrupt(c->interrupt_callback))
+            ret = AVERROR_EXIT;
+        else
+            ret = open_segment(c, pls, seg, &slot->in);
+        slot->offset = 0;
+
+        pthread_mutex_lock(&pls->prefetch_mutex);
+        if (ret >= 0) {
+            slot->opened = 1;
+            slot->state  = PREFETCH_READING;
+            pthread_cond_broadcast(&pls->prefetch_cond_main);
+
+            while (!slot->cancel && !pls->prefetch_quit) {
+                int space = av_fifo_space(slot->fifo);
+                if (!space) {
+                    pthread_cond_wait(&pls->prefetch_cond_worker, &pls->prefetch_mutex);
+                    continue;
+                }
+                pthread_mutex_unlock(&pls->prefetch_mutex);
+
+                len = FFMIN(space, sizeof(buf));
+                if (seg->size >= 0)
+                    len = FFMIN(len, seg->size - slot->offset);
+                ret = len > 0 ? avio_read(slot->in, buf, len) : AVERROR_EOF;
+                if (!ret)
+                    ret = AVERROR_EOF;
+
+                pthread_mutex_lock(&pls->prefetch_mutex);
+                if (ret < 0)
+                    break;
+                slot->offset += ret;
+                av_fifo_generic_write(slot->fifo, buf, ret, NULL);
+                pls->prefetch_buffered += ret;
+                pthread_cond_broadcast(&pls->prefetch_cond_main);
+            }
+        }
+
+        if (slot->in && (ret != AVERROR_EOF || slot->cancel || !c->http_persistent ||
+                         seg->key_type != KEY_NONE || !is_http)) {
+            pthread_mutex_unlock(&pls->prefetch_mutex);
+            ff_format_io_close(pls->parent, &slot->in);
+            pthread_mutex_lock(&pls->prefetch_mutex);
+        }
+
+        if (slot->cancel) {
+            prefetch_reset_slot(slot);
+        } else {
+            slot->error = ret;
+            slot->state = PREFETCH_DONE;
+        }
+        pthread_cond_broadcast(&pls->prefetch_cond_main);
+    }
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    ff_format_io_close(pls->parent, &slot->in);
+
+    return NULL;
+}
+
+static void prefetch_uninit(struct playlist *pls)
+{
+    int i;
+
+    if (!pls->prefetch_slots)
+        return;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    pls->prefetch_quit = 1;
+    pthread_cond_broadcast(&pls->prefetch_cond_worker);
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    for (i = 0; i < pls->n_prefetch_slots; i++) {
+        struct prefetch_slot *slot = &pls->prefetch_slots[i];
+        if (slot->thread_created)
+            pthread_join(slot->thread, NULL);
+        if (slot->fifo)
+            prefetch_reset_slot(slot);
+        av_fifo_freep(&slot->fifo);
+    }
+
+    pthread_cond_destroy(&pls->prefetch_cond_worker);
+    pthread_cond_destroy(&pls->prefetch_cond_main);
+    pthread_mutex_destroy(&pls->prefetch_mutex);
+    av_freep(&pls->prefetch_slots);
+    pls->n_prefetch_slots = 0;
+    pls->cur_slot = NULL;
+}
+
+static int prefetch_init(struct playlist *pls)
+{
+    HLSContext *c = pls->parent->priv_data;
+    int i, ret;
+
+    if ((ret = pthread_mutex_init(&pls->prefetch_mutex, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&pls->prefetch_cond_main, NULL))) {
+        pthread_mutex_destroy(&pls->prefetch_mutex);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&pls->prefetch_cond_worker, NULL))) {
+        pthread_cond_destroy(&pls->prefetch_cond_main);
+        pthread_mutex_destroy(&pls->prefetch_mutex);
+        return AVERROR(ret);
+    }
+
+    pls->prefetch_slots = av_mallocz_array(c->prefetch_segments,
+                                           sizeof(*pls->prefetch_slots));
+    if (!pls->prefetch_slots) {
+        pthread_cond_destroy(&pls->prefetch_cond_worker);
+        pthread_cond_destroy(&pls->prefetch_cond_main);
+        pthread_mutex_destroy(&pls->prefetch_mutex);
+        return AVERROR(ENOMEM);
+    }
+    pls->n_prefetch_slots = c->prefetch_segments;
+    pls->prefetch_quit    = 0;
+
+    for (i = 0; i < pls->n_prefetch_slots; i++) {
+        struct prefetch_slot *slot = &pls->prefetch_slots[i];
+        slot->pls    = pls;
+        slot->seq_no = -1;
+        slot->fifo   = av_fifo_alloc(c->prefetch_buffer_size);
+        if (!slot->fifo) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        if ((ret = pthread_create(&slot->thread, NULL, prefetch_worker, slot))) {
+            ret = AVERROR(ret);
+            goto fail;
+        }
+        slot->thread_created = 1;
+    }
+
+    return 0;
+fail:
+    av_log(pls->parent, AV_LOG_ERROR, "Failed to start prefetching for playlist %d\n",
+           pls->index);
+    prefetch_uninit(pls);
+    return ret;
+}
+
+static struct prefetch_slot *prefetch_find_slot(struct playlist *pls, int seq_no)
+{
+    int i;
+    for (i = 0; i < pls->n_prefetch_slots; i++) {
+        struct prefetch_slot *slot = &pls->prefetch_slots[i];
+        if (slot->state != PREFETCH_IDLE && !slot->cancel && slot->seq_no == seq_no)
+            return slot;
+    }
+    return NULL;
+}
+
+static int prefetch_assign_slot(struct playlist *pls, struct prefetch_slot *slot, int seq_no)
+{
+    int n = seq_no - pls->start_seq_no;
+    struct segment *seg = pls->segments[n];
+    struct segment *prev_init_section = seq_no == pls->cur_seq_no ?
+                                        pls->cur_init_section :
+                                        n > 0 ? pls->segments[n - 1]->init_section : NULL;
+
+    slot->seg      = *seg;
+    slot->seg.url  = av_strdup(seg->url);
+    slot->seg.key  = av_strdup(seg->key);
+    slot->seg.init_section = NULL;
+    if (!slot->seg.url || (seg->key && !slot->seg.key))
+        goto fail;
+
+    /* only fetch the init section where the playback switches to it */
+    if (seg->init_section && seg->init_section != prev_init_section) {
+        slot->init     = *seg->init_section;
+        slot->init.url = av_strdup(seg->init_section->url);
+        slot->init.key = NULL;
+        if (!slot->init.url)
+            goto fail;
+        slot->init_section = seg->init_section;
+    }
+
+    slot->seq_no = seq_no;
+    slot->state  = PREFETCH_QUEUED;
+    return 0;
+fail:
+    prefetch_reset_slot(slot);
+    return AVERROR(ENOMEM);
+}
+
+/*
+ * Keep the slots busy with the segments following cur_seq_no, cancelling
+ * the downloads that fell out of that window (e.g. after a seek).
+ * Must be called with the playlist prefetch mutex held.
+ */
+static void prefetch_schedule(struct playlist *pls)
+{
+    int i, seq_no, end;
+
+    for (i = 0; i < pls->n_prefetch_slots; i++) {
+        struct prefetch_slot *slot = &pls->prefetch_slots[i];
+        if (slot->seq_no < pls->cur_seq_no ||
+            slot->seq_no >= pls->cur_seq_no + pls->n_prefetch_slots)
+            prefetch_cancel_slot(slot);
+    }
+
+    end = FFMIN(pls->cur_seq_no + pls->n_prefetch_slots,
+                pls->start_seq_no + pls->n_segments);
+    for (seq_no = FFMAX(pls->cur_seq_no, pls->start_seq_no); seq_no < end; seq_no++) {
+        struct prefetch_slot *slot = NULL;
+
+        if (prefetch_find_slot(pls, seq_no))
+            continue;
+        for (i = 0; i < pls->n_prefetch_slots; i++) {
+            if (pls->prefetch_slots[i].state == PREFETCH_IDLE) {
+                slot = &pls->prefetch_slots[i];
+                break;
+            }
+        }
+        if (!slot || prefetch_assign_slot(pls, slot, seq_no) < 0)
+            break;
+    }
+
+    pthread_cond_broadcast(&pls->prefetch_cond_worker);
+}
+
+/* Wait until the download of the current segment has been started. */
+static int prefetch_wait_slot(struct playlist *pls, struct prefetch_slot **out)
+{
+    HLSContext *c = pls->parent->priv_data;
+    struct prefetch_slot *slot;
+    int64_t stall_start = 0;
+    int ret = 0;
+
+    if (!pls->prefetch_slots && (ret = prefetch_init(pls)) < 0)
+        return ret;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    for (;;) {
+        prefetch_schedule(pls);
+        slot = prefetch_find_slot(pls, pls->cur_seq_no);
+        if (slot && slot->state >= PREFETCH_READING)
+            break;
+        if (ff_check_interrupt(c->interrupt_callback)) {
+            ret = AVERROR_EXIT;
+            break;
+        }
+        if (!stall_start)
+            stall_start = av_gettime_relative();
+        pthread_cond_wait(&pls->prefetch_cond_main, &pls->prefetch_mutex);
+    }
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    if (stall_start)
+        c->prefetch_stall_time += av_gettime_relative() - stall_start;
+
+    *out = slot;
+    return ret;
+}
+
+/* Make the slot the active input of the playlist, or drop it and return
+ * the error if the segment could not be opened. */
+static int prefetch_claim_slot(struct playlist *pls, struct prefetch_slot *slot)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    if (slot->opened) {
+        pls->cur_slot = slot;
+    } else {
+        ret = slot->error;
+        prefetch_reset_slot(slot);
+    }
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    return ret;
+}
+
+static void prefetch_release_slot(struct playlist *pls)
+{
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    prefetch_cancel_slot(pls->cur_slot);
+    pls->cur_slot = NULL;
+    pthread_cond_broadcast(&pls->prefetch_cond_worker);
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+}
+
+static void prefetch_flush(struct playlist *pls)
+{
+    int i;
+
+    if (!pls->prefetch_slots)
+        return;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    for (i = 0; i < pls->n_prefetch_slots; i++)
+        prefetch_cancel_slot(&pls->prefetch_slots[i]);
+    pls->cur_slot = NULL;
+    pthread_cond_broadcast(&pls->prefetch_cond_worker);
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+}
+
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    HLSContext *c = pls->parent->priv_data;
+    struct prefetch_slot *slot = pls->cur_slot;
+    int64_t stall_start = 0;
+    int ret;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    while (!av_fifo_size(slot->fifo) && slot->state != PREFETCH_DONE) {
+        if (ff_check_interrupt(c->interrupt_callback))
+            break;
+        if (!stall_start)
+            stall_start = av_gettime_relative();
+        pthread_cond_wait(&pls->prefetch_cond_main, &pls->prefetch_mutex);
+    }
+
+    if (av_fifo_size(slot->fifo)) {
+        ret = FFMIN(buf_size, av_fifo_size(slot->fifo));
+        av_fifo_generic_read(slot->fifo, buf, ret, NULL);
+        pls->prefetch_buffered -= ret;
+        pthread_cond_broadcast(&pls->prefetch_cond_worker);
+    } else {
+        ret = slot->state == PREFETCH_DONE ? slot->error : AVERROR_EXIT;
+    }
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    if (stall_start)
+        c->prefetch_stall_time += av_gettime_relative() - stall_start;
+
+    return ret;
+}
+
+static void update_prefetch_stats(HLSContext *c)
+{
+    int64_t buffered = 0;
+    int i;
+
+    for (i = 0; i < c->n_playlists; i++) {
+        struct playlist *pls = c->playlists[i];
+        if (!pls->prefetch_slots)
+            continue;
+        pthread_mutex_lock(&pls->prefetch_mutex);
+        buffered += pls->prefetch_buffered;
+        pthread_mutex_unlock(&pls->prefetch_mutex);
+    }
+    c->prefetch_bytes_buffered = buffered;
+}
+#else
+static void prefetch_uninit(struct playlist *pls) { }
+static void prefetch_flush(struct playlist *pls) { }
+static void prefetch_release_slot(struct playlist *pls) { }
+static void update_prefetch_stats(HLSContext *c) { }
+
+static int prefetch_wait_slot(struct playlist *pls, struct prefetch_slot **out)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int prefetch_claim_slot(struct playlist *pls, struct prefetch_slot *slot)
+{
+    return AVERROR(ENOSYS);
+}
+
+static int prefetch_read(struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    return AVERROR(ENOSYS);
+}
+#endif /* HAVE_THREADS */
+
+/* Take over the init section downloaded along with the segment, if it is
+ * the one needed; otherwise fall back to downloading it here. */
+static int prefetch_update_init_section(struct playlist *pls, struct prefetch_slot *slot,
+                                        struct segment *seg)
+{
+    if (seg->init_section && seg->init_section != pls->cur_init_section &&
+        slot->init_section == seg->init_section && slot->init_buf) {
+        FFSWAP(uint8_t *, pls->init_sec_buf, slot->init_buf);
+        pls->init_sec_buf_size        = slot->init_len;
+        pls->init_sec_data_len        = slot->init_len;
+        pls->init_sec_buf_read_offset = 0;
+        pls->cur_init_section         = seg->init_section;
+        pls->is_id3_timestamped       = 0;
+        return 0;
+    }
+    return update_init_section(pls, seg);
+}
+
 static int64_t default_reload_interval(struct playlist *pls)
 {
     return pls->n_segments > 0 ?
@@ -1363,7 +1942,8 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if (c->prefetch_segments ? !v->cur_slot :
+        (!v->input || (c->http_persistent && v->input_read_done))) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1418,17 +1998,32 @@ reload:
         v->input_read_done = 0;
         seg = current_segment(v);
 
-        /* load/update Media Initialization Section, if any */
-        ret = update_init_section(v, seg);
-        if (ret)
-            return ret;
+        if (c->prefetch_segments) {
+            struct prefetch_slot *slot;
+
+            ret = prefetch_wait_slot(v, &slot);
+            if (ret < 0)
+                return ret;
+
+            /* load/update Media Initialization Section, if any */
+            ret = prefetch_update_init_section(v, slot, seg);
+            if (ret)
+                return ret;
 
-        if (c->http_multiple == 1 && v->input_next_requested) {
-            FFSWAP(AVIOContext *, v->input, v->input_next);
-            v->input_next_requested = 0;
-            ret = 0;
+            ret = prefetch_claim_slot(v, slot);
         } else {
-            ret = open_input(c, v, seg, &v->input);
+            /* load/update Media Initialization Section, if any */
+            ret = update_init_section(v, seg);
+            if (ret)
+                return ret;
+
+            if (c->http_multiple == 1 && v->input_next_requested) {
+                FFSWAP(AVIOContext *, v->input, v->input_next);
+                v->input_next_requested = 0;
+                ret = 0;
+            } else {
+                ret = open_input(c, v, seg, &v->input);
+            }
         }
         if (ret < 0) {
             if (ff_check_interrupt(c->interrupt_callback))
@@ -1485,7 +2080,9 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->cur_slot) {
+        prefetch_release_slot(v);
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
@@ -1746,12 +2343,21 @@ static int hls_close(AVFormatContext *s)
 {
     HLSContext *c = s->priv_data;
 
+    if (c->prefetch_segments)
+        av_log(s, AV_LOG_VERBOSE, "Segment prefetch stalled for %"PRId64" ms\n",
+               c->prefetch_stall_time / 1000);
+
     free_playlist_list(c);
     free_variant_list(c);
     free_rendition_list(c);
 
     av_dict_free(&c->avio_opts);
     ff_format_io_close(c->ctx, &c->playlist_pb);
+#if HAVE_THREADS
+    if (c->shared_lock_inited)
+        pthread_mutex_destroy(&c->shared_lock);
+    c->shared_lock_inited = 0;
+#endif
 
     return 0;
 }
@@ -1768,6 +2374,19 @@ static int hls_read_header(AVFormatContext *s)
 
     c->first_packet = 1;
     c->first_timestamp = AV_NOPTS_VALUE;
+
+    if (c->prefetch_segments) {
+#if HAVE_THREADS
+        if ((ret = pthread_mutex_init(&c->shared_lock, NULL)))
+            return AVERROR(ret);
+        c->shared_lock_inited = 1;
+        /* the prefetch threads already keep the next segments in flight */
+        c->http_multiple = 0;
+#else
+        av_log(s, AV_LOG_WARNING, "Segment prefetching requires threading support, disabled\n");
+        c->prefetch_segments = 0;
+#endif
+    }
     c->cur_timestamp = AV_NOPTS_VALUE;
 
     if ((ret = save_avio_options(s)) < 0)
@@ -2042,6 +2661,7 @@ static int hls_read_packet(AVFormatContext *s, AVPacket *pkt)
     int ret, i, minplaylist = -1;
 
     recheck_discard_flags(s, c->first_packet);
+    update_prefetch_stats(c);
     c->first_packet = 0;
 
     for (i = 0; i < c->n_playlists; i++) {
@@ -2234,6 +2854,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         if (pls->input_next)
             ff_format_io_close(pls->parent, &pls->input_next);
         pls->input_next_requested = 0;
+        prefetch_flush(pls);
         av_packet_unref(&pls->pkt);
         reset_packet(&pls->pkt);
         pls->pb.eof_reached = 0;
@@ -2292,6 +2913,14 @@ static const AVOption hls_options[] = {
         OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, FLAGS },
     {"http_multiple", "Use multiple HTTP connections for fetching segments",
         OFFSET(http_multiple), AV_OPT_TYPE_BOOL, {.i64 = -1}, -1, 1, FLAGS},
+    {"prefetch_segments", "Number of segments per playlist to download ahead in background threads",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, FLAGS},
+    {"prefetch_buffer_size", "Maximum number of bytes buffered for each prefetched segment",
+        OFFSET(prefetch_buffer_size), AV_OPT_TYPE_INT, {.i64 = 4 << 20}, 4096, INT_MAX / 2, FLAGS},
+    {"prefetch_bytes_buffered", "export the number of bytes currently held by the prefetch buffers",
+        OFFSET(prefetch_bytes_buffered), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
+    {"prefetch_stall_time", "export the total time in microseconds spent waiting for prefetched data",
+        OFFSET(prefetch_stall_time), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
     {NULL}
 };
 
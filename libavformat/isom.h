@@ -205,6 +205,7 @@ typedef struct MOVStreamContext {
     int64_t data_size;
     uint32_t tmcd_flags;  ///< tmcd track flags
     int64_t track_end;    ///< used for dts generation in fragmented movie files
+    int64_t frag_end;     ///< highest moof offset of the fragments whose trun was read
     int start_pad;        ///< amount of samples to skip due to enc-dec delay
     unsigned int rap_group_count;
     MOVSbgp *rap_group;
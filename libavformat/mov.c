@@ -1298,9 +1298,41 @@ static int search_frag_timestamp(MOVFragmentIndex *frag_index,
     return a;
 }
 
+static MOVFragmentStreamInfo *alloc_frag_stream_info(MOVContext *c)
+{
+    MOVFragmentStreamInfo *frag_stream_info;
+    int i;
+
+    frag_stream_info = av_realloc_array(NULL, c->fc->nb_streams,
+                                        sizeof(*frag_stream_info));
+    if (!frag_stream_info)
+        return NULL;
+
+    for (i = 0; i < c->fc->nb_streams; i++) {
+        frag_stream_info[i].id = c->fc->streams[i]->id;
+        frag_stream_info[i].sidx_pts = AV_NOPTS_VALUE;
+        frag_stream_info[i].tfdt_dts = AV_NOPTS_VALUE;
+        frag_stream_info[i].first_tfra_pts = AV_NOPTS_VALUE;
+        frag_stream_info[i].index_entry = -1;
+        frag_stream_info[i].encryption_index = NULL;
+    }
+    return frag_stream_info;
+}
+
+static void init_frag_index_item(MOVContext *c, MOVFragmentIndexItem *item,
+                                 int64_t offset,
+                                 MOVFragmentStreamInfo *frag_stream_info)
+{
+    item->headers_read = 0;
+    item->current = 0;
+    item->nb_stream_info = c->fc->nb_streams;
+    item->moof_offset = offset;
+    item->stream_info = frag_stream_info;
+}
+
 static int update_frag_index(MOVContext *c, int64_t offset)
 {
-    int index, i;
+    int index;
     MOVFragmentIndexItem * item;
     MOVFragmentStreamInfo * frag_stream_info;
 
@@ -1320,30 +1352,15 @@ static int update_frag_index(MOVContext *c, int64_t offset)
         return -1;
     c->frag_index.item = item;
 
-    frag_stream_info = av_realloc_array(NULL, c->fc->nb_streams,
-                                        sizeof(*item->stream_info));
+    frag_stream_info = alloc_frag_stream_info(c);
     if (!frag_stream_info)
         return -1;
 
-    for (i = 0; i < c->fc->nb_streams; i++) {
-        frag_stream_info[i].id = c->fc->streams[i]->id;
-        frag_stream_info[i].sidx_pts = AV_NOPTS_VALUE;
-        frag_stream_info[i].tfdt_dts = AV_NOPTS_VALUE;
-        frag_stream_info[i].first_tfra_pts = AV_NOPTS_VALUE;
-        frag_stream_info[i].index_entry = -1;
-        frag_stream_info[i].encryption_index = NULL;
-    }
-
     if (index < c->frag_index.nb_items)
         memmove(c->frag_index.item + index + 1, c->frag_index.item + index,
                 (c->frag_index.nb_items - index) * sizeof(*c->frag_index.item));
 
-    item = &c->frag_index.item[index];
-    item->headers_read = 0;
-    item->current = 0;
-    item->nb_stream_info = c->fc->nb_streams;
-    item->moof_offset = offset;
-    item->stream_info = frag_stream_info;
+    init_frag_index_item(c, &c->frag_index.item[index], offset, frag_stream_info);
     c->frag_index.nb_items++;
 
     return index;
@@ -4694,13 +4711,20 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     // A valid index_entry means the trun for the fragment was read
     // and it's samples are in index_entries at the given position.
     // New index entries will be inserted before the index_entry found.
+    //
+    // Fragments are normally read in order, in which case no later
+    // fragment can have been read and the scan of the (possibly huge,
+    // prefilled from sidx or mfra) fragment index is skipped.
     index_entry_pos = st->nb_index_entries;
-    for (i = c->frag_index.current + 1; i < c->frag_index.nb_items; i++) {
-        frag_stream_info = get_frag_stream_info(&c->frag_index, i, frag->track_id);
-        if (frag_stream_info && frag_stream_info->index_entry >= 0) {
-            next_frag_index = i;
-            index_entry_pos = frag_stream_info->index_entry;
-            break;
+    if (c->frag_index.current < 0 || c->frag_index.current >= c->frag_index.nb_items ||
+        c->frag_index.item[c->frag_index.current].moof_offset < sc->frag_end) {
+        for (i = c->frag_index.current + 1; i < c->frag_index.nb_items; i++) {
+            frag_stream_info = get_frag_stream_info(&c->frag_index, i, frag->track_id);
+            if (frag_stream_info && frag_stream_info->index_entry >= 0) {
+                next_frag_index = i;
+                index_entry_pos = frag_stream_info->index_entry;
+                break;
+            }
         }
     }
 
@@ -4794,8 +4818,11 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc->ctts_count = st->nb_index_entries;
 
     // Record the index_entry position in frag_index of this fragment
-    if (frag_stream_info)
+    if (frag_stream_info) {
         frag_stream_info->index_entry = index_entry_pos;
+        sc->frag_end = FFMAX(sc->frag_end,
+                             c->frag_index.item[c->frag_index.current].moof_offset);
+    }
 
     if (index_entry_pos > 0)
         prev_dts = st->index_entries[index_entry_pos-1].timestamp;
@@ -7250,12 +7277,123 @@ static void export_orphan_timecode(AVFormatContext *s)
     }
 }
 
+typedef struct MOVTfraEntry {
+    int64_t time;
+    int64_t offset;
+} MOVTfraEntry;
+
+static void set_tfra_pts(MOVContext *mov, int index, unsigned track_id, int64_t time)
+{
+    MOVFragmentStreamInfo * frag_stream_info;
+
+    // The first sample of each stream in a fragment is always a random
+    // access sample.  So it's entry in the tfra can be used as the
+    // initial PTS of the fragment.
+    frag_stream_info = get_frag_stream_info(&mov->frag_index, index, track_id);
+    if (frag_stream_info &&
+        frag_stream_info->first_tfra_pts == AV_NOPTS_VALUE)
+        frag_stream_info->first_tfra_pts = time;
+}
+
+/**
+ * Add the fragments listed in a tfra to the fragment index.
+ *
+ * Inserting them one at a time is quadratic when they interleave with
+ * the fragments already in the index, as happens for the tfra of the
+ * second track of a file with one moof per track, so entries sorted by
+ * offset are merged into the index in a single pass.
+ */
+static int add_tfra_entries(MOVContext *mov, unsigned track_id,
+                            const MOVTfraEntry *entries, int nb_entries)
+{
+    MOVFragmentIndex *frag_index = &mov->frag_index;
+    MOVFragmentIndexItem *item;
+    MOVFragmentStreamInfo **new_info;
+    int i, j, k, nb_new = 0, nb_added;
+
+    for (i = 1; i < nb_entries; i++)
+        if (entries[i].offset < entries[i - 1].offset)
+            break;
+    if (i < nb_entries) {
+        for (i = 0; i < nb_entries; i++)
+            set_tfra_pts(mov, update_frag_index(mov, entries[i].offset),
+                         track_id, entries[i].time);
+        return 0;
+    }
+
+    // count the fragments which are not in the index yet
+    for (i = j = 0; i < nb_entries; i++) {
+        if (i && entries[i].offset == entries[i - 1].offset)
+            continue;
+        while (j < frag_index->nb_items &&
+               frag_index->item[j].moof_offset < entries[i].offset)
+            j++;
+        if (j == frag_index->nb_items ||
+            frag_index->item[j].moof_offset != entries[i].offset)
+            nb_new++;
+    }
+
+    if (nb_new) {
+        if (nb_new > INT_MAX / sizeof(*item) - frag_index->nb_items)
+            return AVERROR(ENOMEM);
+        item = av_fast_realloc(frag_index->item, &frag_index->allocated_size,
+                               (frag_index->nb_items + nb_new) * sizeof(*item));
+        if (!item)
+            return AVERROR(ENOMEM);
+        frag_index->item = item;
+        nb_added = nb_new;
+
+        new_info = av_malloc_array(nb_new, sizeof(*new_info));
+        if (!new_info)
+            return AVERROR(ENOMEM);
+        for (k = 0; k < nb_new; k++) {
+            new_info[k] = alloc_frag_stream_info(mov);
+            if (!new_info[k]) {
+                while (k--)
+                    av_freep(&new_info[k]);
+                av_free(new_info);
+                return AVERROR(ENOMEM);
+            }
+        }
+
+        // merge starting from the end, so that items are moved only once
+        i = nb_entries - 1;
+        j = frag_index->nb_items - 1;
+        k = frag_index->nb_items + nb_new - 1;
+        while (i >= 0) {
+            int64_t offset = entries[i].offset;
+
+            if (j >= 0 && item[j].moof_offset > offset) {
+                item[k--] = item[j--];
+            } else {
+                if ((j < 0 || item[j].moof_offset != offset) &&
+                    (i == 0 || entries[i - 1].offset != offset)) {
+                    init_frag_index_item(mov, &item[k], offset, new_info[--nb_new]);
+                    k--;
+                }
+                i--;
+            }
+        }
+        av_assert0(!nb_new && j == k);
+        frag_index->nb_items += nb_added;
+        av_free(new_info);
+    }
+
+    for (i = j = 0; i < nb_entries; i++) {
+        while (frag_index->item[j].moof_offset < entries[i].offset)
+            j++;
+        set_tfra_pts(mov, j, track_id, entries[i].time);
+    }
+    return 0;
+}
+
 static int read_tfra(MOVContext *mov, AVIOContext *f)
 {
-    int version, fieldlength, i, j;
+    int version, fieldlength, i, j, ret = 0;
     int64_t pos = avio_tell(f);
     uint32_t size = avio_rb32(f);
-    unsigned track_id, item_count;
+    unsigned track_id, item_count, allocated_size = 0;
+    MOVTfraEntry *entries = NULL, *tmp;
 
     if (avio_rb32(f) != MKBETAG('t', 'f', 'r', 'a')) {
         return 1;
@@ -7268,31 +7406,28 @@ static int read_tfra(MOVContext *mov, AVIOContext *f)
     fieldlength = avio_rb32(f);
     item_count = avio_rb32(f);
     for (i = 0; i < item_count; i++) {
-        int64_t time, offset;
-        int index;
-        MOVFragmentStreamInfo * frag_stream_info;
-
         if (avio_feof(f)) {
-            return AVERROR_INVALIDDATA;
+            ret = AVERROR_INVALIDDATA;
+            break;
         }
 
+        if (i >= INT_MAX / sizeof(*entries) - 1)
+            break;
+        tmp = av_fast_realloc(entries, &allocated_size, (i + 1) * sizeof(*entries));
+        if (!tmp) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        entries = tmp;
+
         if (version == 1) {
-            time   = avio_rb64(f);
-            offset = avio_rb64(f);
+            entries[i].time   = avio_rb64(f);
+            entries[i].offset = avio_rb64(f);
         } else {
-            time   = avio_rb32(f);
-            offset = avio_rb32(f);
+            entries[i].time   = avio_rb32(f);
+            entries[i].offset = avio_rb32(f);
         }
 
-        // The first sample of each stream in a fragment is always a random
-        // access sample.  So it's entry in the tfra can be used as the
-        // initial PTS of the fragment.
-        index = update_frag_index(mov, offset);
-        frag_stream_info = get_frag_stream_info(&mov->frag_index, index, track_id);
-        if (frag_stream_info &&
-            frag_stream_info->first_tfra_pts == AV_NOPTS_VALUE)
-            frag_stream_info->first_tfra_pts = time;
-
         for (j = 0; j < ((fieldlength >> 4) & 3) + 1; j++)
             avio_r8(f);
         for (j = 0; j < ((fieldlength >> 2) & 3) + 1; j++)
@@ -7301,6 +7436,15 @@ static int read_tfra(MOVContext *mov, AVIOContext *f)
             avio_r8(f);
     }
 
+    if (i) {
+        int err = add_tfra_entries(mov, track_id, entries, i);
+        if (err < 0 && !ret)
+            ret = err;
+    }
+    av_free(entries);
+    if (ret < 0)
+        return ret;
+
     avio_seek(f, pos + size, SEEK_SET);
     return 0;
 }
@@ -80,6 +80,7 @@ static const AVOption options[] = {
     { "use_metadata_tags", "Use mdta atom for metadata.", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_USE_MDTA}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "skip_trailer", "Skip writing the mfra/tfra/mfro trailer for fragmented files", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_SKIP_TRAILER}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "negative_cts_offsets", "Use negative CTS offsets (reducing the need for edit lists)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
+    { "reserve_moov", "Reserve space for the moov atom at the beginning of the file, estimated from the stream durations and bitrates", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RESERVE_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     FF_RTP_FLAG_OPTS(MOVMuxContext, rtp_flags),
     { "skip_iods", "Skip writing iods atom.", offsetof(MOVMuxContext, iods_skip), AV_OPT_TYPE_BOOL, {.i64 = 1}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
     { "iods_audio_profile", "iods audio profile atom.", offsetof(MOVMuxContext, iods_audio_profile), AV_OPT_TYPE_INT, {.i64 = -1}, -1, 255, AV_OPT_FLAG_ENCODING_PARAM},
@@ -6013,6 +6014,68 @@ static int mov_create_dvd_sub_decoder_specific_info(MOVTrack *track,
     return 0;
 }
 
+/*
+ * Estimate an upper bound of the moov size from the stream durations, rates
+ * and bitrates, so that it can be reserved before any packet is written.
+ * Returns 0 if the streams do not carry enough information.
+ */
+static int estimate_moov_size(AVFormatContext *s)
+{
+    int64_t size = 4096; /* mvhd, udta, and the extra timecode/chapter tracks */
+    int i;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        double duration, rate;
+        int64_t nb_samples, nb_chunks, sample_size;
+
+        if (st->duration > 0 && st->time_base.num > 0)
+            duration = st->duration * av_q2d(st->time_base);
+        else if (s->duration > 0)
+            duration = s->duration / (double)AV_TIME_BASE;
+        else
+            return 0;
+
+        switch (par->codec_type) {
+        case AVMEDIA_TYPE_VIDEO:
+            if (st->avg_frame_rate.num <= 0 || st->avg_frame_rate.den <= 0)
+                return 0;
+            rate = av_q2d(st->avg_frame_rate);
+            /* stsz, ctts and stss entries */
+            sample_size = 4 + 8 + 4;
+            break;
+        case AVMEDIA_TYPE_AUDIO:
+            if (par->sample_rate <= 0)
+                return 0;
+            rate = par->sample_rate / (double)(par->frame_size > 0 ? par->frame_size : 1024);
+            sample_size = 4;
+            break;
+        default:
+            rate = 10;
+            sample_size = 4 + 8;
+            break;
+        }
+
+        nb_samples = duration * rate + 1;
+        /* With several interleaved streams, every sample can start a new
+         * chunk; otherwise chunks are cut at 1 MiB. */
+        if (s->nb_streams > 1 || par->bit_rate <= 0)
+            nb_chunks = nb_samples;
+        else
+            nb_chunks = duration * par->bit_rate / (8 << 20) + 1;
+
+        /* co64 and stsc entries per chunk, plus the track and sample
+         * description atoms */
+        size += nb_samples * sample_size + nb_chunks * (8 + 12) +
+                1024 + par->extradata_size;
+        if (size > INT_MAX)
+            return 0;
+    }
+
+    return FFMIN(size + size / 8, INT_MAX);
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6059,7 +6122,12 @@ static int mov_init(AVFormatContext *s)
         s->flags &= ~AVFMT_FLAG_AUTO_BSF;
     }
 
-    if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV &&
+        !(mov->flags & FF_MOV_FLAG_FRAGMENT) && !mov->reserved_moov_size)
+        mov->reserved_moov_size = estimate_moov_size(s);
+
+    if (mov->flags & FF_MOV_FLAG_FASTSTART &&
+        !(mov->flags & FF_MOV_FLAG_RESERVE_MOOV && mov->reserved_moov_size > 0)) {
         mov->reserved_moov_size = -1;
     }
 
@@ -6411,7 +6479,7 @@ static int mov_write_header(AVFormatContext *s)
             !mov->max_fragment_duration && !mov->max_fragment_size)
             mov->flags |= FF_MOV_FLAG_FRAG_KEYFRAME;
     } else {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
+        if (mov->flags & FF_MOV_FLAG_FASTSTART && mov->reserved_moov_size < 0)
             mov->reserved_header_pos = avio_tell(pb);
         mov_write_mdat_tag(pb, mov);
     }
@@ -6672,17 +6740,29 @@ static int mov_write_trailer(AVFormatContext *s)
             ffio_wfourcc(pb, "mdat");
             avio_wb64(pb, mov->mdat_size + 16);
         }
+
+        if (mov->reserved_moov_size > 0 && mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+            /* If the reserved space turns out to be too small, turn it into
+             * a free atom and place the moov as if nothing was reserved. */
+            int moov_size = get_moov_size(s);
+            if (moov_size < 0)
+                return moov_size;
+            if (mov->reserved_moov_size - moov_size < 8) {
+                av_log(s, AV_LOG_WARNING, "Reserved moov space is too small, "
+                       "needed %d bytes instead of %d\n",
+                       moov_size + 8, mov->reserved_moov_size);
+                avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+                avio_wb32(pb, mov->reserved_moov_size);
+                ffio_wfourcc(pb, "free");
+                mov->reserved_moov_size = 0;
+                if (mov->flags & FF_MOV_FLAG_FASTSTART)
+                    mov->reserved_header_pos = mov->mdat_pos - 8;
+            }
+        }
+
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
-            av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
-            res = shift_data(s);
-            if (res < 0)
-                return res;
-            avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
-            if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
-                return res;
-        } else if (mov->reserved_moov_size > 0) {
+        if (mov->reserved_moov_size > 0) {
             int64_t size;
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
                 return res;
@@ -6695,6 +6775,14 @@ static int mov_write_trailer(AVFormatContext *s)
             ffio_wfourcc(pb, "free");
             ffio_fill(pb, 0, size - 8);
             avio_seek(pb, moov_pos, SEEK_SET);
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+            av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
+            res = shift_data(s);
+            if (res < 0)
+                return res;
+            avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+            if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
+                return res;
         } else {
             if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
                 return res;
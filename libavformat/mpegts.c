@@ -2559,7 +2559,8 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
 
         // stop find_stream_info from waiting for more streams
         // when all programs have received a PMT
-        if (ts->stream->ctx_flags & AVFMTCTX_NOHEADER && ts->scan_all_pmts <= 0) {
+        if (ts->stream->ctx_flags & AVFMTCTX_NOHEADER &&
+            (ts->scan_all_pmts <= 0 || ts->stream->flags & AVFMT_FLAG_FAST_PROBE)) {
             int i;
             for (i = 0; i < ts->nb_prg; i++) {
                 if (!ts->prg[i].pmt_found)
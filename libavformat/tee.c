@@ -23,6 +23,8 @@
 #include "libavutil/avutil.h"
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
 #include "internal.h"
 #include "avformat.h"
 #include "avio_internal.h"
@@ -35,6 +37,21 @@ typedef enum {
 
 #define DEFAULT_SLAVE_FAILURE_POLICY ON_SLAVE_FAILURE_ABORT
 
+typedef enum {
+    ON_QUEUE_FULL_BLOCK = 0,
+    ON_QUEUE_FULL_DROP  = 1
+} QueueFullPolicy;
+
+typedef enum {
+    TEE_WRITE_PACKET,
+    TEE_FLUSH_OUTPUT
+} TeeMessageType;
+
+typedef struct TeeMessage {
+    TeeMessageType type;
+    AVPacket pkt;
+} TeeMessage;
+
 typedef struct {
     AVFormatContext *avf;
     AVBSFContext **bsfs; ///< bitstream filters per stream
@@ -47,6 +64,23 @@ typedef struct {
      * disabled output streams are set to -1 */
     int *stream_map;
     int header_written;
+
+    int use_threads;
+    int queue_size;
+    QueueFullPolicy on_queue_full;
+    AVThreadMessageQueue *queue;
+#if HAVE_THREADS
+    pthread_t thread;
+#endif
+    int thread_started;
+    int thread_ret;          ///< error of the writer thread, read after joining it
+    uint8_t *drop_until_key; ///< per input stream, set after a packet was dropped
+
+    /* queue statistics */
+    int64_t nb_queued;
+    int64_t nb_dropped;
+    int64_t depth_sum;
+    int max_depth;
 } TeeSlave;
 
 typedef struct TeeContext {
@@ -57,6 +91,9 @@ typedef struct TeeContext {
     int use_fifo;
     AVDictionary *fifo_options;
     char *fifo_options_str;
+    int use_threads;
+    int queue_size;
+    int on_queue_full;
 } TeeContext;
 
 static const char *const slave_delim     = "|";
@@ -69,6 +106,14 @@ static const AVOption options[] = {
          OFFSET(use_fifo), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
         {"fifo_options", "fifo pseudo-muxer options", OFFSET(fifo_options_str),
          AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM},
+        {"use_threads", "Write to each slave muxer from its own thread",
+         OFFSET(use_threads), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
+        {"queue_size", "Number of packets queued for each slave writer thread",
+         OFFSET(queue_size), AV_OPT_TYPE_INT, {.i64 = 60}, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
+        {"queue_full", "What to do when the queue of a slave writer thread is full",
+         OFFSET(on_queue_full), AV_OPT_TYPE_INT, {.i64 = ON_QUEUE_FULL_BLOCK}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM, "queue_full"},
+            {"block", "wait for the slave to catch up", 0, AV_OPT_TYPE_CONST, {.i64 = ON_QUEUE_FULL_BLOCK}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "queue_full"},
+            {"drop",  "drop packets until the next keyframe", 0, AV_OPT_TYPE_CONST, {.i64 = ON_QUEUE_FULL_DROP}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, "queue_full"},
         {NULL}
 };
 
@@ -119,18 +164,185 @@ static int parse_slave_fifo_options(const char *use_fifo,
     return ret;
 }
 
+static int parse_slave_thread_options(const char *use_threads, const char *queue_size,
+                                      const char *on_queue_full, TeeSlave *tee_slave)
+{
+    if (use_threads) {
+        if (av_match_name(use_threads, "true,y,yes,enable,enabled,on,1")) {
+            tee_slave->use_threads = 1;
+        } else if (av_match_name(use_threads, "false,n,no,disable,disabled,off,0")) {
+            tee_slave->use_threads = 0;
+        } else {
+            return AVERROR(EINVAL);
+        }
+    }
+
+    if (queue_size) {
+        char *end;
+        long size = strtol(queue_size, &end, 10);
+        if (*end || size <= 0 || size > INT_MAX)
+            return AVERROR(EINVAL);
+        tee_slave->queue_size = size;
+    }
+
+    if (on_queue_full) {
+        if (!av_strcasecmp(on_queue_full, "block"))
+            tee_slave->on_queue_full = ON_QUEUE_FULL_BLOCK;
+        else if (!av_strcasecmp(on_queue_full, "drop"))
+            tee_slave->on_queue_full = ON_QUEUE_FULL_DROP;
+        else
+            return AVERROR(EINVAL);
+    }
+
+    return 0;
+}
+
+static int slave_write_packet(TeeSlave *tee_slave, AVPacket *pkt)
+{
+    AVFormatContext *avf2 = tee_slave->avf;
+    AVBSFContext *bsfs;
+    int s2 = pkt->stream_index;
+    int ret;
+
+    bsfs = tee_slave->bsfs[s2];
+    ret = av_bsf_send_packet(bsfs, pkt);
+    if (ret < 0) {
+        av_log(avf2, AV_LOG_ERROR, "Error while sending packet to bitstream filter: %s\n",
+               av_err2str(ret));
+        av_packet_unref(pkt);
+        return ret;
+    }
+
+    while(1) {
+        ret = av_bsf_receive_packet(bsfs, pkt);
+        if (ret == AVERROR(EAGAIN)) {
+            ret = 0;
+            break;
+        } else if (ret < 0) {
+            break;
+        }
+
+        av_packet_rescale_ts(pkt, bsfs->time_base_out,
+                             avf2->streams[s2]->time_base);
+        ret = av_interleaved_write_frame(avf2, pkt);
+        if (ret < 0)
+            break;
+    };
+
+    return ret;
+}
+
+#if HAVE_THREADS
+static void *slave_writer_thread(void *arg)
+{
+    TeeSlave *tee_slave = arg;
+    TeeMessage msg;
+    int ret;
+
+    while ((ret = av_thread_message_queue_recv(tee_slave->queue, &msg, 0)) >= 0) {
+        if (msg.type == TEE_FLUSH_OUTPUT)
+            ret = av_interleaved_write_frame(tee_slave->avf, NULL);
+        else
+            ret = slave_write_packet(tee_slave, &msg.pkt);
+        if (ret < 0) {
+            tee_slave->thread_ret = ret;
+            av_thread_message_queue_set_err_send(tee_slave->queue, ret);
+            break;
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+static void free_message(void *msg)
+{
+    TeeMessage *tee_msg = msg;
+
+    if (tee_msg->type == TEE_WRITE_PACKET)
+        av_packet_unref(&tee_msg->pkt);
+}
+
+static int start_slave_thread(AVFormatContext *avf, TeeSlave *tee_slave)
+{
+#if HAVE_THREADS
+    int ret;
+
+    tee_slave->drop_until_key = av_mallocz(avf->nb_streams);
+    if (!tee_slave->drop_until_key)
+        return AVERROR(ENOMEM);
+
+    ret = av_thread_message_queue_alloc(&tee_slave->queue, tee_slave->queue_size,
+                                        sizeof(TeeMessage));
+    if (ret < 0)
+        return ret;
+    av_thread_message_queue_set_free_func(tee_slave->queue, free_message);
+
+    ret = pthread_create(&tee_slave->thread, NULL, slave_writer_thread, tee_slave);
+    if (ret) {
+        av_log(avf, AV_LOG_ERROR, "Failed to start thread: %s\n",
+               av_err2str(AVERROR(ret)));
+        return AVERROR(ret);
+    }
+    tee_slave->thread_started = 1;
+    return 0;
+#else
+    av_log(avf, AV_LOG_ERROR, "Threaded slave writing requires thread support\n");
+    return AVERROR(ENOSYS);
+#endif
+}
+
+/* Signal the writer thread that no more packets will come; it still writes
+ * the queued ones. */
+static void finish_slave_thread(TeeSlave *tee_slave)
+{
+    if (tee_slave->queue)
+        av_thread_message_queue_set_err_recv(tee_slave->queue, AVERROR_EOF);
+}
+
+static int stop_slave_thread(TeeSlave *tee_slave)
+{
+    int ret = 0;
+
+#if HAVE_THREADS
+    if (tee_slave->thread_started) {
+        finish_slave_thread(tee_slave);
+        pthread_join(tee_slave->thread, NULL);
+        tee_slave->thread_started = 0;
+        ret = tee_slave->thread_ret;
+
+        if (tee_slave->nb_queued) {
+            int level = tee_slave->nb_dropped ? AV_LOG_WARNING : AV_LOG_VERBOSE;
+            av_log(tee_slave->avf, level, "Queued %"PRId64" packets, dropped %"PRId64", "
+                   "queue depth average %.1f maximum %d of %d\n",
+                   tee_slave->nb_queued, tee_slave->nb_dropped,
+                   tee_slave->depth_sum / (double)tee_slave->nb_queued,
+                   tee_slave->max_depth, tee_slave->queue_size);
+        }
+    }
+#endif
+    av_thread_message_queue_free(&tee_slave->queue);
+    av_freep(&tee_slave->drop_until_key);
+    return ret;
+}
+
 static int close_slave(TeeSlave *tee_slave)
 {
     AVFormatContext *avf;
     unsigned i;
-    int ret = 0;
+    int ret = 0, ret2;
 
     avf = tee_slave->avf;
     if (!avf)
         return 0;
 
-    if (tee_slave->header_written)
-        ret = av_write_trailer(avf);
+    ret = stop_slave_thread(tee_slave);
+
+    if (tee_slave->header_written) {
+        ret2 = av_write_trailer(avf);
+        if (!ret)
+            ret = ret2;
+    }
 
     if (tee_slave->bsfs) {
         for (i = 0; i < avf->nb_streams; ++i)
@@ -164,6 +376,7 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
     char *filename;
     char *format = NULL, *select = NULL, *on_fail = NULL;
     char *use_fifo = NULL, *fifo_options_str = NULL;
+    char *use_threads = NULL, *queue_size = NULL, *on_queue_full = NULL;
     AVFormatContext *avf2 = NULL;
     AVStream *st, *st2;
     int stream_count;
@@ -186,6 +399,9 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
     STEAL_OPTION("onfail", on_fail);
     STEAL_OPTION("use_fifo", use_fifo);
     STEAL_OPTION("fifo_options", fifo_options_str);
+    STEAL_OPTION("use_threads", use_threads);
+    STEAL_OPTION("queue_size", queue_size);
+    STEAL_OPTION("queue_full", on_queue_full);
 
     ret = parse_slave_failure_policy_option(on_fail, tee_slave);
     if (ret < 0) {
@@ -200,6 +416,12 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
         goto end;
     }
 
+    ret = parse_slave_thread_options(use_threads, queue_size, on_queue_full, tee_slave);
+    if (ret < 0) {
+        av_log(avf, AV_LOG_ERROR, "Error parsing thread options: %s\n", av_err2str(ret));
+        goto end;
+    }
+
     if (tee_slave->use_fifo) {
 
         if (options) {
@@ -393,10 +615,19 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
         goto end;
     }
 
+    if (tee_slave->use_threads) {
+        ret = start_slave_thread(avf, tee_slave);
+        if (ret < 0)
+            goto end;
+    }
+
 end:
     av_free(format);
     av_free(select);
     av_free(on_fail);
+    av_free(use_threads);
+    av_free(queue_size);
+    av_free(on_queue_full);
     av_dict_free(&options);
     av_freep(&tmp_select);
     return ret;
@@ -405,8 +636,9 @@ end:
 static void log_slave(TeeSlave *slave, void *log_ctx, int log_level)
 {
     int i;
-    av_log(log_ctx, log_level, "filename:'%s' format:%s\n",
-           slave->avf->url, slave->avf->oformat->name);
+    av_log(log_ctx, log_level, "filename:'%s' format:%s%s\n",
+           slave->avf->url, slave->avf->oformat->name,
+           slave->use_threads ? " threaded" : "");
     for (i = 0; i < slave->avf->nb_streams; i++) {
         AVStream *st = slave->avf->streams[i];
         AVBSFContext *bsf = slave->bsfs[i];
@@ -482,6 +714,9 @@ static int tee_write_header(AVFormatContext *avf)
     for (i = 0; i < nb_slaves; i++) {
 
         tee->slaves[i].use_fifo = tee->use_fifo;
+        tee->slaves[i].use_threads = tee->use_threads;
+        tee->slaves[i].queue_size = tee->queue_size;
+        tee->slaves[i].on_queue_full = tee->on_queue_full;
         ret = av_dict_copy(&tee->slaves[i].fifo_options, tee->fifo_options, 0);
         if (ret < 0)
             goto fail;
@@ -522,6 +757,10 @@ static int tee_write_trailer(AVFormatContext *avf)
     int ret_all = 0, ret;
     unsigned i;
 
+    /* let all writer threads drain their queues concurrently */
+    for (i = 0; i < tee->nb_slaves; i++)
+        finish_slave_thread(&tee->slaves[i]);
+
     for (i = 0; i < tee->nb_slaves; i++) {
         if ((ret = close_slave(&tee->slaves[i])) < 0) {
             ret = tee_process_slave_failure(avf, i, ret);
@@ -533,11 +772,71 @@ static int tee_write_trailer(AVFormatContext *avf)
     return ret_all;
 }
 
+static void tee_deinit(AVFormatContext *avf)
+{
+    TeeContext *tee = avf->priv_data;
+    unsigned i;
+
+    /* Slaves are only left if the trailer was not written, stop their
+     * writer threads before freeing them, without writing their trailers. */
+    if (tee->slaves) {
+        for (i = 0; i < tee->nb_slaves; i++) {
+            stop_slave_thread(&tee->slaves[i]);
+            tee->slaves[i].header_written = 0;
+        }
+        close_slaves(avf);
+    }
+    av_dict_free(&tee->fifo_options);
+}
+
+static int tee_queue_packet(TeeSlave *tee_slave, AVPacket *pkt)
+{
+    TeeMessage msg = { .type = pkt ? TEE_WRITE_PACKET : TEE_FLUSH_OUTPUT };
+    int ret, depth, in_stream = pkt ? pkt->stream_index : 0;
+
+    if (pkt && tee_slave->drop_until_key[in_stream]) {
+        if (!(pkt->flags & AV_PKT_FLAG_KEY)) {
+            tee_slave->nb_dropped++;
+            return 0;
+        }
+        tee_slave->drop_until_key[in_stream] = 0;
+    }
+
+    if (pkt) {
+        av_init_packet(&msg.pkt);
+        ret = av_packet_ref(&msg.pkt, pkt);
+        if (ret < 0)
+            return ret;
+        msg.pkt.stream_index = tee_slave->stream_map[in_stream];
+    }
+
+    depth = av_thread_message_queue_nb_elems(tee_slave->queue);
+    ret = av_thread_message_queue_send(tee_slave->queue, &msg,
+                                       pkt && tee_slave->on_queue_full == ON_QUEUE_FULL_DROP ?
+                                       AV_THREAD_MESSAGE_NONBLOCK : 0);
+    if (ret == AVERROR(EAGAIN)) {
+        if (!tee_slave->nb_dropped)
+            av_log(tee_slave->avf, AV_LOG_WARNING, "Slave queue full, dropping packets\n");
+        tee_slave->nb_dropped++;
+        tee_slave->drop_until_key[in_stream] = 1;
+        av_packet_unref(&msg.pkt);
+        return 0;
+    } else if (ret < 0) {
+        if (pkt)
+            av_packet_unref(&msg.pkt);
+        return ret;
+    }
+
+    tee_slave->nb_queued++;
+    tee_slave->depth_sum += depth;
+    tee_slave->max_depth = FFMAX(tee_slave->max_depth, depth + 1);
+    return 0;
+}
+
 static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
 {
     TeeContext *tee = avf->priv_data;
     AVFormatContext *avf2;
-    AVBSFContext *bsfs;
     AVPacket pkt2;
     int ret_all = 0, ret;
     unsigned i, s;
@@ -547,6 +846,18 @@ static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
         if (!(avf2 = tee->slaves[i].avf))
             continue;
 
+        if (tee->slaves[i].use_threads) {
+            if (pkt && tee->slaves[i].stream_map[pkt->stream_index] < 0)
+                continue;
+            ret = tee_queue_packet(&tee->slaves[i], pkt);
+            if (ret < 0) {
+                ret = tee_process_slave_failure(avf, i, ret);
+                if (!ret_all && ret < 0)
+                    ret_all = ret;
+            }
+            continue;
+        }
+
         /* Flush slave if pkt is NULL*/
         if (!pkt) {
             ret = av_interleaved_write_frame(avf2, NULL);
@@ -569,34 +880,9 @@ static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
                 ret_all = ret;
                 continue;
             }
-        bsfs = tee->slaves[i].bsfs[s2];
         pkt2.stream_index = s2;
 
-        ret = av_bsf_send_packet(bsfs, &pkt2);
-        if (ret < 0) {
-            av_log(avf, AV_LOG_ERROR, "Error while sending packet to bitstream filter: %s\n",
-                   av_err2str(ret));
-            ret = tee_process_slave_failure(avf, i, ret);
-            if (!ret_all && ret < 0)
-                ret_all = ret;
-        }
-
-        while(1) {
-            ret = av_bsf_receive_packet(bsfs, &pkt2);
-            if (ret == AVERROR(EAGAIN)) {
-                ret = 0;
-                break;
-            } else if (ret < 0) {
-                break;
-            }
-
-            av_packet_rescale_ts(&pkt2, bsfs->time_base_out,
-                                 avf2->streams[s2]->time_base);
-            ret = av_interleaved_write_frame(avf2, &pkt2);
-            if (ret < 0)
-                break;
-        };
-
+        ret = slave_write_packet(&tee->slaves[i], &pkt2);
         if (ret < 0) {
             ret = tee_process_slave_failure(avf, i, ret);
             if (!ret_all && ret < 0)
@@ -613,6 +899,7 @@ AVOutputFormat ff_tee_muxer = {
     .write_header      = tee_write_header,
     .write_trailer     = tee_write_trailer,
     .write_packet      = tee_write_packet,
+    .deinit            = tee_deinit,
     .priv_class        = &tee_muxer_class,
     .flags             = AVFMT_NOFILE | AVFMT_ALLOW_FLUSH,
 };
@@ -0,0 +1,250 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Write a fragmented MP4 file with one moof per track and fragment into
+ * memory and demux it again, with and without the mfra index.
+ *
+ * Usage: movfrag [nb_fragments]
+ * When the number of fragments is given, the time taken to open and read
+ * the file is printed as well, e.g. "movfrag 200000" benchmarks a file
+ * with 400000 moof boxes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+#include "libavformat/avformat.h"
+
+#define HASH_SIZE 16
+
+static const uint8_t aac_extradata[] = {
+    0x12, 0x10
+};
+
+typedef struct Buffer {
+    uint8_t *data;
+    int size;
+    int64_t pos;
+} Buffer;
+
+static int io_read(void *opaque, uint8_t *buf, int size)
+{
+    Buffer *b = opaque;
+
+    size = FFMIN(size, b->size - b->pos);
+    if (size <= 0)
+        return AVERROR_EOF;
+    memcpy(buf, b->data + b->pos, size);
+    b->pos += size;
+    return size;
+}
+
+static int64_t io_seek(void *opaque, int64_t offset, int whence)
+{
+    Buffer *b = opaque;
+
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return b->size;
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += b->pos;
+        break;
+    case SEEK_END:
+        offset += b->size;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (offset < 0 || offset > b->size)
+        return AVERROR(EINVAL);
+    return b->pos = offset;
+}
+
+static int write_file(Buffer *b, int nb_fragments)
+{
+    AVFormatContext *ctx = NULL;
+    AVDictionary *opts = NULL;
+    AVStream *st[2];
+    AVPacket pkt;
+    uint8_t data[16] = { 0 };
+    int i, j, ret;
+
+    if ((ret = avformat_alloc_output_context2(&ctx, NULL, "mp4", NULL)) < 0)
+        return ret;
+    ctx->flags |= AVFMT_FLAG_BITEXACT;
+
+    for (i = 0; i < 2; i++) {
+        if (!(st[i] = avformat_new_stream(ctx, NULL))) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+    st[0]->codecpar->codec_type  = AVMEDIA_TYPE_VIDEO;
+    st[0]->codecpar->codec_id    = AV_CODEC_ID_MPEG4;
+    st[0]->codecpar->width       = 64;
+    st[0]->codecpar->height      = 64;
+    st[0]->time_base             = (AVRational){ 1, 25 };
+    st[1]->codecpar->codec_type  = AVMEDIA_TYPE_AUDIO;
+    st[1]->codecpar->codec_id    = AV_CODEC_ID_AAC;
+    st[1]->codecpar->sample_rate = 44100;
+    st[1]->codecpar->channels    = 2;
+    st[1]->codecpar->frame_size  = 1024;
+    st[1]->time_base             = (AVRational){ 1, 44100 };
+    st[1]->codecpar->extradata   = av_mallocz(sizeof(aac_extradata) + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!st[1]->codecpar->extradata) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    memcpy(st[1]->codecpar->extradata, aac_extradata, sizeof(aac_extradata));
+    st[1]->codecpar->extradata_size = sizeof(aac_extradata);
+
+    if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0)
+        goto end;
+    av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov+separate_moof", 0);
+    if ((ret = avformat_write_header(ctx, &opts)) < 0)
+        goto end;
+
+    for (i = 0; i < nb_fragments; i++) {
+        for (j = 0; j < 2; j++) {
+            av_init_packet(&pkt);
+            pkt.data         = data;
+            pkt.size         = sizeof(data);
+            pkt.stream_index = j;
+            pkt.flags        = AV_PKT_FLAG_KEY;
+            pkt.pts = pkt.dts = j ? i * 1764LL : i;
+            pkt.duration     = j ? 1764 : 1;
+            av_packet_rescale_ts(&pkt, j ? st[1]->time_base : (AVRational){ 1, 25 },
+                                 st[j]->time_base);
+            if ((ret = av_write_frame(ctx, &pkt)) < 0)
+                goto end;
+        }
+    }
+    ret = av_write_trailer(ctx);
+
+end:
+    if (ctx->pb)
+        b->size = avio_close_dyn_buf(ctx->pb, &b->data);
+    ctx->pb = NULL;
+    av_dict_free(&opts);
+    avformat_free_context(ctx);
+    return ret;
+}
+
+static int read_file(Buffer *b, const char *use_mfra_for, int bench)
+{
+    AVFormatContext *ctx;
+    AVIOContext *pb;
+    AVDictionary *opts = NULL;
+    AVPacket pkt;
+    struct AVMD5 *md5 = av_md5_alloc();
+    uint8_t *iobuf = av_malloc(32768), hash[HASH_SIZE];
+    int64_t t0, t1, t2, seek_dts = AV_NOPTS_VALUE;
+    int nb_packets[2] = { 0 };
+    int i, ret;
+
+    ctx = avformat_alloc_context();
+    pb  = avio_alloc_context(iobuf, 32768, 0, b, io_read, NULL, io_seek);
+    if (!md5 || !iobuf || !ctx || !pb) {
+        if (!pb)
+            av_free(iobuf);
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    ctx->pb = pb;
+    b->pos  = 0;
+
+    av_dict_set(&opts, "use_mfra_for", use_mfra_for, 0);
+    t0 = av_gettime_relative();
+    ret = avformat_open_input(&ctx, NULL, av_find_input_format("mov"), &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        goto end;
+    t1 = av_gettime_relative();
+
+    av_md5_init(md5);
+    while ((ret = av_read_frame(ctx, &pkt)) >= 0) {
+        uint8_t buf[20];
+
+        if (pkt.stream_index < 2)
+            nb_packets[pkt.stream_index]++;
+        AV_WL32(buf,      pkt.stream_index);
+        AV_WL64(buf +  4, pkt.dts);
+        AV_WL64(buf + 12, pkt.pos);
+        av_md5_update(md5, buf, sizeof(buf));
+        av_packet_unref(&pkt);
+    }
+    av_md5_final(md5, hash);
+    t2 = av_gettime_relative();
+
+    ret = av_seek_frame(ctx, 0, nb_packets[0] / 2, 0);
+    if (ret >= 0 && (ret = av_read_frame(ctx, &pkt)) >= 0) {
+        seek_dts = pkt.dts;
+        av_packet_unref(&pkt);
+    }
+
+    printf("use_mfra_for %s: %d video, %d audio packets, seek dts %"PRId64", ",
+           use_mfra_for, nb_packets[0], nb_packets[1], seek_dts);
+    for (i = 0; i < HASH_SIZE; i++)
+        printf("%02x", hash[i]);
+    printf("\n");
+    if (bench)
+        printf("open %"PRId64" ms, read %"PRId64" ms\n",
+               (t1 - t0) / 1000, (t2 - t1) / 1000);
+    ret = 0;
+
+end:
+    avformat_close_input(&ctx);
+    if (pb)
+        av_freep(&pb->buffer);
+    avio_context_free(&pb);
+    av_free(md5);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const modes[] = { "auto", "dts", "pts" };
+    Buffer b = { 0 };
+    int nb_fragments = argc > 1 ? atoi(argv[1]) : 500;
+    int i, ret;
+
+    if ((ret = write_file(&b, nb_fragments)) < 0) {
+        fprintf(stderr, "Failed to write the file\n");
+        av_free(b.data);
+        return 1;
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(modes); i++) {
+        if (read_file(&b, modes[i], argc > 1) < 0) {
+            fprintf(stderr, "Failed to read the file\n");
+            ret = 1;
+        }
+    }
+
+    av_free(b.data);
+    return ret ? 1 : 0;
+}
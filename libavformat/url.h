@@ -49,6 +49,8 @@ typedef struct URLContext {
     const char *protocol_whitelist;
     const char *protocol_blacklist;
     int min_packet_size;        /**< if non zero, the stream is packetized with this min packet size */
+    int readahead_size;         /**< if non zero, size of the background read-ahead window of the AVIOContext, in bytes */
+    int writebehind_size;       /**< if non zero, size of the background write-behind buffer of the AVIOContext, in bytes */
 } URLContext;
 
 typedef struct URLProtocol {
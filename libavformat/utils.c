@@ -3011,6 +3011,31 @@ static int has_codec_parameters(AVStream *st, const char **errmsg_ptr)
     return 1;
 }
 
+/**
+ * Copy the video parameters the parser found in the stream headers (the
+ * H.264/HEVC SPS, MPEG-1/2 sequence header...) into the codec context, so
+ * that fast probing does not have to decode a frame to get them.
+ */
+static void fill_parser_parameters(AVStream *st)
+{
+    AVCodecContext *avctx = st->internal->avctx;
+    AVCodecParserContext *pc = st->parser;
+
+    if (!pc || avctx->codec_type != AVMEDIA_TYPE_VIDEO)
+        return;
+
+    if (!avctx->width && pc->width > 0 && pc->height > 0) {
+        avctx->width        = pc->width;
+        avctx->height       = pc->height;
+        avctx->coded_width  = pc->coded_width;
+        avctx->coded_height = pc->coded_height;
+    }
+    if (avctx->pix_fmt == AV_PIX_FMT_NONE && pc->format >= 0)
+        avctx->pix_fmt = pc->format;
+    if (avctx->field_order == AV_FIELD_UNKNOWN)
+        avctx->field_order = pc->field_order;
+}
+
 /* returns 1 or 0 if or if not decoded data was returned, or a negative error */
 static int try_decode_frame(AVFormatContext *s, AVStream *st, AVPacket *avpkt,
                             AVDictionary **options)
@@ -3565,7 +3590,7 @@ static int extract_extradata(AVStream *st, AVPacket *pkt)
 int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 {
     int i, count = 0, ret = 0, j;
-    int64_t read_size;
+    int64_t read_size = 0;
     AVStream *st;
     AVCodecContext *avctx;
     AVPacket pkt1, *pkt;
@@ -3579,6 +3604,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     int64_t probesize = ic->probesize;
     int eof_reached = 0;
     int *missing_streams = av_opt_ptr(ic->iformat->priv_class, ic->priv_data, "missing_streams");
+    int fast_probe = ic->flags & AVFMT_FLAG_FAST_PROBE;
+    int64_t probe_start = av_gettime_relative();
+    int64_t bytes_start = ic->pb ? ic->pb->bytes_read : 0;
 
     flush_codecs = probesize > 0;
 
@@ -3700,6 +3728,10 @@ FF_ENABLE_DEPRECATION_WARNINGS
             int count;
 
             st = ic->streams[i];
+            /* Streams the caller discards are not waited for when fast
+             * probing. */
+            if (fast_probe && st->discard >= AVDISCARD_ALL)
+                continue;
             if (!has_codec_parameters(st, NULL))
                 break;
             /* If the timebase is coarse (like the usual millisecond precision
@@ -3713,6 +3745,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
                 fps_analyze_framecount = ic->fps_probe_size;
             if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
                 fps_analyze_framecount = 0;
+            /* the frame rate is taken from the headers when fast probing */
+            if (fast_probe)
+                fps_analyze_framecount = 0;
             /* variable fps and no guess at the real fps */
             count = (ic->iformat->flags & AVFMT_NOTIMESTAMPS) ?
                        st->info->codec_info_duration_fields/2 :
@@ -3724,7 +3759,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
             }
             // Look at the first 3 frames if there is evidence of frame delay
             // but the decoder delay is not set.
-            if (st->info->frame_delay_evidence && count < 2 && st->internal->avctx->has_b_frames == 0)
+            if (!fast_probe && st->info->frame_delay_evidence && count < 2 &&
+                st->internal->avctx->has_b_frames == 0)
                 break;
             if (!st->internal->avctx->extradata &&
                 (!st->internal->extract_extradata.inited ||
@@ -3897,9 +3933,15 @@ FF_ENABLE_DEPRECATION_WARNINGS
          * If AV_CODEC_CAP_CHANNEL_CONF is set this will force decoding of at
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
-         * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+         * the container.
+         *
+         * When fast probing, the parameters found by the parser are used and
+         * the decoder is only run for those still missing. */
+        if (fast_probe)
+            fill_parser_parameters(st);
+        if (!fast_probe || !has_codec_parameters(st, NULL))
+            try_decode_frame(ic, st, pkt,
+                             (options && i < orig_nb_streams) ? &options[i] : NULL);
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt);
@@ -3971,6 +4013,11 @@ FF_ENABLE_DEPRECATION_WARNINGS
                     avctx->codec_tag= tag;
             }
 
+            /* with few frames analyzed, prefer the header frame rate */
+            if (fast_probe && !st->avg_frame_rate.num &&
+                avctx->framerate.num > 0 && avctx->framerate.den > 0)
+                st->avg_frame_rate = avctx->framerate;
+
             /* estimate average framerate if not set by demuxer */
             if (st->info->codec_info_duration_fields &&
                 !st->avg_frame_rate.num &&
@@ -4161,6 +4208,9 @@ find_stream_info_err:
     if (ic->pb)
         av_log(ic, AV_LOG_DEBUG, "After avformat_find_stream_info() pos: %"PRId64" bytes read:%"PRId64" seeks:%d frames:%d\n",
                avio_tell(ic->pb), ic->pb->bytes_read, ic->pb->seek_count, count);
+    av_log(ic, AV_LOG_VERBOSE, "Stream info probed in %"PRId64" us, %"PRId64" bytes read, "
+           "%"PRId64" bytes of packets analyzed\n", av_gettime_relative() - probe_start,
+           ic->pb ? ic->pb->bytes_read - bytes_start : 0, read_size);
     return ret;
 }
 
@@ -355,3 +355,190 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 
     return ret;
 }
+
+/*
+ * Map a request size to its size class. Above the minimum, each power of two
+ * is split into 4 classes, so that at most a quarter of a buffer is wasted.
+ */
+static int shared_pool_class(int size, size_t *class_size)
+{
+    int bits, idx;
+
+    if (size <= 1 << SHARED_POOL_MIN_BITS) {
+        *class_size = 1 << SHARED_POOL_MIN_BITS;
+        return 0;
+    }
+
+    bits = av_log2(size - 1);
+    idx  = (size - (1 << bits) + (1 << (bits - 2)) - 1) >> (bits - 2);
+
+    *class_size = ((size_t)1 << bits) + ((size_t)idx << (bits - 2));
+    return (bits - SHARED_POOL_MIN_BITS) * 4 + idx;
+}
+
+static void shared_pool_free_entry(SharedPool *pool, SharedPoolEntry *buf)
+{
+    pool->stats.allocated_bytes -= buf->size;
+    av_freep(&buf->data);
+    av_freep(&buf);
+}
+
+/* drop cached buffers, largest classes first, until at most max_cached
+ * bytes remain cached; must be called with the mutex held */
+static void shared_pool_trim(SharedPool *pool, int64_t max_cached)
+{
+    int i;
+
+    for (i = SHARED_POOL_NB_CLASSES - 1; i >= 0; i--) {
+        while (pool->cache[i] && pool->stats.cached_bytes > max_cached) {
+            SharedPoolEntry *buf = pool->cache[i];
+            pool->cache[i] = buf->next;
+            pool->stats.cached_bytes -= buf->size;
+            shared_pool_free_entry(pool, buf);
+        }
+    }
+}
+
+static void shared_pool_free(SharedPool *pool)
+{
+    shared_pool_trim(pool, 0);
+    ff_mutex_destroy(&pool->mutex);
+    av_freep(&pool);
+}
+
+static void shared_pool_unref(SharedPool *pool)
+{
+    if (atomic_fetch_add_explicit(&pool->refcount, -1, memory_order_acq_rel) == 1)
+        shared_pool_free(pool);
+}
+
+static void shared_pool_free_ref(void *opaque, uint8_t *data)
+{
+    shared_pool_unref((SharedPool *)data);
+}
+
+static void shared_pool_release_buffer(void *opaque, uint8_t *data)
+{
+    SharedPoolEntry *buf = opaque;
+    SharedPool *pool = buf->pool;
+
+    if(CONFIG_MEMORY_POISONING)
+        memset(buf->data, FF_MEMORY_POISON, buf->size);
+
+    ff_mutex_lock(&pool->mutex);
+    buf->next = pool->cache[buf->cls];
+    pool->cache[buf->cls] = buf;
+    pool->stats.cached_bytes += buf->size;
+    ff_mutex_unlock(&pool->mutex);
+
+    shared_pool_unref(pool);
+}
+
+AVBufferRef *av_buffer_shared_pool_alloc(int64_t max_bytes)
+{
+    SharedPool *pool;
+    AVBufferRef *ref;
+
+    if (max_bytes < 0)
+        return NULL;
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+
+    ref = av_buffer_create((uint8_t *)pool, sizeof(*pool),
+                           shared_pool_free_ref, NULL, 0);
+    if (!ref) {
+        av_freep(&pool);
+        return NULL;
+    }
+
+    ff_mutex_init(&pool->mutex, NULL);
+    pool->max_bytes = max_bytes;
+    atomic_init(&pool->refcount, 1);
+
+    return ref;
+}
+
+AVBufferRef *av_buffer_shared_pool_get(AVBufferRef *ref, int size)
+{
+    SharedPool *pool = (SharedPool *)ref->data;
+    SharedPoolEntry *buf;
+    AVBufferRef *ret;
+    size_t class_size;
+    int cls;
+
+    if (size < 0)
+        return NULL;
+    cls = shared_pool_class(size, &class_size);
+
+    ff_mutex_lock(&pool->mutex);
+    buf = pool->cache[cls];
+    if (buf) {
+        pool->cache[cls] = buf->next;
+        pool->stats.cached_bytes -= buf->size;
+        pool->stats.hits++;
+    } else {
+        if (pool->max_bytes) {
+            /* make room by dropping buffers cached for other sizes */
+            int64_t room = pool->max_bytes - (int64_t)class_size;
+            if (pool->stats.allocated_bytes > room)
+                shared_pool_trim(pool, pool->stats.cached_bytes -
+                                       (pool->stats.allocated_bytes - room));
+            if (pool->stats.allocated_bytes > room) {
+                pool->stats.failures++;
+                ff_mutex_unlock(&pool->mutex);
+                return NULL;
+            }
+        }
+        /* reserve the memory now, the allocation is done without the lock */
+        pool->stats.allocated_bytes += class_size;
+        pool->stats.peak_bytes = FFMAX(pool->stats.peak_bytes,
+                                       pool->stats.allocated_bytes);
+        pool->stats.misses++;
+    }
+    ff_mutex_unlock(&pool->mutex);
+
+    if (!buf) {
+        buf = av_mallocz(sizeof(*buf));
+        if (buf)
+            buf->data = CONFIG_MEMORY_POISONING ? av_malloc(class_size) :
+                                                  av_mallocz(class_size);
+        if (!buf || !buf->data) {
+            av_freep(&buf);
+            ff_mutex_lock(&pool->mutex);
+            pool->stats.allocated_bytes -= class_size;
+            ff_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        buf->size = class_size;
+        buf->cls  = cls;
+        buf->pool = pool;
+    }
+
+    atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
+
+    ret = av_buffer_create(buf->data, size, shared_pool_release_buffer, buf, 0);
+    if (!ret)
+        shared_pool_release_buffer(buf, buf->data);
+
+    return ret;
+}
+
+void av_buffer_shared_pool_flush(AVBufferRef *ref)
+{
+    SharedPool *pool = (SharedPool *)ref->data;
+
+    ff_mutex_lock(&pool->mutex);
+    shared_pool_trim(pool, 0);
+    ff_mutex_unlock(&pool->mutex);
+}
+
+void av_buffer_shared_pool_get_stats(AVBufferRef *ref, AVBufferPoolStats *stats)
+{
+    SharedPool *pool = (SharedPool *)ref->data;
+
+    ff_mutex_lock(&pool->mutex);
+    *stats = pool->stats;
+    ff_mutex_unlock(&pool->mutex);
+}
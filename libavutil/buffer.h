@@ -284,6 +284,95 @@ void av_buffer_pool_uninit(AVBufferPool **pool);
  */
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool);
 
+/**
+ * @}
+ */
+
+/**
+ * @defgroup lavu_buffersharedpool Shared buffer pool
+ * @ingroup lavu_buffer
+ *
+ * A shared buffer pool serves buffers of arbitrary size from a set of size
+ * classes, so that one pool can back the frame allocations of several
+ * decoders, filter graphs and encoders at the same time. Unlike AVBufferPool,
+ * a released buffer can be reused by any later request falling into the same
+ * size class, whichever component made it.
+ *
+ * Requested sizes are rounded up to the next size class; the classes are
+ * spaced so that at most a quarter of each buffer is wasted. The total amount
+ * of memory held by the pool, both in use and cached, can be capped. When a
+ * request would exceed the cap, cached buffers of other classes are freed
+ * first; if that is not enough the request fails.
+ *
+ * The pool is reference counted through an AVBufferRef, whose data points to
+ * an opaque structure. It can be shared by simply referencing it. The pool is
+ * freed once all references to it have been released and all the buffers
+ * allocated from it have been returned.
+ * @{
+ */
+
+/**
+ * Statistics of a shared buffer pool, as returned by
+ * av_buffer_shared_pool_get_stats().
+ */
+typedef struct AVBufferPoolStats {
+    /**
+     * Number of requests served by reusing a cached buffer.
+     */
+    uint64_t hits;
+    /**
+     * Number of requests that needed a new allocation.
+     */
+    uint64_t misses;
+    /**
+     * Number of requests that were refused because of the size cap.
+     */
+    uint64_t failures;
+    /**
+     * Number of bytes currently allocated by the pool, in use or cached.
+     */
+    int64_t allocated_bytes;
+    /**
+     * Number of bytes currently cached by the pool and not in use.
+     */
+    int64_t cached_bytes;
+    /**
+     * Highest value allocated_bytes has reached.
+     */
+    int64_t peak_bytes;
+} AVBufferPoolStats;
+
+/**
+ * Allocate a shared buffer pool.
+ *
+ * @param max_bytes maximum number of bytes the pool may hold at any time,
+ *                  including cached buffers; 0 means no limit
+ * @return a reference to the new pool on success, NULL on error
+ */
+AVBufferRef *av_buffer_shared_pool_alloc(int64_t max_bytes);
+
+/**
+ * Get a buffer of at least size bytes from a shared pool, reusing a cached
+ * buffer of the same size class when available. Newly allocated buffers are
+ * zeroed. This function may be called simultaneously from multiple threads.
+ *
+ * @param pool a reference to a pool allocated with
+ *             av_buffer_shared_pool_alloc()
+ * @return a reference to the new buffer on success, NULL on error or when
+ *         the size cap of the pool would be exceeded
+ */
+AVBufferRef *av_buffer_shared_pool_get(AVBufferRef *pool, int size);
+
+/**
+ * Free all the buffers currently cached by a shared pool.
+ */
+void av_buffer_shared_pool_flush(AVBufferRef *pool);
+
+/**
+ * Get the current statistics of a shared pool.
+ */
+void av_buffer_shared_pool_get_stats(AVBufferRef *pool, AVBufferPoolStats *stats);
+
 /**
  * @}
  */
@@ -95,4 +95,34 @@ struct AVBufferPool {
     void         (*pool_free)(void *opaque);
 };
 
+/*
+ * Shared pool size classes: everything up to 1 << SHARED_POOL_MIN_BITS goes
+ * into class 0, above that every power of two is split into 4 classes.
+ */
+#define SHARED_POOL_MIN_BITS   12
+#define SHARED_POOL_NB_CLASSES ((31 - SHARED_POOL_MIN_BITS) * 4 + 1)
+
+typedef struct SharedPoolEntry {
+    uint8_t *data;
+    size_t   size;  /* the size of the size class, not of the request */
+    int      cls;
+
+    struct SharedPool *pool;
+    struct SharedPoolEntry *next;
+} SharedPoolEntry;
+
+typedef struct SharedPool {
+    AVMutex mutex;
+    SharedPoolEntry *cache[SHARED_POOL_NB_CLASSES];
+
+    /*
+     * Like AVBufferPool.refcount, the AVBufferRef wrapping the pool counts as
+     * one reference and each buffer handed out as another one.
+     */
+    atomic_uint refcount;
+
+    int64_t max_bytes;
+    AVBufferPoolStats stats;
+} SharedPool;
+
 #endif /* AVUTIL_BUFFER_INTERNAL_H */
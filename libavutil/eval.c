@@ -45,6 +45,8 @@ typedef struct Parser {
     int stack_index;
     char *s;
     const double *const_values;
+    const double * const *const_arrays;       // per sample constant values, may be NULL
+    int index;                                // sample index into const_arrays
     const char * const *const_names;          // NULL terminated
     double (* const *funcs1)(void *, double a);           // NULL terminated
     const char * const *func1_names;          // NULL terminated
@@ -165,7 +167,7 @@ struct AVExpr {
         e_if, e_ifnot, e_print, e_bitand, e_bitor, e_between, e_clip, e_atan2, e_lerp,
     } type;
     double value; // is sign in other types
-    union {
+    union ExprArg {
         int const_index;
         double (*func0)(double);
         double (*func1)(void *, double);
@@ -173,8 +175,24 @@ struct AVExpr {
     } a;
     struct AVExpr *param[3];
     double *var;
+    struct ExprProgram *prog;   ///< compiled form, only set on the root node
 };
 
+/* operation of a compiled expression, see compile_expr() */
+typedef struct ExprOp {
+    int type;
+    int nb_src;
+    int src[3];         ///< source registers
+    double value;
+    union ExprArg a;
+} ExprOp;
+
+typedef struct ExprProgram {
+    ExprOp *ops;        ///< the result is in the register of the last operation
+    int nb_ops;
+    int has_funcs;      ///< the expression calls funcs1 or funcs2
+} ExprProgram;
+
 static double etime(double v)
 {
     return av_gettime() * 0.000001;
@@ -184,7 +202,9 @@ static double eval_expr(Parser *p, AVExpr *e)
 {
     switch (e->type) {
         case e_value:  return e->value;
-        case e_const:  return e->value * p->const_values[e->a.const_index];
+        case e_const:  return e->value * (p->const_arrays && p->const_arrays[e->a.const_index] ?
+                                          p->const_arrays[e->a.const_index][p->index] :
+                                          p->const_values[e->a.const_index]);
         case e_func0:  return e->value * e->a.func0(eval_expr(p, e->param[0]));
         case e_func1:  return e->value * e->a.func1(p->opaque, eval_expr(p, e->param[0]));
         case e_func2:  return e->value * e->a.func2(p->opaque, eval_expr(p, e->param[0]), eval_expr(p, e->param[1]));
@@ -337,6 +357,9 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[0]);
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
+    if (e->prog)
+        av_freep(&e->prog->ops);
+    av_freep(&e->prog);
     av_freep(&e->var);
     av_freep(&e);
 }
@@ -676,6 +699,358 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/*
+ * Compiled expressions.
+ *
+ * Expressions without side effects (no st(), ld(), while(), taylor(),
+ * root(), random() or print()) are lowered at parse time to a flat list of
+ * operations. Operation i stores its result in register i and only reads
+ * registers of lower index. Constant subexpressions are folded and
+ * identical operations are merged.
+ *
+ * Both branches of if() and ifnot() are evaluated, so that a whole array of
+ * samples can be processed one operation at a time with simple loops.
+ */
+
+#define MAX_OPS   256
+#define BATCH_BUF 2048  ///< size of the register file for batch evaluation, in doubles
+#define MAX_BATCH 64
+
+typedef struct ExprCompiler {
+    ExprOp ops[MAX_OPS];
+    int nb_ops;
+    int has_funcs;
+} ExprCompiler;
+
+/**
+ * Compute one operation, with the same semantics as eval_expr().
+ * s0, s1 and s2 point to the operands, e_const reads its value from s0.
+ */
+static av_always_inline double op_eval(const ExprOp *op, int type, double v,
+                                       const double *s0, const double *s1,
+                                       const double *s2, int i, void *opaque)
+{
+    switch (type) {
+    case e_value:  return v;
+    case e_const:  return v * s0[i];
+    case e_func0:  return v * op->a.func0(s0[i]);
+    case e_func1:  return v * op->a.func1(opaque, s0[i]);
+    case e_func2:  return v * op->a.func2(opaque, s0[i], s1[i]);
+    case e_squish: return 1/(1+exp(4*s0[i]));
+    case e_gauss:  return exp(-s0[i]*s0[i]/2)/sqrt(2*M_PI);
+    case e_isnan:  return v * !!isnan(s0[i]);
+    case e_isinf:  return v * !!isinf(s0[i]);
+    case e_floor:  return v * floor(s0[i]);
+    case e_ceil :  return v * ceil (s0[i]);
+    case e_trunc:  return v * trunc(s0[i]);
+    case e_round:  return v * round(s0[i]);
+    case e_sqrt:   return v * sqrt (s0[i]);
+    case e_not:    return v * (s0[i] == 0);
+    case e_last:   return v * s0[i];
+    case e_if:     return v * (s0[i] ? s1[i] : s2[i]);
+    case e_ifnot:  return v * (!s0[i] ? s1[i] : s2[i]);
+    case e_clip:
+        if (isnan(s1[i]) || isnan(s2[i]) || isnan(s0[i]) || s1[i] > s2[i])
+            return NAN;
+        return v * av_clipd(s0[i], s1[i], s2[i]);
+    case e_between: return v * (s0[i] >= s1[i] && s0[i] <= s2[i]);
+    case e_lerp:   return s0[i] + (s1[i] - s0[i]) * s2[i];
+    case e_mod:    return v * (s0[i] - floor((!CONFIG_FTRAPV || s1[i]) ? s0[i] / s1[i] : s0[i] * INFINITY) * s1[i]);
+    case e_gcd:    return v * av_gcd(s0[i], s1[i]);
+    case e_max:    return v * (s0[i] >  s1[i] ? s0[i] : s1[i]);
+    case e_min:    return v * (s0[i] <  s1[i] ? s0[i] : s1[i]);
+    case e_eq:     return v * (s0[i] == s1[i] ? 1.0 : 0.0);
+    case e_gt:     return v * (s0[i] >  s1[i] ? 1.0 : 0.0);
+    case e_gte:    return v * (s0[i] >= s1[i] ? 1.0 : 0.0);
+    case e_lt:     return v * (s0[i] <  s1[i] ? 1.0 : 0.0);
+    case e_lte:    return v * (s0[i] <= s1[i] ? 1.0 : 0.0);
+    case e_pow:    return v * pow(s0[i], s1[i]);
+    case e_mul:    return v * (s0[i] * s1[i]);
+    case e_div:    return v * ((!CONFIG_FTRAPV || s1[i]) ? (s0[i] / s1[i]) : s0[i] * INFINITY);
+    case e_add:    return v * (s0[i] + s1[i]);
+    case e_hypot:  return v * hypot(s0[i], s1[i]);
+    case e_atan2:  return v * atan2(s0[i], s1[i]);
+    case e_bitand: return isnan(s0[i]) || isnan(s1[i]) ? NAN : v * ((long int)s0[i] & (long int)s1[i]);
+    case e_bitor:  return isnan(s0[i]) || isnan(s1[i]) ? NAN : v * ((long int)s0[i] | (long int)s1[i]);
+    }
+    return NAN;
+}
+
+static int add_op(ExprCompiler *c, const ExprOp *op)
+{
+    int i;
+
+    for (i = 0; i < c->nb_ops; i++)
+        if (!memcmp(&c->ops[i], op, sizeof(*op)))
+            return i;
+    if (c->nb_ops == MAX_OPS)
+        return AVERROR(ENOSYS);
+    memcpy(&c->ops[c->nb_ops], op, sizeof(*op));
+    return c->nb_ops++;
+}
+
+static int add_value(ExprCompiler *c, double value)
+{
+    ExprOp op;
+
+    memset(&op, 0, sizeof(op));
+    op.type  = e_value;
+    op.value = value;
+    return add_op(c, &op);
+}
+
+/**
+ * Append the operations computing e.
+ * @return the register holding the result, or a negative value if the
+ *         expression cannot be compiled
+ */
+static int compile_expr(ExprCompiler *c, const AVExpr *e, int depth)
+{
+    ExprOp op;
+    int i, ret, nb_src, fold;
+
+    if (depth > MAX_OPS)
+        return AVERROR(ENOSYS);
+
+    switch (e->type) {
+    case e_value:
+        return add_value(c, e->value);
+    case e_const:
+        nb_src = 0;
+        break;
+    case e_func1:
+    case e_func2:
+        c->has_funcs = 1;
+        nb_src = e->type == e_func2 ? 2 : 1;
+        break;
+    case e_func0:
+    case e_squish:
+    case e_gauss:
+    case e_isnan:
+    case e_isinf:
+    case e_floor:
+    case e_ceil:
+    case e_trunc:
+    case e_round:
+    case e_sqrt:
+    case e_not:
+        nb_src = 1;
+        break;
+    case e_last:
+        /* the first operand is only compiled to reject side effects */
+        if ((ret = compile_expr(c, e->param[0], depth + 1)) < 0)
+            return ret;
+        if (e->value == 1)
+            return compile_expr(c, e->param[1], depth + 1);
+        nb_src = 1;
+        break;
+    case e_if:
+    case e_ifnot:
+    case e_between:
+    case e_clip:
+    case e_lerp:
+        nb_src = 3;
+        break;
+    case e_mod: case e_gcd: case e_max: case e_min:
+    case e_eq: case e_gt: case e_gte: case e_lt: case e_lte:
+    case e_pow: case e_mul: case e_div: case e_add:
+    case e_hypot: case e_atan2: case e_bitand: case e_bitor:
+        nb_src = 2;
+        break;
+    default:
+        return AVERROR(ENOSYS);
+    }
+
+    memset(&op, 0, sizeof(op));
+    op.type   = e->type;
+    op.nb_src = nb_src;
+    op.value  = e->value;
+    op.a      = e->a;
+
+    fold = e->type != e_const && e->type != e_func1 && e->type != e_func2 &&
+           !(e->type == e_func0 && e->a.func0 == etime);
+    for (i = 0; i < nb_src; i++) {
+        const AVExpr *param = e->type == e_last ? e->param[1] : e->param[i];
+
+        ret = param ? compile_expr(c, param, depth + 1) : add_value(c, 0);
+        if (ret < 0)
+            return ret;
+        op.src[i] = ret;
+        fold &= c->ops[ret].type == e_value;
+    }
+
+    if (fold) {
+        double value = op_eval(&op, op.type, op.value,
+                               &c->ops[op.src[0]].value,
+                               &c->ops[op.src[1]].value,
+                               &c->ops[op.src[2]].value, 0, NULL);
+        return add_value(c, value);
+    }
+    return add_op(c, &op);
+}
+
+static int compile_program(AVExpr *e)
+{
+    ExprCompiler *c = av_malloc(sizeof(*c));
+    ExprProgram *prog = NULL;
+    int map[MAX_OPS], live[MAX_OPS] = { 0 };
+    int i, j, n, root, ret = 0;
+
+    if (!c)
+        return AVERROR(ENOMEM);
+    c->nb_ops    = 0;
+    c->has_funcs = 0;
+
+    root = compile_expr(c, e, 0);
+    if (root < 0)
+        goto end;
+
+    /* drop the operations the result does not depend on */
+    live[root] = 1;
+    for (i = root; i >= 0; i--)
+        if (live[i])
+            for (j = 0; j < c->ops[i].nb_src; j++)
+                live[c->ops[i].src[j]] = 1;
+    for (i = n = 0; i <= root; i++) {
+        if (!live[i])
+            continue;
+        c->ops[n] = c->ops[i];
+        for (j = 0; j < c->ops[n].nb_src; j++)
+            c->ops[n].src[j] = map[c->ops[n].src[j]];
+        map[i] = n++;
+    }
+
+    prog = av_mallocz(sizeof(*prog));
+    if (!prog || !(prog->ops = av_malloc_array(n, sizeof(*prog->ops)))) {
+        av_freep(&prog);
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    memcpy(prog->ops, c->ops, n * sizeof(*prog->ops));
+    prog->nb_ops    = n;
+    prog->has_funcs = c->has_funcs;
+    e->prog = prog;
+end:
+    av_free(c);
+    return ret;
+}
+
+static double eval_program(const ExprProgram *prog, const double *const_values, void *opaque)
+{
+    double r[MAX_OPS];
+    int i;
+
+    for (i = 0; i < prog->nb_ops; i++) {
+        const ExprOp *op = &prog->ops[i];
+        const double *s0 = op->type == e_const ? &const_values[op->a.const_index] : &r[op->src[0]];
+
+        r[i] = op_eval(op, op->type, op->value, s0, &r[op->src[1]], &r[op->src[2]], 0, opaque);
+    }
+    return r[prog->nb_ops - 1];
+}
+
+#define BATCH_OP(type)                                                      \
+    case type:                                                              \
+        for (i = 0; i < n; i++)                                             \
+            dst[i] = op_eval(op, type, v, s0, s1, s2, i, opaque);           \
+        break
+
+static void eval_op_batch(const ExprOp *op, double *av_restrict dst,
+                          const double *s0, const double *s1, const double *s2,
+                          int n, void *opaque)
+{
+    const double v = op->value;
+    int i;
+
+    switch (op->type) {
+    BATCH_OP(e_const);
+    BATCH_OP(e_func0);
+    BATCH_OP(e_func1);
+    BATCH_OP(e_func2);
+    BATCH_OP(e_squish);
+    BATCH_OP(e_gauss);
+    BATCH_OP(e_isnan);
+    BATCH_OP(e_isinf);
+    BATCH_OP(e_floor);
+    BATCH_OP(e_ceil);
+    BATCH_OP(e_trunc);
+    BATCH_OP(e_round);
+    BATCH_OP(e_sqrt);
+    BATCH_OP(e_not);
+    BATCH_OP(e_last);
+    BATCH_OP(e_if);
+    BATCH_OP(e_ifnot);
+    BATCH_OP(e_clip);
+    BATCH_OP(e_between);
+    BATCH_OP(e_lerp);
+    BATCH_OP(e_mod);
+    BATCH_OP(e_gcd);
+    BATCH_OP(e_max);
+    BATCH_OP(e_min);
+    BATCH_OP(e_eq);
+    BATCH_OP(e_gt);
+    BATCH_OP(e_gte);
+    BATCH_OP(e_lt);
+    BATCH_OP(e_lte);
+    BATCH_OP(e_pow);
+    BATCH_OP(e_mul);
+    BATCH_OP(e_div);
+    BATCH_OP(e_add);
+    BATCH_OP(e_hypot);
+    BATCH_OP(e_atan2);
+    BATCH_OP(e_bitand);
+    BATCH_OP(e_bitor);
+    }
+}
+
+static void eval_program_array(const ExprProgram *prog, double *res, int nb,
+                               const double *const_values,
+                               const double * const *const_arrays, void *opaque)
+{
+    double r[BATCH_BUF];
+    uint8_t uniform[MAX_OPS];
+    const int batch = FFMIN(BATCH_BUF / prog->nb_ops, MAX_BATCH);
+    int i, j, k, n;
+
+    /* operations which do not depend on const_arrays are computed only once */
+    for (i = 0; i < prog->nb_ops; i++) {
+        const ExprOp *op = &prog->ops[i];
+        const double *s0 = &r[op->src[0] * batch];
+        double value;
+
+        if (op->type == e_const) {
+            uniform[i] = !const_arrays || !const_arrays[op->a.const_index];
+            s0 = &const_values[op->a.const_index];
+        } else {
+            uniform[i] = 1;
+            for (j = 0; j < op->nb_src; j++)
+                uniform[i] &= uniform[op->src[j]];
+        }
+        if (!uniform[i])
+            continue;
+        value = op_eval(op, op->type, op->value, s0, &r[op->src[1] * batch],
+                        &r[op->src[2] * batch], 0, opaque);
+        for (j = 0; j < batch; j++)
+            r[i * batch + j] = value;
+    }
+
+    for (k = 0; k < nb; k += batch) {
+        n = FFMIN(batch, nb - k);
+        for (i = 0; i < prog->nb_ops; i++) {
+            const ExprOp *op = &prog->ops[i];
+            const double *s0 = &r[op->src[0] * batch];
+
+            if (uniform[i])
+                continue;
+            if (op->type == e_const)
+                s0 = const_arrays[op->a.const_index] + k;
+            eval_op_batch(op, &r[i * batch], s0, &r[op->src[1] * batch],
+                          &r[op->src[2] * batch], n, opaque);
+        }
+        memcpy(res + k, &r[(prog->nb_ops - 1) * batch], n * sizeof(*res));
+    }
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -723,6 +1098,8 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(ENOMEM);
         goto end;
     }
+    if ((ret = compile_program(e)) < 0)
+        goto end;
     *expr = e;
     e = NULL;
 end:
@@ -734,6 +1111,11 @@ end:
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
 {
     Parser p = { 0 };
+
+    /* keep calling the user functions only for the branches actually taken */
+    if (e->prog && !e->prog->has_funcs)
+        return eval_program(e->prog, const_values, opaque);
+
     p.var= e->var;
 
     p.const_values = const_values;
@@ -741,6 +1123,25 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+void av_expr_eval_array(AVExpr *e, double *res, int nb,
+                        const double *const_values,
+                        const double * const *const_arrays, void *opaque)
+{
+    Parser p = { 0 };
+
+    if (e->prog) {
+        eval_program_array(e->prog, res, nb, const_values, const_arrays, opaque);
+        return;
+    }
+
+    p.var          = e->var;
+    p.const_values = const_values;
+    p.const_arrays = const_arrays;
+    p.opaque       = opaque;
+    for (p.index = 0; p.index < nb; p.index++)
+        res[p.index] = eval_expr(&p, e);
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -86,6 +86,28 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for an array of samples.
+ *
+ * This is equivalent to calling av_expr_eval() nb times, except that for
+ * the k-th evaluation the i-th constant takes the value const_arrays[i][k]
+ * if const_arrays and const_arrays[i] are not NULL. Expressions which do not
+ * use st(), ld(), while(), taylor(), root(), random() or print() are
+ * evaluated for many samples at once; the functions from funcs1 and funcs2
+ * must then not have side effects, as they may also be called for samples
+ * in the branch of an if() which is not taken.
+ *
+ * @param res array receiving the nb results
+ * @param nb number of samples to evaluate
+ * @param const_values a zero terminated array of values for the identifiers from av_expr_parse() const_names
+ * @param const_arrays NULL, or an array of per sample values for each of the constants,
+ *                     with NULL entries for the constants taken from const_values
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ */
+void av_expr_eval_array(AVExpr *e, double *res, int nb,
+                        const double *const_values,
+                        const double * const *const_arrays, void *opaque);
+
 /**
  * Free a parsed expression previously created with av_expr_parse().
  */
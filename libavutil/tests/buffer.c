@@ -0,0 +1,101 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+
+static void print_stats(const char *step, AVBufferRef *pool)
+{
+    AVBufferPoolStats st;
+
+    av_buffer_shared_pool_get_stats(pool, &st);
+    printf("%-24s hits %2"PRIu64" misses %2"PRIu64" failures %"PRIu64
+           " allocated %8"PRId64" cached %8"PRId64" peak %8"PRId64"\n",
+           step, st.hits, st.misses, st.failures,
+           st.allocated_bytes, st.cached_bytes, st.peak_bytes);
+}
+
+int main(void)
+{
+    static const int sizes[] = { 1, 4096, 4097, 5120, 5121, 8192, 100000, 1 << 20 };
+    AVBufferRef *pool, *bufs[FF_ARRAY_ELEMS(sizes)], *buf;
+    int i;
+
+    pool = av_buffer_shared_pool_alloc(0);
+    if (!pool)
+        return 1;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        AVBufferPoolStats before, after;
+
+        av_buffer_shared_pool_get_stats(pool, &before);
+        bufs[i] = av_buffer_shared_pool_get(pool, sizes[i]);
+        if (!bufs[i] || bufs[i]->size != sizes[i])
+            return 1;
+        av_buffer_shared_pool_get_stats(pool, &after);
+        printf("size %7d -> size class %7"PRId64"\n", sizes[i],
+               after.allocated_bytes - before.allocated_bytes);
+    }
+    print_stats("allocated", pool);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++)
+        av_buffer_unref(&bufs[i]);
+    print_stats("released", pool);
+
+    /* any size within a class reuses the cached buffers */
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        bufs[i] = av_buffer_shared_pool_get(pool, sizes[FF_ARRAY_ELEMS(sizes) - 1 - i]);
+        if (!bufs[i])
+            return 1;
+    }
+    print_stats("reallocated", pool);
+
+    /* buffers outlive the last reference to the pool */
+    av_buffer_unref(&pool);
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++)
+        av_buffer_unref(&bufs[i]);
+
+    /* cap: cached buffers of other classes are dropped to make room */
+    pool = av_buffer_shared_pool_alloc(1 << 20);
+    if (!pool)
+        return 1;
+    for (i = 0; i < 4; i++) {
+        bufs[i] = av_buffer_shared_pool_get(pool, 200000);
+        if (!bufs[i])
+            return 1;
+    }
+    print_stats("capped", pool);
+    buf = av_buffer_shared_pool_get(pool, 300000);
+    printf("over the cap: %s\n", buf ? "allocated" : "refused");
+    print_stats("refused", pool);
+    for (i = 0; i < 4; i++)
+        av_buffer_unref(&bufs[i]);
+    buf = av_buffer_shared_pool_get(pool, 900000);
+    printf("after release: %s\n", buf ? "allocated" : "refused");
+    print_stats("trimmed", pool);
+    av_buffer_unref(&buf);
+
+    av_buffer_shared_pool_flush(pool);
+    print_stats("flushed", pool);
+    av_buffer_unref(&pool);
+
+    return 0;
+}
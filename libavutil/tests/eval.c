@@ -37,6 +37,67 @@ static const char *const const_names[] = {
     0
 };
 
+static const char *const array_const_names[] = {
+    "X",
+    "Y",
+    0
+};
+
+static double half(void *opaque, double x)
+{
+    return x / 2;
+}
+
+static double (* const funcs1[])(void *, double) = { half, NULL };
+static const char *const func1_names[] = { "half", NULL };
+
+/* check av_expr_eval_array() against av_expr_eval(), and against the tree
+ * walk: av_expr_eval() only uses the compiled program for expressions that
+ * do not call user functions, so wrapping the expression in half() forces
+ * the tree walk while keeping the result exact */
+static void test_eval_array(const char *s)
+{
+    AVExpr *e = NULL, *tree = NULL;
+    char buf[256];
+    double xs[100], res[100], values[2] = { 0, 3.5 };
+    const double *arrays[2] = { xs, NULL };
+    int i, j, ret;
+
+    snprintf(buf, sizeof(buf), "half(2*(%s))", s);
+    ret = av_expr_parse(&e, s, array_const_names, func1_names, funcs1,
+                        NULL, NULL, 0, NULL);
+    if (ret >= 0)
+        ret = av_expr_parse(&tree, buf, array_const_names, func1_names, funcs1,
+                            NULL, NULL, 0, NULL);
+    if (ret < 0) {
+        printf("av_expr_parse failed\n");
+        av_expr_free(e);
+        return;
+    }
+    for (i = 0; i < FF_ARRAY_ELEMS(xs); i++)
+        xs[i] = i - 50;
+    av_expr_eval_array(e, res, FF_ARRAY_ELEMS(res), values, arrays, NULL);
+    for (i = 0; i < FF_ARRAY_ELEMS(xs); i++) {
+        double d;
+        values[0] = xs[i];
+        d = av_expr_eval(e, values, NULL);
+        if (memcmp(&d, &res[i], sizeof(d)))
+            break;
+    }
+    for (j = 0; j < FF_ARRAY_ELEMS(xs); j++) {
+        double d;
+        values[0] = xs[j];
+        d = av_expr_eval(tree, values, NULL);
+        if (memcmp(&d, &res[j], sizeof(d)))
+            break;
+    }
+    printf("'%s' array -> %s, tree walk -> %s\n", s,
+           i == FF_ARRAY_ELEMS(xs) ? "ok" : "mismatch",
+           j == FF_ARRAY_ELEMS(xs) ? "ok" : "mismatch");
+    av_expr_free(e);
+    av_expr_free(tree);
+}
+
 int main(int argc, char **argv)
 {
     int i;
@@ -140,6 +201,19 @@ int main(int argc, char **argv)
         "clip(0, 0/0, 1)",
         NULL
     };
+    static const char *const array_exprs[] = {
+        "X*Y+1",
+        "2*3+X-2*3",
+        "if(gt(X,0), sqrt(X), -X/Y)",
+        "ifnot(mod(X,3), 1) + clip(X, -Y*2, 2*Y)",
+        "between(X, -Y, Y)*hypot(X, Y) - 1/X",
+        "lerp(X, Y, 0.25) + atan2(X, Y) + bitand(X, 7) + bitor(X, 1)",
+        "half(X)*half(X) + max(X, Y) + min(X, -Y) + abs(X) + round(X/7)",
+        "-(X+1);-(X+1)*(X+1)",
+        "squish(X/10) + gauss(X/10) - isnan(X) + isinf(1/X) + not(X) + eq(X, 1)",
+        "st(0, X); ld(0) + random(1) * 0",
+        NULL
+    };
     int ret;
 
     for (expr = exprs; *expr; expr++) {
@@ -155,6 +229,9 @@ int main(int argc, char **argv)
             printf("av_expr_parse_and_eval failed\n");
     }
 
+    for (expr = array_exprs; *expr; expr++)
+        test_eval_array(*expr);
+
     ret = av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
                            const_names, const_values,
                            NULL, NULL, NULL, NULL, NULL, 0, NULL);
@@ -280,13 +280,37 @@ static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(&c->filter_bank);
     av_freep(cc);
 }
 
+static void resample_channel(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ResampleContext *c = priv;
+    void *dst = c->job.dst->ch[jobnr];
+    const void *src = c->job.src->ch[jobnr];
+
+    if (jobnr + 1 == nb_jobs) {
+        /* the other jobs still read the context, so the state of the last
+         * channel is updated in a copy */
+        ResampleContext tmp = *c;
+
+        c->job.consumed = c->job.resample(&tmp, dst, src, c->job.n, 1);
+        c->job.index    = tmp.index;
+        c->job.frac     = tmp.frac;
+    } else {
+        c->job.resample(c, dst, src, c->job.n, 0);
+    }
+
+    if (c->job.need_emms)
+        emms_c();
+}
+
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational,
+                                    int nb_threads, void *log_ctx)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -316,6 +340,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
             return NULL;
 
         c->format= format;
+        c->nb_threads = 1;
 
         c->felem_size= av_get_bytes_per_sample(c->format);
 
@@ -353,7 +378,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
             goto error;
         if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
             goto error;
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
+        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_length-1)*c->felem_size);
         memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
     }
 
@@ -373,8 +398,24 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     swri_resample_dsp_init(c);
 
+    if (c->nb_threads != nb_threads) {
+        avpriv_slicethread_free(&c->slicethread);
+        c->nb_threads = nb_threads;
+        if (nb_threads != 1) {
+            int ret = avpriv_slicethread_create(&c->slicethread, c, resample_channel,
+                                                NULL, nb_threads);
+            if (ret == AVERROR(ENOSYS))
+                av_log(log_ctx, AV_LOG_WARNING, "Threads are not supported, resampling single threaded\n");
+            else if (ret < 0)
+                goto error;
+            if (ret <= 1)
+                avpriv_slicethread_free(&c->slicethread);
+        }
+    }
+
     return c;
 error:
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(&c->filter_bank);
     av_free(c);
     return NULL;
@@ -402,7 +443,7 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
         av_freep(&new_filter_bank);
         return ret;
     }
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, new_filter_bank, (c->filter_alloc-1)*c->felem_size);
+    memcpy(new_filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, new_filter_bank, (c->filter_length-1)*c->felem_size);
     memcpy(new_filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, new_filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
 
     if (!av_reduce(&new_src_incr, &new_dst_incr, c->src_incr,
@@ -494,8 +535,20 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            if (c->slicethread && dst->ch_count > 1) {
+                c->job.dst       = dst;
+                c->job.src       = src;
+                c->job.n         = dst_size;
+                c->job.need_emms = need_emms;
+                c->job.resample  = resample_func;
+                avpriv_slicethread_execute(c->slicethread, dst->ch_count, 0);
+                *consumed = c->job.consumed;
+                c->index  = c->job.index;
+                c->frac   = c->job.frac;
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            }
         }
     }
 
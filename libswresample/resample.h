@@ -24,6 +24,7 @@
 
 #include "libavutil/log.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 
 #include "swresample_internal.h"
 
@@ -58,6 +59,20 @@ typedef struct ResampleContext {
         int (*resample_linear)(struct ResampleContext *c, void *dst,
                                const void *src, int n, int update_ctx);
     } dsp;
+
+    AVSliceThread *slicethread;        ///< resamples the channels in parallel, NULL if single threaded
+    int nb_threads;                    ///< number of threads requested by the user
+    struct {
+        AudioData *dst;
+        AudioData *src;
+        int n;
+        int need_emms;
+        int consumed;
+        int index;
+        int frac;
+        int (*resample)(struct ResampleContext *c, void *dst,
+                        const void *src, int n, int update_ctx);
+    } job;                             ///< arguments of the current channel jobs
 } ResampleContext;
 
 void swri_resample_dsp_init(ResampleContext *c);
@@ -51,15 +51,33 @@ SECTION_RODATA
 pf_1:      dd 1.0
 pdbl_1:    dq 1.0
 pd_0x4000: dd 0x4000
+pq_0x20000000: dq 0x20000000
 
 SECTION .text
 
+; clip the 64 bit value in %1 (%2 is its low dword) to int32, using %3 as temporary
+%macro CLIPL_INT32 3
+    movsxd                        %3, %2
+    cmp                           %3, %1
+    je %%end
+    sar                           %1, 63
+    xor                           %2, 0x7fffffff
+%%end:
+%endmacro
+
 ; FIXME remove unneeded variables (index_incr, phase_mask)
-%macro RESAMPLE_FNS 3-5 ; format [float or int16], bps, log2_bps, float op suffix [s or d], 1.0 constant
+%macro RESAMPLE_FNS 3-5 ; format [float, int16 or int32], bps, log2_bps, float op suffix [s or d], 1.0 constant
+; int16 with ymm registers reads the filter in blocks of 16 taps followed by
+; a final block of 8 if needed, as filter_alloc is only aligned to 8
+%assign %%int16_ymm 0
+%ifidn %1, int16
+%assign %%int16_ymm mmsize == 32
+%endif
+
 ; int resample_common_$format(ResampleContext *ctx, $format *dst,
 ;                             const $format *src, int size, int update_ctx)
 %if ARCH_X86_64 ; unix64 and win64
-cglobal resample_common_%1, 0, 15, 2, ctx, dst, src, phase_count, index, frac, \
+cglobal resample_common_%1, 0, 15, 4, ctx, dst, src, phase_count, index, frac, \
                                       dst_incr_mod, size, min_filter_count_x4, \
                                       min_filter_len_x4, dst_incr_div, src_incr, \
                                       phase_mask, dst_end, filter_bank
@@ -88,6 +106,10 @@ cglobal resample_common_%1, 0, 15, 2, ctx, dst, src, phase_count, index, frac, \
     mov           min_filter_len_x4d, [ctxq+ResampleContext.filter_length]
     mov                dst_incr_divd, [ctxq+ResampleContext.dst_incr_div]
     shl           min_filter_len_x4d, %3
+%if %%int16_ymm
+    add           min_filter_len_x4d, 15
+    and           min_filter_len_x4d, ~15
+%endif
     lea                     dst_endq, [dstq+sizeq*%2]
 
 %if UNIX64
@@ -166,11 +188,31 @@ cglobal resample_common_%1, 1, 7, 2, ctx, phase_count, dst, frac, \
     mov         min_filter_count_x4q, min_filter_length_x4q
 %endif
 %ifidn %1, int16
-    movd                          m0, [pd_0x4000]
+    movd                         xm0, [pd_0x4000]
+%elifidn %1, int32
+    movq                         xm0, [pq_0x20000000]
 %else ; float/double
     xorps                         m0, m0, m0
 %endif
 
+%if %%int16_ymm
+    add         min_filter_count_x4q, mmsize
+    jg .inner_tail
+    align 16
+.inner_loop:
+    movu                          m1, [srcq+min_filter_count_x4q-mmsize]
+    pmaddwd                       m1, [filterq+min_filter_count_x4q-mmsize]
+    paddd                         m0, m1
+    add         min_filter_count_x4q, mmsize
+    jle .inner_loop
+.inner_tail:
+    cmp         min_filter_count_x4q, mmsize
+    je .inner_done
+    movu                         xm1, [srcq-16]
+    pmaddwd                      xm1, [filterq-16]
+    paddd                         m0, m1
+.inner_done:
+%else
     align 16
 .inner_loop:
     movu                          m1, [srcq+min_filter_count_x4q*1]
@@ -181,6 +223,14 @@ cglobal resample_common_%1, 1, 7, 2, ctx, phase_count, dst, frac, \
     pmaddwd                       m1, [filterq+min_filter_count_x4q*1]
     paddd                         m0, m1
 %endif
+%elifidn %1, int32
+    ; 64 bit products of the even and odd taps
+    psrlq                         m2, m1, 32
+    pshufd                        m3, [filterq+min_filter_count_x4q*1], q3311
+    pmuldq                        m1, [filterq+min_filter_count_x4q*1]
+    pmuldq                        m2, m3
+    paddq                         m0, m1
+    paddq                         m0, m2
 %else ; float/double
 %if cpuflag(fma4) || cpuflag(fma3)
     fmaddp%4                      m0, m1, [filterq+min_filter_count_x4q*1], m0
@@ -191,14 +241,28 @@ cglobal resample_common_%1, 1, 7, 2, ctx, phase_count, dst, frac, \
 %endif
     add         min_filter_count_x4q, mmsize
     js .inner_loop
+%endif
 
 %ifidn %1, int16
     HADDD                         m0, m1
-    psrad                         m0, 15
+    psrad                        xm0, 15
+    add                        fracd, dst_incr_modd
+    packssdw                     xm0, xm0
+    add                       indexd, dst_incr_divd
+    movd                      [dstq], xm0
+%elifidn %1, int32
+%if mmsize == 32
+    vextracti128                 xm1, m0, 1
+    paddq                        xm0, xm1
+%endif
+    punpckhqdq                   xm1, xm0, xm0
+    paddq                        xm0, xm1
+    movq        min_filter_count_x4q, xm0
+    sar         min_filter_count_x4q, 30
+    CLIPL_INT32 min_filter_count_x4q, min_filter_count_x4d, filterq
     add                        fracd, dst_incr_modd
-    packssdw                      m0, m0
     add                       indexd, dst_incr_divd
-    movd                      [dstq], m0
+    mov                       [dstq], min_filter_count_x4d
 %else ; float/double
     ; horizontal sum & store
 %if mmsize == 32
@@ -312,7 +376,9 @@ cglobal resample_linear_%1, 0, 15, 5, ctx, phase_mask, src, phase_count, index,
     mov                   ctx_stackq, ctxq
     mov           min_filter_len_x4d, [ctxq+ResampleContext.filter_length]
 %ifidn %1, int16
-    movd                          m4, [pd_0x4000]
+    movd                         xm4, [pd_0x4000]
+%elifidn %1, int32
+    movq                         xm4, [pq_0x20000000]
 %else ; float/double
     cvtsi2s%4                    xm0, src_incrd
     movs%4                       xm4, [%5]
@@ -320,6 +386,10 @@ cglobal resample_linear_%1, 0, 15, 5, ctx, phase_mask, src, phase_count, index,
 %endif
     mov                dst_incr_divd, [ctxq+ResampleContext.dst_incr_div]
     shl           min_filter_len_x4d, %3
+%if %%int16_ymm
+    add           min_filter_len_x4d, 15
+    and           min_filter_len_x4d, ~15
+%endif
     lea                     dst_endq, [dstq+sizeq*%2]
 
 %if UNIX64
@@ -413,14 +483,39 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
     mov                     filter2q, filter1q
     add                     filter2q, filter_alloc_x4q
 %endif
-%ifidn %1, int16
-    mova                          m0, m4
-    mova                          m2, m4
-%else ; float/double
+%ifidn %1, float
+    xorps                         m0, m0, m0
+    xorps                         m2, m2, m2
+%elifidn %1, double
     xorps                         m0, m0, m0
     xorps                         m2, m2, m2
+%else ; int16/int32
+    mova                          m0, m4
+    mova                          m2, m4
 %endif
 
+%if %%int16_ymm
+    add         min_filter_count_x4q, mmsize
+    jg .inner_tail
+    align 16
+.inner_loop:
+    movu                          m1, [srcq+min_filter_count_x4q-mmsize]
+    pmaddwd                       m3, m1, [filter2q+min_filter_count_x4q-mmsize]
+    pmaddwd                       m1, [filter1q+min_filter_count_x4q-mmsize]
+    paddd                         m2, m3
+    paddd                         m0, m1
+    add         min_filter_count_x4q, mmsize
+    jle .inner_loop
+.inner_tail:
+    cmp         min_filter_count_x4q, mmsize
+    je .inner_done
+    movu                         xm1, [srcq-16]
+    pmaddwd                      xm3, xm1, [filter2q-16]
+    pmaddwd                      xm1, [filter1q-16]
+    paddd                         m2, m3
+    paddd                         m0, m1
+.inner_done:
+%else
     align 16
 .inner_loop:
     movu                          m1, [srcq+min_filter_count_x4q*1]
@@ -434,6 +529,18 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
     paddd                         m2, m3
     paddd                         m0, m1
 %endif ; cpuflag
+%elifidn %1, int32
+    pmuldq                        m3, m1, [filter2q+min_filter_count_x4q*1]
+    paddq                         m2, m3
+    pmuldq                        m3, m1, [filter1q+min_filter_count_x4q*1]
+    paddq                         m0, m3
+    psrlq                         m1, 32
+    pshufd                        m3, [filter2q+min_filter_count_x4q*1], q3311
+    pmuldq                        m3, m1
+    paddq                         m2, m3
+    pshufd                        m3, [filter1q+min_filter_count_x4q*1], q3311
+    pmuldq                        m3, m1
+    paddq                         m0, m3
 %else ; float/double
 %if cpuflag(fma4) || cpuflag(fma3)
     fmaddp%4                      m2, m1, [filter2q+min_filter_count_x4q*1], m2
@@ -447,38 +554,71 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
 %endif
     add         min_filter_count_x4q, mmsize
     js .inner_loop
+%endif
 
 %ifidn %1, int16
-%if mmsize == 16
+%if mmsize == 32
+    vextracti128                 xm3, m2, 1
+    vextracti128                 xm1, m0, 1
+    paddd                        xm2, xm3
+    paddd                        xm0, xm1
+%endif
+%if mmsize >= 16
 %if cpuflag(xop)
-    vphadddq                      m2, m2
-    vphadddq                      m0, m0
+    vphadddq                     xm2, xm2
+    vphadddq                     xm0, xm0
 %endif
-    pshufd                        m3, m2, q0032
-    pshufd                        m1, m0, q0032
-    paddd                         m2, m3
-    paddd                         m0, m1
+    pshufd                       xm3, xm2, q0032
+    pshufd                       xm1, xm0, q0032
+    paddd                        xm2, xm3
+    paddd                        xm0, xm1
 %endif
 %if notcpuflag(xop)
-    PSHUFLW                       m3, m2, q0032
-    PSHUFLW                       m1, m0, q0032
-    paddd                         m2, m3
-    paddd                         m0, m1
+    PSHUFLW                      xm3, xm2, q0032
+    PSHUFLW                      xm1, xm0, q0032
+    paddd                        xm2, xm3
+    paddd                        xm0, xm1
 %endif
-    psubd                         m2, m0
+    psubd                        xm2, xm0
     ; This is probably a really bad idea on atom and other machines with a
     ; long transfer latency between GPRs and XMMs (atom). However, it does
     ; make the clip a lot simpler...
-    movd                         eax, m2
+    movd                         eax, xm2
     add                       indexd, dst_incr_divd
     imul                              fracd
     idiv                              src_incrd
-    movd                          m1, eax
+    movd                         xm1, eax
     add                        fracd, dst_incr_modd
-    paddd                         m0, m1
-    psrad                         m0, 15
-    packssdw                      m0, m0
-    movd                      [dstq], m0
+    paddd                        xm0, xm1
+    psrad                        xm0, 15
+    packssdw                     xm0, xm0
+    movd                      [dstq], xm0
+%elifidn %1, int32
+%if mmsize == 32
+    vextracti128                 xm3, m2, 1
+    vextracti128                 xm1, m0, 1
+    paddq                        xm2, xm3
+    paddq                        xm0, xm1
+%endif
+    punpckhqdq                   xm3, xm2, xm2
+    punpckhqdq                   xm1, xm0, xm0
+    paddq                        xm2, xm3
+    paddq                        xm0, xm1
+    psubq                        xm2, xm0
+    ; val += (v2 - val) / src_incr * frac, in 64 bits; frac and src_incr
+    ; are positive, so their upper halves are zero
+    movq                         rax, xm2
+    add                       indexd, dst_incr_divd
+    cqo
+    idiv                              src_incrq
+    imul                         rax, fracq
+    movq                         xm1, rax
+    add                        fracd, dst_incr_modd
+    paddq                        xm0, xm1
+    movq                         rax, xm0
+    sar                          rax, 30
+    CLIPL_INT32                  rax, eax, rdx
+    mov                       [dstq], eax
 
     ; note that for imul/idiv, I need to move filter to edx/eax for each:
     ; - 32bit: eax=r0[filter1], edx=r2[filter2]
@@ -605,6 +745,13 @@ RESAMPLE_FNS int16, 2, 1
 INIT_XMM xop
 RESAMPLE_FNS int16, 2, 1
 %endif
+; the int32 versions need 64 bit arithmetic, and the int16 one only rounds
+; the filter length up to whole blocks of 8 taps on x86-64
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+RESAMPLE_FNS int16, 2, 1
+RESAMPLE_FNS int32, 4, 2
+%endif
 
 INIT_XMM sse2
 RESAMPLE_FNS double, 8, 3, d, pdbl_1
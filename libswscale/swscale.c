@@ -256,7 +256,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     const int chrSrcSliceH           = AV_CEIL_RSHIFT(srcSliceH,   c->chrSrcVSubSample);
     int should_dither                = isNBPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
-    int lastDstY;
+    int lastDstY, dstSliceH, dstEnd;
 
     /* vars which will change and which we need to store back in the context */
     int dstY         = c->dstY;
@@ -341,6 +341,13 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
+    dstSliceH = dstEnd = dstH;
+    /* threaded scaling: the whole source is available, output one band */
+    if (c->dstSliceH) {
+        dstY      = c->dstSliceY;
+        dstSliceH = c->dstSliceH;
+        dstEnd    = dstY + dstSliceH;
+    }
 
     if (!should_dither) {
         c->chrDither8 = c->lumDither8 = sws_pb_64;
@@ -354,8 +361,8 @@ static int swscale(SwsContext *c, const uint8_t *src[],
             srcSliceY, srcSliceH, chrSrcSliceY, chrSrcSliceH, 1);
 
     ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
-            dstY, dstH, dstY >> c->chrDstVSubSample,
-            AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
+            dstY, dstSliceH, dstY >> c->chrDstVSubSample,
+            AV_CEIL_RSHIFT(dstSliceH, c->chrDstVSubSample), 0);
     if (srcSliceY == 0) {
         hout_slice->plane[0].sliceY = lastInLumBuf + 1;
         hout_slice->plane[1].sliceY = lastInChrBuf + 1;
@@ -369,7 +376,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -746,6 +753,85 @@ static void rgb48Toxyz12(struct SwsContext *c, uint16_t *dst,
     }
 }
 
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext      *c = parent->slice_ctx[threadnr];
+    const int unscaled = c->swscale != swscale;
+    int align = 1 << c->chrDstVSubSample;
+    int slice_h, y, h, i, ret = 0;
+
+    /* unscaled converters get a source slice, which must not split chroma
+     * lines either; some index their 8x8 dither tables relative to it */
+    if (unscaled)
+        align = FFMAX3(align, 1 << c->chrSrcVSubSample, 8);
+
+    slice_h = FFALIGN((c->dstH + nb_jobs - 1) / nb_jobs, align);
+    y       = jobnr * slice_h;
+    h       = FFMIN(slice_h, c->dstH - y);
+
+    if (h > 0 && unscaled) {
+        const uint8_t *src[4];
+
+        for (i = 0; i < 4; i++) {
+            int shift = (i == 1 || i == 2) ? c->chrSrcVSubSample : 0;
+
+            src[i] = parent->slice_src[i];
+            if (src[i] && !(i == 1 && usePal(c->srcFormat)))
+                src[i] += (y >> shift) * parent->slice_src_stride[i];
+        }
+
+        c->sliceDir = 1;
+        ret = sws_scale(c, src, parent->slice_src_stride, y, h,
+                        parent->slice_dst, parent->slice_dst_stride);
+    } else if (h > 0) {
+        c->dstSliceY = y;
+        c->dstSliceH = h;
+        ret = sws_scale(c, parent->slice_src, parent->slice_src_stride, 0, c->srcH,
+                        parent->slice_dst, parent->slice_dst_stride);
+        c->dstSliceH = 0;
+    }
+
+    parent->slice_err[jobnr] = ret;
+}
+
+/*
+ * The SIMD output functions write whole blocks of up to 32 pixels, past the
+ * end of the rows. Unless the rows are padded for that, they overwrite the
+ * start of the next row, which may belong to another band with threads.
+ */
+static int dst_padded_for_threads(SwsContext *c, const int dstStride[])
+{
+    int linesizes[4], i;
+
+    if (av_image_fill_linesizes(linesizes, c->dstFormat, FFALIGN(c->dstW, 32)) < 0)
+        return 0;
+    for (i = 0; i < 4; i++)
+        if (FFABS(dstStride[i]) < linesizes[i])
+            return 0;
+    return 1;
+}
+
+static int scale_threaded(SwsContext *c, const uint8_t * const src[],
+                          const int srcStride[], uint8_t * const dst[],
+                          const int dstStride[])
+{
+    int i;
+
+    c->slice_src        = src;
+    c->slice_src_stride = srcStride;
+    c->slice_dst        = dst;
+    c->slice_dst_stride = dstStride;
+
+    avpriv_slicethread_execute(c->slicethread, c->nb_slice_ctx, 0);
+
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        if (c->slice_err[i] < 0)
+            return c->slice_err[i];
+    return c->dstH;
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -837,6 +923,10 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         return 0;
     }
 
+    if (c->slicethread && srcSliceY == 0 && srcSliceH == c->srcH &&
+        dst_padded_for_threads(c, dstStride))
+        return scale_threaded(c, srcSlice, srcStride, dst, dstStride);
+
     if (c->sliceDir == 0 && srcSliceY != 0 && srcSliceY + srcSliceH != c->srcH) {
         av_log(c, AV_LOG_ERROR, "Slices start in the middle!\n");
         return 0;
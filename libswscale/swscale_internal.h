@@ -31,6 +31,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/ppc/util_altivec.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
@@ -321,6 +322,22 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields are used for threaded scaling of whole frames:
+     * each thread scales a horizontal band of the destination with its own
+     * context, the main one is used for slice-wise input.
+     */
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    AVSliceThread *slicethread;
+    struct SwsContext **slice_ctx;
+    int *slice_err;
+    int nb_slice_ctx;
+    const uint8_t * const *slice_src;
+    const int *slice_src_stride;
+    uint8_t * const *slice_dst;
+    const int *slice_dst_stride;
+    int dstSliceY;                ///< First destination line scaled by a slice context.
+    int dstSliceH;                ///< Number of destination lines scaled by a slice context, 0 outside of threaded scaling.
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -849,6 +866,9 @@ void ff_get_unscaled_swscale_aarch64(SwsContext *c);
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
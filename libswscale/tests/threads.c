@@ -0,0 +1,175 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Scale frames with and without threads and check that the output is the
+ * same. The destination rows are either packed tightly or have the least
+ * padding threads are used with. The output functions write past the end
+ * of the rows, into the next one without padding, which belongs to another
+ * thread at band boundaries.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+#define NB_RUNS 20
+
+static const struct {
+    int src_w, src_h, dst_w, dst_h;
+    enum AVPixelFormat src_fmt, dst_fmt;
+    int flags;
+} tests[] = {
+    { 352, 288, 250, 146, AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, SWS_BICUBIC  },
+    { 352, 288, 498, 362, AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, SWS_BILINEAR },
+    { 320, 240, 202, 150, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV420P, SWS_LANCZOS  },
+    { 320, 240, 161, 121, AV_PIX_FMT_RGB24,   AV_PIX_FMT_YUV420P, SWS_BICUBIC  },
+    { 320, 240, 254, 190, AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGRA,    SWS_BICUBIC  },
+};
+
+static struct SwsContext *alloc_context(int i, int threads)
+{
+    struct SwsContext *c = sws_alloc_context();
+
+    if (!c)
+        return NULL;
+    av_opt_set_int(c, "srcw",       tests[i].src_w,   0);
+    av_opt_set_int(c, "srch",       tests[i].src_h,   0);
+    av_opt_set_int(c, "src_format", tests[i].src_fmt, 0);
+    av_opt_set_int(c, "dstw",       tests[i].dst_w,   0);
+    av_opt_set_int(c, "dsth",       tests[i].dst_h,   0);
+    av_opt_set_int(c, "dst_format", tests[i].dst_fmt, 0);
+    av_opt_set_int(c, "sws_flags",  tests[i].flags,   0);
+    av_opt_set_int(c, "threads",    threads,          0);
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+    return c;
+}
+
+static int alloc_dst(uint8_t *data[4], int linesize[4], int w, int h,
+                     enum AVPixelFormat pix_fmt, int padded)
+{
+    int size, ret;
+
+    ret = av_image_fill_linesizes(linesize, pix_fmt, padded ? FFALIGN(w, 32) : w);
+    if (ret < 0)
+        return ret;
+    size = av_image_fill_pointers(data, pix_fmt, h, NULL, linesize);
+    if (size < 0)
+        return size;
+    if (!(data[0] = av_malloc(size)))
+        return AVERROR(ENOMEM);
+    av_image_fill_pointers(data, pix_fmt, h, data[0], linesize);
+    return size;
+}
+
+/* compare the pixels, without the padding */
+static int compare_dst(uint8_t *ref[4], uint8_t *dst[4], const int linesize[4],
+                       int w, int h, enum AVPixelFormat pix_fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    int width[4], p, y;
+
+    av_image_fill_linesizes(width, pix_fmt, w);
+    for (p = 0; p < 4 && width[p]; p++) {
+        int plane_h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(h, desc->log2_chroma_h) : h;
+
+        for (y = 0; y < plane_h; y++)
+            if (memcmp(ref[p] + y * linesize[p], dst[p] + y * linesize[p], width[p]))
+                return 1;
+    }
+    return 0;
+}
+
+static int run_test(int i, int padded, AVLFG *lfg)
+{
+    struct SwsContext *c_ref = alloc_context(i, 1);
+    struct SwsContext *c_thr = alloc_context(i, 4);
+    uint8_t *src[4], *ref[4], *dst[4];
+    int src_stride[4], dst_stride[4];
+    int src_size, dst_size, run, j, ret = -1;
+
+    src[0] = ref[0] = dst[0] = NULL;
+    if (!c_ref || !c_thr)
+        goto end;
+
+    src_size = av_image_alloc(src, src_stride, tests[i].src_w, tests[i].src_h,
+                              tests[i].src_fmt, 16);
+    dst_size = alloc_dst(ref, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                         tests[i].dst_fmt, padded);
+    if (src_size < 0 || dst_size < 0 ||
+        alloc_dst(dst, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                  tests[i].dst_fmt, padded) < 0)
+        goto end;
+
+    for (run = 0; run < NB_RUNS; run++) {
+        for (j = 0; j < src_size; j++)
+            src[0][j] = av_lfg_get(lfg);
+        memset(ref[0], 0, dst_size);
+        memset(dst[0], 0, dst_size);
+
+        if (sws_scale(c_ref, (const uint8_t * const *)src, src_stride, 0,
+                      tests[i].src_h, ref, dst_stride) != tests[i].dst_h ||
+            sws_scale(c_thr, (const uint8_t * const *)src, src_stride, 0,
+                      tests[i].src_h, dst, dst_stride) != tests[i].dst_h)
+            goto end;
+
+        if (compare_dst(ref, dst, dst_stride, tests[i].dst_w, tests[i].dst_h,
+                        tests[i].dst_fmt))
+            break;
+    }
+
+    printf("%dx%d %s -> %dx%d %s, %s rows: %s\n",
+           tests[i].src_w, tests[i].src_h, av_get_pix_fmt_name(tests[i].src_fmt),
+           tests[i].dst_w, tests[i].dst_h, av_get_pix_fmt_name(tests[i].dst_fmt),
+           padded ? "padded" : "packed", run < NB_RUNS ? "threaded output differs" : "OK");
+    ret = run < NB_RUNS ? -1 : 0;
+
+end:
+    av_freep(&src[0]);
+    av_freep(&ref[0]);
+    av_freep(&dst[0]);
+    sws_freeContext(c_ref);
+    sws_freeContext(c_thr);
+    return ret;
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    int i, padded, ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++)
+        for (padded = 0; padded <= 1; padded++)
+            if (run_test(i, padded, &lfg) < 0)
+                ret = 1;
+
+    return ret;
+}
@@ -854,6 +854,11 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
+
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange, table,
+                                 dstRange, brightness, contrast, saturation);
 
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -1154,8 +1159,8 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
-av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
-                             SwsFilter *dstFilter)
+static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
+                                           SwsFilter *dstFilter)
 {
     int i;
     int usesVFilter, usesHFilter;
@@ -1840,6 +1845,81 @@ fail: // FIXME replace things by appropriate error codes
     return -1;
 }
 
+static av_cold int context_init_threaded(SwsContext *c, const SwsContext *opts,
+                                         SwsFilter *srcFilter, SwsFilter *dstFilter)
+{
+    int i, ret;
+
+    /* these work on the whole picture or carry state from line to line */
+    if (c->cascaded_context[0] || c->srcXYZ || c->dstXYZ || c->src0Alpha ||
+        c->dither == SWS_DITHER_ED) {
+        av_log(c, AV_LOG_VERBOSE, "Scaling will be single-threaded.\n");
+        return 0;
+    }
+
+    ret = avpriv_slicethread_create(&c->slicethread, c, ff_sws_slice_worker,
+                                    NULL, c->nb_threads);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    if (ret == 1) {
+        avpriv_slicethread_free(&c->slicethread);
+        return 0;
+    }
+
+    c->slice_ctx = av_mallocz_array(ret, sizeof(*c->slice_ctx));
+    c->slice_err = av_mallocz_array(ret, sizeof(*c->slice_err));
+    if (!c->slice_ctx || !c->slice_err)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < ret; i++) {
+        SwsContext *s = sws_alloc_context();
+        int err;
+
+        if (!s)
+            return AVERROR(ENOMEM);
+        c->slice_ctx[c->nb_slice_ctx++] = s;
+
+        if ((err = av_opt_copy(s, opts)) < 0)
+            return err;
+        s->nb_threads = 1;
+
+        if ((err = sws_init_single_context(s, srcFilter, dstFilter)) < 0)
+            return err;
+        sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+    }
+
+    return 0;
+}
+
+av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
+                             SwsFilter *dstFilter)
+{
+    SwsContext *opts = NULL;
+    int ret;
+
+    /* the slice contexts are initialized from the options set by the user,
+     * before the main context adjusts them */
+    if (c->nb_threads != 1) {
+        opts = sws_alloc_context();
+        if (!opts)
+            return AVERROR(ENOMEM);
+        if ((ret = av_opt_copy(opts, c)) < 0)
+            goto end;
+    }
+
+    ret = sws_init_single_context(c, srcFilter, dstFilter);
+    if (ret >= 0 && opts)
+        ret = context_init_threaded(c, opts, srcFilter, dstFilter);
+
+end:
+    sws_freeContext(opts);
+    return ret;
+}
+
 SwsContext *sws_alloc_set_opts(int srcW, int srcH, enum AVPixelFormat srcFormat,
                                int dstW, int dstH, enum AVPixelFormat dstFormat,
                                int flags, const double *param)
@@ -2291,6 +2371,12 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    av_freep(&c->slice_err);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
@@ -2357,6 +2443,7 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context, int srcW,
                                              SWS_PARAM_DEFAULT };
     int64_t src_h_chr_pos = -513, dst_h_chr_pos = -513,
             src_v_chr_pos = -513, dst_v_chr_pos = -513;
+    int64_t nb_threads = 1;
 
     if (!param)
         param = default_param;
@@ -2376,6 +2463,7 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context, int srcW,
         av_opt_get_int(context, "src_v_chr_pos", 0, &src_v_chr_pos);
         av_opt_get_int(context, "dst_h_chr_pos", 0, &dst_h_chr_pos);
         av_opt_get_int(context, "dst_v_chr_pos", 0, &dst_v_chr_pos);
+        av_opt_get_int(context, "threads",       0, &nb_threads);
         sws_freeContext(context);
         context = NULL;
     }
@@ -2397,6 +2485,7 @@ struct SwsContext *sws_getCachedContext(struct SwsContext *context, int srcW,
         av_opt_set_int(context, "src_v_chr_pos", src_v_chr_pos, 0);
         av_opt_set_int(context, "dst_h_chr_pos", dst_h_chr_pos, 0);
         av_opt_set_int(context, "dst_v_chr_pos", dst_v_chr_pos, 0);
+        av_opt_set_int(context, "threads",       nb_threads,    0);
 
         if (sws_init_context(context, srcFilter, dstFilter) < 0) {
             sws_freeContext(context);
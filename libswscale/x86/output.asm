@@ -22,20 +22,20 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
-
+SECTION_RODATA 32
+
+yuv2yuvX_10_start:  times 8 dd 0x10000
+yuv2yuvX_9_start:   times 8 dd 0x20000
+yuv2yuvX_10_upper:  times 16 dw 0x3ff
+yuv2yuvX_9_upper:   times 16 dw 0x1ff
+pd_4:          times 8 dd 4
+pw_16:         times 16 dw 16
+pw_32:         times 16 dw 32
+pw_512:        times 16 dw 512
+pw_1024:       times 16 dw 1024
 minshort:      times 8 dw 0x8000
 yuv2yuvX_16_start:  times 4 dd 0x4000 - 0x40000000
-yuv2yuvX_10_start:  times 4 dd 0x10000
-yuv2yuvX_9_start:   times 4 dd 0x20000
-yuv2yuvX_10_upper:  times 8 dw 0x3ff
-yuv2yuvX_9_upper:   times 8 dw 0x1ff
-pd_4:          times 4 dd 4
 pd_4min0x40000:times 4 dd 4 - (0x40000)
-pw_16:         times 8 dw 16
-pw_32:         times 8 dw 32
-pw_512:        times 8 dw 512
-pw_1024:       times 8 dw 1024
 
 SECTION .text
 
@@ -61,7 +61,7 @@ SECTION .text
     ; 8 pixels but we can only handle 2 pixels per register, and thus 4
     ; pixels per iteration. In order to not have to keep track of where
     ; we are w.r.t. dithering, we unroll the MMX/8-bit loop x2.
-%if %1 == 8
+%if %1 == 8 && mmsize == 8
 %assign %%repcnt 16/mmsize
 %else
 %assign %%repcnt 1
@@ -89,18 +89,22 @@ SECTION .text
     mova            m3, [r6+r5*4]
     mova            m5, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m3, [r6+r5*2]
+    movsrc          m3, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
     mov             r6, [srcq+gprsize*cntr_reg-gprsize]
 %if %1 == 16
     mova            m4, [r6+r5*4]
     mova            m6, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m4, [r6+r5*2]
+    movsrc          m4, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
 
     ; coefficients
+%if mmsize == 32
+    vpbroadcastd    m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
+%else ; mmsize == 8/16
     movd            m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
+%endif ; mmsize == 8/16/32
 %if %1 == 16
     pshuflw         m7,  m0,  0          ; coeff[0]
     pshuflw         m0,  m0,  0x55       ; coeff[1]
@@ -119,7 +123,9 @@ SECTION .text
 %else ; %1 == 10/9/8
     punpcklwd       m5,  m3,  m4
     punpckhwd       m3,  m4
+%if mmsize != 32
     SPLATD          m0
+%endif ; mmsize != 32
 
     pmaddwd         m5,  m0
     pmaddwd         m3,  m0
@@ -142,7 +148,12 @@ SECTION .text
 %if %1 == 8
     packssdw        m2,  m1
     packuswb        m2,  m2
+%if mmsize == 32
+    vpermq          m2,  m2,  q3120
+    movu   [dstq+r5*1], xm2
+%else ; mmsize == 8/16
     movh   [dstq+r5*1],  m2
+%endif ; mmsize == 8/16/32
 %else ; %1 == 9/10/16
 %if %1 == 16
     packssdw        m2,  m1
@@ -153,7 +164,7 @@ SECTION .text
 %else ; mmxext/sse2
     packssdw        m2,  m1
     pmaxsw          m2,  m6
-%endif ; mmxext/sse2/sse4/avx
+%endif ; mmxext/sse2/sse4/avx/avx2
     pminsw          m2, [yuv2yuvX_%1_upper]
 %endif ; %1 == 9/10/16
     mov%2   [dstq+r5*2],  m2
@@ -176,6 +187,12 @@ SECTION .text
 %define cntr_reg r7
 %define movsx movsxd
 %endif
+; the intermediate chroma lines are only guaranteed 16-byte alignment
+%if mmsize == 32
+%define movsrc movu
+%else
+%define movsrc mova
+%endif
 
 cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 %if %1 == 8 || %1 == 9 || %1 == 10
@@ -192,6 +209,21 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 %endif ; x86-32
 
     ; create registers holding dither
+%if mmsize == 32
+    movq           xm9, [ditherq]        ; dither
+    test        offsetd, offsetd
+    jz              .no_rot
+    punpcklqdq     xm9,  xm9
+    PALIGNR        xm9,  xm9,  3, xm0
+.no_rot:
+    ; the dither pattern repeats every 8 pixels, so both lanes get the same
+    vpbroadcastq    m9,  xm9
+    punpcklbw       m9,  m6
+    punpcklwd       m8,  m9,  m6
+    pslld           m8,  12
+    punpckhwd       m9,  m6
+    pslld           m9,  12
+%else ; mmsize == 8/16
     movq        m_dith, [ditherq]        ; dither
     test        offsetd, offsetd
     jz              .no_rot
@@ -231,12 +263,15 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
     mova      [rsp+16],  m3
     mova      [rsp+24],  m_dith
 %endif ; mmsize == 8/16
+%endif ; mmsize == 8/16/32
 %endif ; %1 == 8
 
     xor             r5,  r5
 
 %if mmsize == 8 || %1 == 8
     yuv2planeX_mainloop %1, a
+%elif mmsize == 32
+    yuv2planeX_mainloop %1, u
 %else ; mmsize == 16
     test          dstq, 15
     jnz .unaligned
@@ -283,9 +318,40 @@ yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
 %endif
 
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2planeX_fn  8, 10, 7
+yuv2planeX_fn  9,  7, 5
+yuv2planeX_fn 10,  7, 5
+%endif
+
 ; %1=outout-bpc, %2=alignment (u/a)
 %macro yuv2plane1_mainloop 2
 .loop_%2:
+%if mmsize == 32 ; 16 pixels per iteration, packs are in-lane
+%if %1 == 8
+    paddsw          m0, m2, [srcq+wq*2]
+    psraw           m0, 7
+    packuswb        m0, m0
+    vpermq          m0, m0, q3120
+    mov%2    [dstq+wq], xm0
+%elif %1 == 16
+    paddd           m0, m4, [srcq+wq*4+mmsize*0]
+    paddd           m1, m4, [srcq+wq*4+mmsize*1]
+    psrad           m0, 3
+    psrad           m1, 3
+    packusdw        m0, m1
+    vpermq          m0, m0, q3120
+    mov%2    [dstq+wq*2], m0
+%else ; %1 == 9/10
+    paddsw          m0, m2, [srcq+wq*2]
+    psraw           m0, 15 - %1
+    pmaxsw          m0, m4
+    pminsw          m0, m3
+    mov%2    [dstq+wq*2], m0
+%endif ; %1 == 8/9/10/16
+    add             wq, 16
+%else ; mmsize == 8/16
 %if %1 == 8
     paddsw          m0, m2, [srcq+wq*2+mmsize*0]
     paddsw          m1, m3, [srcq+wq*2+mmsize*1]
@@ -326,14 +392,20 @@ yuv2planeX_fn 10,  7, 5
     mov%2    [dstq+wq*2+mmsize*1], m1
 %endif
     add             wq, mmsize
+%endif ; mmsize == 8/16/32
     jl .loop_%2
 %endmacro
 
 %macro yuv2plane1_fn 3
 cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     movsxdifnidn    wq, wd
+%if mmsize == 32
+    add             wq, 15
+    and             wq, ~15
+%else ; mmsize == 8/16
     add             wq, mmsize - 1
     and             wq, ~(mmsize - 1)
+%endif ; mmsize == 8/16/32
 %if %1 == 8
     add           dstq, wq
 %else ; %1 != 8
@@ -350,15 +422,19 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     pxor            m4, m4               ; zero
 
     ; create registers holding dither
-    movq            m3, [ditherq]        ; dither
+    movq           xm3, [ditherq]        ; dither
     test       offsetd, offsetd
     jz              .no_rot
-%if mmsize == 16
-    punpcklqdq      m3, m3
-%endif ; mmsize == 16
-    PALIGNR         m3, m3, 3, m2
+%if mmsize >= 16
+    punpcklqdq     xm3, xm3
+%endif ; mmsize >= 16
+    PALIGNR        xm3, xm3, 3, xm2
 .no_rot:
-%if mmsize == 8
+%if mmsize == 32
+    vpbroadcastq    m3, xm3
+    punpcklbw       m3, m4
+    mova            m2, m3
+%elif mmsize == 8
     mova            m2, m3
     punpckhbw       m3, m4               ; byte->word
     punpcklbw       m2, m4               ; byte->word
@@ -386,6 +462,8 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     ; actual pixel scaling
 %if mmsize == 8
     yuv2plane1_mainloop %1, a
+%elif mmsize == 32
+    yuv2plane1_mainloop %1, u
 %else ; mmsize == 16
     test          dstq, 15
     jnz .unaligned
@@ -423,3 +501,11 @@ yuv2plane1_fn  9, 5, 3
 yuv2plane1_fn 10, 5, 3
 yuv2plane1_fn 16, 5, 3
 %endif
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2plane1_fn  8, 5, 5
+yuv2plane1_fn  9, 5, 3
+yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 16, 5, 3
+%endif
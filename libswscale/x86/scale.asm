@@ -21,7 +21,11 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
+
+hscale_avx2_perm4:   dd 0, 1, 4, 5, 2, 3, 6, 7
+hscale_avx2_perm8:   dd 0, 4, 1, 5, 2, 6, 3, 7
+hscale_avx2_gather8: dd 0, 2, 1, 3, 4, 6, 5, 7
 
 max_19bit_int: times 4 dd 0x7ffff
 max_19bit_flt: times 4 dd 524287.0
@@ -421,3 +425,294 @@ INIT_XMM ssse3
 SCALE_FUNCS2 6, 6, 8
 INIT_XMM sse4
 SCALE_FUNCS2 6, 6, 8
+
+;-----------------------------------------------------------------------------
+; AVX2 versions of the 4- and 8-tap scalers. These produce 8 output pixels per
+; iteration, so dstW has to be a multiple of 8. Source pixels are fetched with
+; gathers (or 128-bit loads for 8-tap 9-16 bit input) and laid out so that the
+; unmodified filter array can be used for the multiplication, the resulting
+; in-lane order of the sums is fixed up with a single vpermd at the end.
+;-----------------------------------------------------------------------------
+
+; SCALE_FUNC_AVX2 source_width, intermediate_nbits, filtersize
+%macro SCALE_FUNC_AVX2 3
+cglobal hscale%1to%2_%3, 6, 8, 11, c, dst, w, src, filter, fltpos, pos0, pos1
+%if %1 == 8
+    pxor          m3, m3
+%elif %1 == 16
+    vpbroadcastd  m6, [minshort]
+    vpbroadcastd  m7, [unicoeff]
+%endif ; %1 == 8/16
+%if %2 == 19
+    vpbroadcastd  m2, [max_19bit_int]
+%endif ; %2 == 19
+    mova          m8, [hscale_avx2_perm%3]
+%if %1 == 8 && %3 == 8
+    mova          m9, [hscale_avx2_gather8]
+%endif ; %1 == 8 && %3 == 8
+
+.loop:
+%if %3 == 4
+    ; load 8x4 source pixels into m4 (dstpix {0,1 | 2,3}) and m5 ({4,5 | 6,7})
+%if %1 == 8
+    vpermd        m0, m8, [fltposq]             ; filterPos[{0,1,4,5,2,3,6,7}]
+    pcmpeqd       m1, m1
+    vpgatherdd    m4, [srcq+m0], m1             ; src[filterPos[..] + {0,1,2,3}]
+    punpckhbw     m5, m4, m3                    ; byte -> word
+    punpcklbw     m4, m3                        ; byte -> word
+%else ; %1 == 9-16
+    movu         xm0, [fltposq]                 ; filterPos[{0,1,2,3}]
+    movu         xm1, [fltposq+16]              ; filterPos[{4,5,6,7}]
+    pcmpeqd       m5, m5
+    vpgatherdq    m4, [srcq+xm0*2], m5          ; src[filterPos[{0,1,2,3}] + {0,1,2,3}]
+    pcmpeqd       m0, m0
+    vpgatherdq    m5, [srcq+xm1*2], m0          ; src[filterPos[{4,5,6,7}] + {0,1,2,3}]
+%endif ; %1 == 8/9-16
+
+    ; multiply
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m4, m6
+    psubw         m5, m6
+%endif ; %1 == 16
+    pmaddwd       m4, [filterq+mmsize*0]        ; *= filter[{ 0, 1,..., 14,15}]
+    pmaddwd       m5, [filterq+mmsize*1]        ; *= filter[{16,17,..., 30,31}]
+
+    ; add up horizontally, dstpix {0,1,4,5 | 2,3,6,7}
+    phaddd        m4, m5
+%else ; %3 == 8
+    ; load 8x8 source pixels into m4 (dstpix {0 | 1}), m5 ({2 | 3}),
+    ; m0 ({4 | 5}) and m1 ({6 | 7})
+%if %1 == 8
+    vpermd        m0, m9, [fltposq]             ; filterPos[{0,2,1,3,4,6,5,7}]
+    pcmpeqd       m1, m1
+    vpgatherdq    m4, [srcq+xm0], m1            ; src[filterPos[{0,2,1,3}] + {0,1,..,6,7}]
+    vextracti128 xm0, m0, 1
+    pcmpeqd       m1, m1
+    vpgatherdq   m10, [srcq+xm0], m1            ; src[filterPos[{4,6,5,7}] + {0,1,..,6,7}]
+    punpckhbw     m5, m4, m3                    ; byte -> word
+    punpcklbw     m4, m3
+    punpckhbw     m1, m10, m3
+    punpcklbw     m0, m10, m3
+%else ; %1 == 9-16
+    movsxd     pos0q, dword [fltposq+ 0]        ; filterPos[0]
+    movsxd     pos1q, dword [fltposq+ 4]        ; filterPos[1]
+    movu         xm4, [srcq+pos0q*2]            ; src[filterPos[0] + {0,1,..,6,7}]
+    vinserti128   m4, m4, [srcq+pos1q*2], 1     ; src[filterPos[1] + {0,1,..,6,7}]
+    movsxd     pos0q, dword [fltposq+ 8]        ; filterPos[2]
+    movsxd     pos1q, dword [fltposq+12]        ; filterPos[3]
+    movu         xm5, [srcq+pos0q*2]
+    vinserti128   m5, m5, [srcq+pos1q*2], 1
+    movsxd     pos0q, dword [fltposq+16]        ; filterPos[4]
+    movsxd     pos1q, dword [fltposq+20]        ; filterPos[5]
+    movu         xm0, [srcq+pos0q*2]
+    vinserti128   m0, m0, [srcq+pos1q*2], 1
+    movsxd     pos0q, dword [fltposq+24]        ; filterPos[6]
+    movsxd     pos1q, dword [fltposq+28]        ; filterPos[7]
+    movu         xm1, [srcq+pos0q*2]
+    vinserti128   m1, m1, [srcq+pos1q*2], 1
+%endif ; %1 == 8/9-16
+
+    ; multiply
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m4, m6
+    psubw         m5, m6
+    psubw         m0, m6
+    psubw         m1, m6
+%endif ; %1 == 16
+    pmaddwd       m4, [filterq+mmsize*0]        ; *= filter[{ 0, 1,..., 14,15}]
+    pmaddwd       m5, [filterq+mmsize*1]        ; *= filter[{16,17,..., 30,31}]
+    pmaddwd       m0, [filterq+mmsize*2]        ; *= filter[{32,33,..., 46,47}]
+    pmaddwd       m1, [filterq+mmsize*3]        ; *= filter[{48,49,..., 62,63}]
+
+    ; add up horizontally, dstpix {0,2,4,6 | 1,3,5,7}
+    phaddd        m4, m5
+    phaddd        m0, m1
+    phaddd        m4, m0
+%endif ; %3 == 4/8
+
+%if %1 == 16 ; add 0x8000 * sum(coeffs), i.e. back from signed -> unsigned
+    paddd         m4, m7
+%endif ; %1 == 16
+
+    ; reorder, clip, store
+    vpermd        m4, m8, m4
+    psrad         m4, 14 + %1 - %2
+%if %2 == 15
+    vextracti128 xm5, m4, 1
+    packssdw     xm4, xm5
+    movu      [dstq], xm4
+    add         dstq, 16
+%else ; %2 == 19
+    pminsd        m4, m2
+    movu      [dstq], m4
+    add         dstq, 32
+%endif ; %2 == 15/19
+    add      filterq, 16*%3
+    add      fltposq, 32
+    sub           wd, 8
+    jg .loop
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------
+; AVX2 versions of the any-filterSize scalers. These produce 4 output pixels
+; per iteration, one per 128-bit lane half of the two accumulators, so dstW
+; has to be a multiple of 4. Like the SSE versions, the inner loop does 8 taps
+; at a time and the X4 version handles the last 4 taps of filterSize % 8 == 4
+; after the loop. Gathers are not used here: with 8 or more taps per pixel,
+; plain 128-bit (or 64-bit for 8-bit input) loads are cheaper.
+;-----------------------------------------------------------------------------
+
+; SCALE_FUNC_AVX2_X source_width, intermediate_nbits, filtersuffix
+%macro SCALE_FUNC_AVX2_X 3
+cglobal hscale%1to%2_%3, 7, 13, 7, pos0, dst, w, srcmem, filter, fltpos, fltsize, \
+                                  pos1, pos2, pos3, src, srcend, fs3
+%ifidn %3, X4
+%define dlt 4
+%else ; %3 == X8
+%define dlt 0
+%endif ; %3 == X4/X8
+%if %1 == 8
+%define srcmul 1
+%else ; %1 == 9-16
+%define srcmul 2
+%endif ; %1 == 8/9-16
+%if %1 == 16
+    vpbroadcastd  m6, [minshort]
+%endif ; %1 == 16
+    movsxd        wq, wd
+    movsxd  fltsizeq, fltsized                  ; filterSize
+    lea         fs3q, [fltsizeq*3]
+    lea      srcendq, [srcmemq+(fltsizeq-dlt)*srcmul] ; &src[filterSize&~4]
+    lea      fltposq, [fltposq+wq*4]
+%if %2 == 15
+    lea         dstq, [dstq+wq*2]
+%else ; %2 == 19
+    lea         dstq, [dstq+wq*4]
+%endif ; %2 == 15/19
+    neg           wq
+
+.loop:
+    movsxd     pos0q, dword [fltposq+wq*4+ 0]   ; filterPos[0]
+    movsxd     pos1q, dword [fltposq+wq*4+ 4]   ; filterPos[1]
+    movsxd     pos2q, dword [fltposq+wq*4+ 8]   ; filterPos[2]
+    movsxd     pos3q, dword [fltposq+wq*4+12]   ; filterPos[3]
+    pxor          m4, m4
+    pxor          m5, m5
+    mov         srcq, srcmemq
+
+.innerloop:
+    ; load 4x8 source pixels into m0 (dstpix {0 | 1}) and m1 ({2 | 3})
+%if %1 == 8
+    movq         xm0, [srcq+pos0q]              ; src[filterPos[0] + {0,1,..,6,7}]
+    movhps       xm0, [srcq+pos1q]              ; src[filterPos[1] + {0,1,..,6,7}]
+    movq         xm1, [srcq+pos2q]
+    movhps       xm1, [srcq+pos3q]
+    pmovzxbw      m0, xm0                       ; byte -> word
+    pmovzxbw      m1, xm1
+%else ; %1 == 9-16
+    movu         xm0, [srcq+pos0q*2]            ; src[filterPos[0] + {0,1,..,6,7}]
+    vinserti128   m0, m0, [srcq+pos1q*2], 1     ; src[filterPos[1] + {0,1,..,6,7}]
+    movu         xm1, [srcq+pos2q*2]
+    vinserti128   m1, m1, [srcq+pos3q*2], 1
+%endif ; %1 == 8/9-16
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m0, m6
+    psubw         m1, m6
+%endif ; %1 == 16
+
+    ; multiply
+    movu         xm2, [filterq]                 ; filter[{0,1,..,6,7}]
+    vinserti128   m2, m2, [filterq+fltsizeq*2], 1 ; filter[filterSize+{0,1,..,6,7}]
+    movu         xm3, [filterq+fltsizeq*4]
+    vinserti128   m3, m3, [filterq+fs3q*2], 1
+    pmaddwd       m0, m2
+    pmaddwd       m1, m3
+    paddd         m4, m0
+    paddd         m5, m1
+    add      filterq, 16
+    add         srcq, 8*srcmul
+    cmp         srcq, srcendq                   ; while (src += 8) < &src[filterSize&~4]
+    jl .innerloop
+
+    ; add up horizontally, dstpix {0,2,0,2 | 1,3,1,3} -> {0,1,2,3}
+    phaddd        m4, m5
+    phaddd        m4, m4
+    vextracti128 xm0, m4, 1
+    punpckldq    xm0, xm4, xm0
+
+%ifidn %3, X4
+    ; last 4 source pixels of each output pixel
+%if %1 == 8
+    movd         xm1, [srcq+pos0q]              ; src[filterPos[0] + {0,1,2,3}]
+    pinsrd       xm1, [srcq+pos1q], 1
+    pinsrd       xm1, [srcq+pos2q], 2
+    pinsrd       xm1, [srcq+pos3q], 3
+    pmovzxbw      m1, xm1
+%else ; %1 == 9-16
+    movq         xm1, [srcq+pos0q*2]            ; src[filterPos[0] + {0,1,2,3}]
+    movhps       xm1, [srcq+pos1q*2]
+    movq         xm2, [srcq+pos2q*2]
+    movhps       xm2, [srcq+pos3q*2]
+    vinserti128   m1, m1, xm2, 1
+%endif ; %1 == 8/9-16
+%if %1 == 16
+    psubw         m1, m6
+%endif ; %1 == 16
+    movq         xm2, [filterq]
+    movhps       xm2, [filterq+fltsizeq*2]
+    movq         xm3, [filterq+fltsizeq*4]
+    movhps       xm3, [filterq+fs3q*2]
+    vinserti128   m2, m2, xm3, 1
+    pmaddwd       m1, m2
+    phaddd        m1, m1                        ; dstpix {0,1,0,1 | 2,3,2,3}
+    vextracti128 xm2, m1, 1
+    punpcklqdq   xm1, xm2
+    paddd        xm0, xm1
+%endif ; %3 == X4
+
+    ; on to the filter of the next 4 output pixels
+    lea      filterq, [filterq+fs3q*2+dlt*2]
+
+%if %1 == 16 ; add 0x8000 * sum(coeffs), i.e. back from signed -> unsigned
+    paddd        xm0, [unicoeff]
+%endif ; %1 == 16
+
+    ; clip, store
+    psrad        xm0, 14 + %1 - %2
+%if %2 == 15
+    packssdw     xm0, xm0
+    movq [dstq+wq*2], xm0
+%else ; %2 == 19
+    pminsd       xm0, [max_19bit_int]
+    movu [dstq+wq*4], xm0
+%endif ; %2 == 15/19
+    add           wq, 4
+    jl .loop
+    RET
+%endmacro
+
+; SCALE_FUNCS_AVX2 source_width
+%macro SCALE_FUNCS_AVX2 1
+SCALE_FUNC_AVX2   %1, 15, 4
+SCALE_FUNC_AVX2   %1, 15, 8
+SCALE_FUNC_AVX2_X %1, 15, X4
+SCALE_FUNC_AVX2_X %1, 15, X8
+SCALE_FUNC_AVX2   %1, 19, 4
+SCALE_FUNC_AVX2   %1, 19, 8
+SCALE_FUNC_AVX2_X %1, 19, X4
+SCALE_FUNC_AVX2_X %1, 19, X8
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SCALE_FUNCS_AVX2  8
+SCALE_FUNCS_AVX2  9
+SCALE_FUNCS_AVX2 10
+SCALE_FUNCS_AVX2 12
+SCALE_FUNCS_AVX2 14
+SCALE_FUNCS_AVX2 16
+%endif
@@ -315,6 +315,12 @@ SCALE_FUNCS_MMX(mmx);
 SCALE_FUNCS_SSE(sse2);
 SCALE_FUNCS_SSE(ssse3);
 SCALE_FUNCS_SSE(sse4);
+#if ARCH_X86_64
+SCALE_FUNCS(4, avx2);
+SCALE_FUNCS(8, avx2);
+SCALE_FUNCS(X4, avx2);
+SCALE_FUNCS(X8, avx2);
+#endif
 
 #define VSCALEX_FUNC(size, opt) \
 void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
@@ -332,6 +338,9 @@ VSCALEX_FUNCS(sse2);
 VSCALEX_FUNCS(sse4);
 VSCALEX_FUNC(16, sse4);
 VSCALEX_FUNCS(avx);
+#if ARCH_X86_64
+VSCALEX_FUNCS(avx2);
+#endif
 
 #define VSCALE_FUNC(size, opt) \
 void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int dstW, \
@@ -348,6 +357,7 @@ VSCALE_FUNCS(mmx, mmxext);
 VSCALE_FUNCS(sse2, sse2);
 VSCALE_FUNC(16, sse4);
 VSCALE_FUNCS(avx, avx);
+VSCALE_FUNCS(avx2, avx2);
 
 #define INPUT_Y_FUNC(fmt, opt) \
 void ff_ ## fmt ## ToY_  ## opt(uint8_t *dst, const uint8_t *src, \
@@ -581,4 +591,30 @@ switch(c->dstBpc){ \
             break;
         }
     }
+
+/* The 4- and 8-tap versions do 8 output pixels per iteration, the generic
+ * ones 4. Other widths keep the SSE versions, which do 2. There are no
+ * AVX-512 versions: the generic loop is bound by the 4 scattered source
+ * loads per 8 taps rather than by the multiplies, so wider vectors only
+ * help the 4/8-tap gathers, and the clock penalty of zmm code on most
+ * AVX-512 CPUs eats that up during a full sws_scale() call. */
+#define ASSIGN_AVX2_SCALE_FUNC(hscalefn, filtersize, dstw) \
+    switch (filtersize) { \
+    case 4: if (!((dstw) & 7)) ASSIGN_SCALE_FUNC2(hscalefn, 4, avx2, avx2); break; \
+    case 8: if (!((dstw) & 7)) ASSIGN_SCALE_FUNC2(hscalefn, 8, avx2, avx2); break; \
+    default: \
+        if ((dstw) & 3) \
+            break; \
+        if (filtersize & 4) ASSIGN_SCALE_FUNC2(hscalefn, X4, avx2, avx2); \
+        else                ASSIGN_SCALE_FUNC2(hscalefn, X8, avx2, avx2); \
+        break; \
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+#if ARCH_X86_64
+        ASSIGN_AVX2_SCALE_FUNC(c->hyScale, c->hLumFilterSize, c->dstW);
+        ASSIGN_AVX2_SCALE_FUNC(c->hcScale, c->hChrFilterSize, c->chrDstW);
+        ASSIGN_VSCALEX_FUNC(c->yuv2planeX, avx2, , 1);
+#endif
+        ASSIGN_VSCALE_FUNC(c->yuv2plane1, avx2, avx2, 1);
+    }
 }
@@ -0,0 +1,123 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+
+#include "checkasm.h"
+#include "libavfilter/dnn_native_dsp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define MAX_SRC 576
+#define MAX_DST 64
+
+#define randomize_buffer(buf, size)                         \
+    do {                                                    \
+        int j;                                              \
+        for (j = 0; j < size; j++)                          \
+            buf[j] = (int)(rnd() % 2001 - 1000) / 1000.0f;  \
+    } while (0)
+
+/* src_len/dst_len pairs of the layers of the default SRCNN/ESPCN models,
+ * for both whole kernel rows and single edge taps */
+static const int conv_sizes[][2] = {
+    { 9, 64 }, { 1, 64 }, { 5, 64 }, { 64, 32 }, { 192, 32 }, { 576, 32 }, { 3, 40 },
+};
+
+static const int dot_sizes[] = { 5, 17, 32, 96, 160, 576 };
+
+static void check_conv_accumulate(const DNNNativeDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src,  [MAX_SRC]);
+    LOCAL_ALIGNED_32(float, dst0, [MAX_DST]);
+    LOCAL_ALIGNED_32(float, dst1, [MAX_DST]);
+    float *kernel = av_malloc_array(MAX_SRC * MAX_DST, sizeof(*kernel));
+    int i, n;
+
+    declare_func(void, float *dst, const float *src, const float *kernel,
+                 int src_len, int dst_len);
+
+    if (!kernel)
+        return;
+
+    randomize_buffer(src, MAX_SRC);
+    randomize_buffer(kernel, MAX_SRC * MAX_DST);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(conv_sizes); i++) {
+        int src_len = conv_sizes[i][0], dst_len = conv_sizes[i][1];
+
+        if (check_func(dsp->conv_accumulate, "conv_accumulate_%dx%d", src_len, dst_len)) {
+            randomize_buffer(dst0, MAX_DST);
+            memcpy(dst1, dst0, MAX_DST * sizeof(*dst0));
+
+            call_ref(dst0, src, kernel, src_len, dst_len);
+            call_new(dst1, src, kernel, src_len, dst_len);
+            for (n = 0; n < MAX_DST; n++) {
+                if (!float_near_abs_eps(dst0[n], dst1[n], src_len * 16 * FLT_EPSILON)) {
+                    fprintf(stderr, "%d: %- .12f - %- .12f = % .12g\n",
+                            n, dst0[n], dst1[n], dst0[n] - dst1[n]);
+                    fail();
+                    break;
+                }
+            }
+            bench_new(dst1, src, kernel, src_len, dst_len);
+        }
+    }
+
+    av_free(kernel);
+    report("conv_accumulate");
+}
+
+static void check_dot_product(const DNNNativeDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, a, [MAX_SRC]);
+    LOCAL_ALIGNED_32(float, b, [MAX_SRC]);
+    int i;
+
+    declare_func_float(float, const float *a, const float *b, int len);
+
+    randomize_buffer(a, MAX_SRC);
+    randomize_buffer(b, MAX_SRC);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(dot_sizes); i++) {
+        int len = dot_sizes[i];
+
+        if (check_func(dsp->dot_product, "dot_product_%d", len)) {
+            float res0 = call_ref(a, b, len);
+            float res1 = call_new(a, b, len);
+            if (!float_near_abs_eps(res0, res1, len * 16 * FLT_EPSILON)) {
+                fprintf(stderr, "%- .12f - %- .12f = % .12g\n",
+                        res0, res1, res0 - res1);
+                fail();
+            }
+            bench_new(a, b, len);
+        }
+    }
+
+    report("dot_product");
+}
+
+void checkasm_check_dnn_native_dsp(void)
+{
+    DNNNativeDSPContext dsp;
+
+    ff_dnn_native_dsp_init(&dsp);
+
+    check_conv_accumulate(&dsp);
+    check_dot_product(&dsp);
+}
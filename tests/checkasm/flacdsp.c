@@ -21,6 +21,7 @@
 #include <string.h>
 #include "checkasm.h"
 #include "libavcodec/flacdsp.h"
+#include "libavcodec/mathops.h"
 #include "libavutil/common.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
@@ -53,6 +54,37 @@ static void check_decorrelate(uint8_t **ref_dst, uint8_t **ref_src, uint8_t **ne
     bench_new(new_dst, (int32_t **)new_src, channels, BUF_SIZE / sizeof(int32_t), 8);
 }
 
+static void check_lpc_encode(FLACDSPContext *h)
+{
+    /* the SIMD versions read and write whole blocks past len */
+    LOCAL_ALIGNED_32(int32_t, smp,     [BUF_SIZE + 32]);
+    LOCAL_ALIGNED_32(int32_t, ref_res, [BUF_SIZE + 32]);
+    LOCAL_ALIGNED_32(int32_t, new_res, [BUF_SIZE + 32]);
+    int32_t coefs[32];
+    int i, order;
+
+    declare_func(void, int32_t *res, const int32_t *smp, int len, int order,
+                 const int32_t coefs[32], int shift);
+
+    for (i = 0; i < BUF_SIZE + 32; i++)
+        smp[i] = sign_extend(rnd(), 12);
+    for (i = 0; i < 32; i++)
+        coefs[i] = sign_extend(rnd(), 10);
+
+    if (check_func(h->lpc16_encode, "flac_enc_lpc_16")) {
+        for (order = 1; order <= 32; order++) {
+            int len = BUF_SIZE - (rnd() & 31);
+            memset(ref_res, 0, (BUF_SIZE + 32) * sizeof(*ref_res));
+            memset(new_res, 0, (BUF_SIZE + 32) * sizeof(*new_res));
+            call_ref(ref_res, smp, len, order, coefs, 9);
+            call_new(new_res, smp, len, order, coefs, 9);
+            if (memcmp(ref_res, new_res, len * sizeof(*ref_res)))
+                fail();
+        }
+        bench_new(new_res, smp, BUF_SIZE, 32, coefs, 9);
+    }
+}
+
 void checkasm_check_flacdsp(void)
 {
     LOCAL_ALIGNED_16(uint8_t, ref_dst, [BUF_SIZE*MAX_CHANNELS]);
@@ -87,4 +119,8 @@ void checkasm_check_flacdsp(void)
     }
 
     report("decorrelate");
+
+    ff_flacdsp_init(&h, AV_SAMPLE_FMT_S16, 2, 16);
+    check_lpc_encode(&h);
+    report("lpc_encode");
 }
@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#include "libswresample/resample.h"
+
+#include "checkasm.h"
+
+#define DST_SIZE 256
+#define SRC_SIZE 1024
+
+#define randomize_buffers(buf, size)                        \
+    do {                                                    \
+        int k;                                              \
+        for (k = 0; k < size; k += 4)                       \
+            AV_WN32A(buf + k, rnd());                       \
+    } while (0)
+
+static const struct {
+    int in_rate, out_rate, filter_size, exact_rational;
+} configs[] = {
+    { 48000, 44100, 16, 1 },
+    { 48000, 44100, 32, 0 },
+    { 48000, 44100, 64, 1 },
+    { 44100, 48000, 32, 0 },
+    {  8000, 48000, 16, 1 },
+};
+
+static void check_resample(int (*func)(ResampleContext *c, void *dst, const void *src,
+                                       int n, int update_ctx),
+                           ResampleContext *c, const char *name, int bps, int cfg, int comp)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,  [SRC_SIZE * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_SIZE * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_SIZE * 4]);
+    ResampleContext c0, c1;
+    int ret0, ret1;
+
+    declare_func(int, ResampleContext *c, void *dst, const void *src,
+                 int n, int update_ctx);
+
+    if (check_func(func, "resample_%s_%s_%d_%d_%d%s", name, bps == 2 ? "int16" : "int32",
+                   configs[cfg].in_rate, configs[cfg].out_rate, configs[cfg].filter_size,
+                   comp ? "_comp" : "")) {
+        randomize_buffers(src, SRC_SIZE * bps);
+        memset(dst0, 0, DST_SIZE * bps);
+        memset(dst1, 0, DST_SIZE * bps);
+
+        /* start in the middle of a phase; with compensation start on the
+         * last one, whose next phase is the wrapped copy of the first */
+        c->index = comp ? c->phase_count - 1 : rnd() % c->phase_count;
+        c->frac  = rnd() % c->src_incr;
+        c0 = c1 = *c;
+
+        ret0 = call_ref(&c0, dst0, src, DST_SIZE, 1);
+        ret1 = call_new(&c1, dst1, src, DST_SIZE, 1);
+        if (ret0 != ret1 || c0.index != c1.index || c0.frac != c1.frac ||
+            memcmp(dst0, dst1, DST_SIZE * bps))
+            fail();
+        bench_new(&c1, dst1, src, DST_SIZE, 0);
+    }
+}
+
+static void check_resample_type(int linear)
+{
+    static const enum AVSampleFormat fmts[] = { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P };
+    int i, cfg, comp;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(fmts); i++) {
+        for (cfg = 0; cfg < FF_ARRAY_ELEMS(configs); cfg++) {
+            /* compensation rebuilds the filter bank with more phases, which
+             * only happens with exact_rational */
+            for (comp = 0; comp <= configs[cfg].exact_rational; comp++) {
+                ResampleContext *c = swri_resampler.init(NULL, configs[cfg].out_rate, configs[cfg].in_rate,
+                                                         configs[cfg].filter_size, 10, linear, 0, fmts[i],
+                                                         SWR_FILTER_TYPE_KAISER, 9, 0, 0,
+                                                         configs[cfg].exact_rational, 1, NULL);
+                if (c && (!comp || swri_resampler.set_compensation(c, 1, 100) >= 0))
+                    check_resample(linear ? c->dsp.resample_linear : c->dsp.resample_common,
+                                   c, linear ? "linear" : "common",
+                                   av_get_bytes_per_sample(fmts[i]), cfg, comp);
+                swri_resampler.free(&c);
+            }
+        }
+    }
+}
+
+void checkasm_check_sw_resample(void)
+{
+    check_resample_type(0);
+    report("resample_common");
+
+    check_resample_type(1);
+    report("resample_linear");
+}
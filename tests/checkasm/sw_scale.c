@@ -0,0 +1,222 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define SRC_PIXELS 512
+#define DST_PIXELS 256
+/* the SIMD versions are allowed to write up to a full iteration past dstW */
+#define DST_PAD    64
+#define MAX_FILTER 24
+#define MAX_LINES  16
+
+static const int filter_sizes[] = { 4, 8, 12, 16 };
+/* 4 and 8 have dedicated versions, the others hit both variants of the
+ * generic ones (filterSize % 8 == 4 and == 0), with up to 3 inner loops */
+static const int hscale_filter_sizes[] = { 4, 8, 12, 16, 20, 24 };
+
+static SwsContext *get_context(enum AVPixelFormat src_fmt,
+                               enum AVPixelFormat dst_fmt)
+{
+    /* no SWS_ACCURATE_RND would select the inline MMX vertical scaler */
+    return sws_getContext(SRC_PIXELS, 2, src_fmt, DST_PIXELS, 4, dst_fmt,
+                          SWS_BILINEAR | SWS_ACCURATE_RND | SWS_BITEXACT,
+                          NULL, NULL, NULL);
+}
+
+static void check_hscale(void)
+{
+    static const struct {
+        enum AVPixelFormat src, dst;
+    } pairs[] = {
+        { AV_PIX_FMT_GRAY8,    AV_PIX_FMT_GRAY8    },
+        { AV_PIX_FMT_GRAY8,    AV_PIX_FMT_GRAY16LE },
+        { AV_PIX_FMT_GRAY10LE, AV_PIX_FMT_GRAY8    },
+        { AV_PIX_FMT_GRAY10LE, AV_PIX_FMT_GRAY16LE },
+        { AV_PIX_FMT_GRAY16LE, AV_PIX_FMT_GRAY8    },
+        { AV_PIX_FMT_GRAY16LE, AV_PIX_FMT_GRAY16LE },
+    };
+    LOCAL_ALIGNED_32(uint16_t, src,       [SRC_PIXELS + MAX_FILTER]);
+    LOCAL_ALIGNED_32(int32_t,  dst0,      [DST_PIXELS + DST_PAD]);
+    LOCAL_ALIGNED_32(int32_t,  dst1,      [DST_PIXELS + DST_PAD]);
+    LOCAL_ALIGNED_32(int16_t,  filter,    [(DST_PIXELS + DST_PAD) * MAX_FILTER]);
+    LOCAL_ALIGNED_32(int32_t,  filterPos, [DST_PIXELS + DST_PAD]);
+    int p, f, i, j;
+
+    declare_func(void, SwsContext *c, int16_t *dst, int dstW,
+                 const uint8_t *src, const int16_t *filter,
+                 const int32_t *filterPos, int filterSize);
+
+    for (p = 0; p < FF_ARRAY_ELEMS(pairs); p++) {
+        SwsContext *c = get_context(pairs[p].src, pairs[p].dst);
+        int src_bits, dst_bits;
+
+        if (!c) {
+            fail();
+            continue;
+        }
+        src_bits = c->srcBpc;
+        dst_bits = c->dstBpc <= 14 ? 15 : 19;
+
+        for (i = 0; i < SRC_PIXELS + MAX_FILTER; i++)
+            src[i] = rnd() & ((1 << src_bits) - 1);
+        if (src_bits == 8)
+            for (i = 0; i < SRC_PIXELS + MAX_FILTER; i++)
+                ((uint8_t *)src)[i] = rnd();
+
+        for (f = 0; f < FF_ARRAY_ELEMS(hscale_filter_sizes); f++) {
+            int size = hscale_filter_sizes[f];
+
+            /* the coefficients have to add up to 1 << 14 like the ones
+             * generated by initFilter(), the 16-bit versions rely on it */
+            for (i = 0; i < DST_PIXELS; i++) {
+                int sum = 0;
+                filterPos[i] = rnd() % (SRC_PIXELS - size);
+                for (j = 0; j < size - 1; j++) {
+                    filter[i * size + j] = rnd() % ((1 << 14) / size);
+                    sum += filter[i * size + j];
+                }
+                filter[i * size + size - 1] = (1 << 14) - sum;
+            }
+
+            c->hLumFilterSize = size;
+            ff_getSwsFunc(c);
+
+            if (check_func(c->hyScale, "hscale_%d_to_%d_%d",
+                           src_bits, dst_bits, size)) {
+                memset(dst0, 0, (DST_PIXELS + DST_PAD) * sizeof(*dst0));
+                memset(dst1, 0, (DST_PIXELS + DST_PAD) * sizeof(*dst1));
+                call_ref(c, (int16_t *)dst0, DST_PIXELS, (const uint8_t *)src,
+                         filter, filterPos, size);
+                call_new(c, (int16_t *)dst1, DST_PIXELS, (const uint8_t *)src,
+                         filter, filterPos, size);
+                if (memcmp(dst0, dst1, DST_PIXELS * (dst_bits == 15 ? 2 : 4)))
+                    fail();
+                bench_new(c, (int16_t *)dst1, DST_PIXELS, (const uint8_t *)src,
+                          filter, filterPos, size);
+            }
+        }
+        sws_freeContext(c);
+    }
+    report("hscale");
+}
+
+static void check_yuv2plane(void)
+{
+    static const enum AVPixelFormat formats[] = {
+        AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY9LE, AV_PIX_FMT_GRAY10LE, AV_PIX_FMT_GRAY16LE,
+    };
+    static const uint8_t dither[8] = { 0, 48, 12, 60, 3, 51, 15, 63 };
+    LOCAL_ALIGNED_32(int32_t,  src_pixels, [MAX_LINES * (DST_PIXELS + DST_PAD)]);
+    LOCAL_ALIGNED_32(uint16_t, dst0,       [DST_PIXELS + DST_PAD]);
+    LOCAL_ALIGNED_32(uint16_t, dst1,       [DST_PIXELS + DST_PAD]);
+    LOCAL_ALIGNED_16(int16_t,  filter,     [MAX_LINES]);
+    const int16_t *src[MAX_LINES];
+    int fmt, f, i, j;
+
+    for (fmt = 0; fmt < FF_ARRAY_ELEMS(formats); fmt++) {
+        SwsContext *c = get_context(AV_PIX_FMT_GRAY8, formats[fmt]);
+        int dst_bits, dst_bytes;
+
+        if (!c) {
+            fail();
+            continue;
+        }
+        dst_bits  = c->dstBpc;
+        dst_bytes = dst_bits > 8 ? 2 : 1;
+
+        /* 15-bit intermediates, or 19-bit ones for 16-bit output */
+        for (i = 0; i < MAX_LINES; i++) {
+            int32_t *line = src_pixels + i * (DST_PIXELS + DST_PAD);
+            src[i] = (const int16_t *)line;
+            for (j = 0; j < DST_PIXELS + DST_PAD; j++) {
+                if (dst_bits == 16)
+                    line[j] = rnd() & 0x7ffff;
+                else
+                    ((int16_t *)line)[j] = rnd() & 0x7fff;
+            }
+        }
+
+        ff_getSwsFunc(c);
+
+        {
+            declare_func(void, const int16_t *src, uint8_t *dest, int dstW,
+                         const uint8_t *dither, int offset);
+
+            if (check_func(c->yuv2plane1, "yuv2plane1_%d", dst_bits)) {
+                for (i = 0; i <= 3; i += 3) {
+                    memset(dst0, 0, (DST_PIXELS + DST_PAD) * sizeof(*dst0));
+                    memset(dst1, 0, (DST_PIXELS + DST_PAD) * sizeof(*dst1));
+                    call_ref(src[0], (uint8_t *)dst0, DST_PIXELS - 3, dither, i);
+                    call_new(src[0], (uint8_t *)dst1, DST_PIXELS - 3, dither, i);
+                    if (memcmp(dst0, dst1, (DST_PIXELS - 3) * dst_bytes))
+                        fail();
+                }
+                bench_new(src[0], (uint8_t *)dst1, DST_PIXELS, dither, 0);
+            }
+        }
+
+        if (dst_bits != 16) {
+            declare_func(void, const int16_t *filter, int filterSize,
+                         const int16_t **src, uint8_t *dest, int dstW,
+                         const uint8_t *dither, int offset);
+
+            for (f = 0; f < FF_ARRAY_ELEMS(filter_sizes); f++) {
+                int size = filter_sizes[f];
+                int sum  = 0;
+
+                /* 12-bit coefficients adding up to 1 << 12 */
+                for (j = 0; j < size - 1; j++) {
+                    filter[j] = (int)(rnd() % (3 * (1 << 12) / size)) - (1 << 12) / size;
+                    sum += filter[j];
+                }
+                filter[size - 1] = (1 << 12) - sum;
+
+                if (check_func(c->yuv2planeX, "yuv2planeX_%d_%d", dst_bits, size)) {
+                    for (i = 0; i <= 3; i += 3) {
+                        memset(dst0, 0, (DST_PIXELS + DST_PAD) * sizeof(*dst0));
+                        memset(dst1, 0, (DST_PIXELS + DST_PAD) * sizeof(*dst1));
+                        call_ref(filter, size, src, (uint8_t *)dst0, DST_PIXELS - 5, dither, i);
+                        call_new(filter, size, src, (uint8_t *)dst1, DST_PIXELS - 5, dither, i);
+                        if (memcmp(dst0, dst1, (DST_PIXELS - 5) * dst_bytes))
+                            fail();
+                    }
+                    bench_new(filter, size, src, (uint8_t *)dst1, DST_PIXELS, dither, 0);
+                }
+            }
+        }
+        sws_freeContext(c);
+    }
+    report("yuv2plane");
+}
+
+void checkasm_check_sw_scale(void)
+{
+    check_hscale();
+    check_yuv2plane();
+}
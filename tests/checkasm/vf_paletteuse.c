@@ -0,0 +1,71 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/paletteuse.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+
+#define MAX_ENTRIES 256
+#define NB_COLORS   64
+
+static void check_nearest(int nb_entries, int mask)
+{
+    LOCAL_ALIGNED_32(int16_t, rg, [MAX_ENTRIES * 2]);
+    LOCAL_ALIGNED_32(int16_t, b,  [MAX_ENTRIES * 2]);
+    PaletteUseDSPContext dsp;
+    int i;
+
+    declare_func(int, const int16_t *rg, const int16_t *b, int nb_entries,
+                 int r, int g, int b_);
+
+    ff_paletteuse_dsp_init(&dsp);
+
+    for (i = 0; i < MAX_ENTRIES; i++) {
+        rg[2*i] = rg[2*i + 1] = b[2*i] = PALETTEUSE_PAD_VALUE;
+        b[2*i + 1] = 0;
+    }
+    /* a coarse mask gives equally close entries, the first one must win */
+    for (i = 0; i < nb_entries; i++) {
+        rg[2*i    ] = rnd() & mask;
+        rg[2*i + 1] = rnd() & mask;
+        b [2*i    ] = rnd() & mask;
+    }
+
+    if (check_func(dsp.nearest, "nearest_%d%s", nb_entries, mask != 0xff ? "_ties" : "")) {
+        const int padded = FFALIGN(nb_entries, 8);
+
+        for (i = 0; i < NB_COLORS; i++) {
+            const int r = rnd() & 0xff, g = rnd() & 0xff, b_ = rnd() & 0xff;
+
+            if (call_ref(rg, b, padded, r, g, b_) != call_new(rg, b, padded, r, g, b_))
+                fail();
+        }
+        bench_new(rg, b, padded, 0x80, 0x40, 0xc0);
+    }
+}
+
+void checkasm_check_vf_paletteuse(void)
+{
+    check_nearest(5, 0xff);
+    check_nearest(16, 0xff);
+    check_nearest(16, 0xc0);
+    check_nearest(256, 0xff);
+    check_nearest(256, 0xc0);
+    report("nearest");
+}
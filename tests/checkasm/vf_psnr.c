@@ -0,0 +1,70 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/psnr.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 1024
+
+#define randomize_buffers(buf, size, mask)                  \
+    do {                                                    \
+        int j;                                              \
+        for (j = 0; j < size; j += 2)                       \
+            AV_WN16A(buf + j, rnd() & mask);                \
+    } while (0)
+
+static void check_sse_line(int bpp)
+{
+    LOCAL_ALIGNED_32(uint8_t, buf, [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t, ref, [WIDTH * 2]);
+    const int mask = bpp > 8 ? (1 << bpp) - 1 : 0xffff;
+    PSNRDSPContext dsp;
+    int w;
+
+    declare_func(uint64_t, const uint8_t *buf, const uint8_t *ref, int w);
+
+    ff_psnr_init(&dsp, bpp);
+
+    if (check_func(dsp.sse_line, "sse_line_%d", bpp)) {
+        randomize_buffers(buf, WIDTH * 2, mask);
+        randomize_buffers(ref, WIDTH * 2, mask);
+
+        /* odd widths exercise the scalar tails */
+        for (w = 1; w <= WIDTH; w += w < 64 ? 1 : 61) {
+            if (call_ref(buf, ref, w) != call_new(buf, ref, w)) {
+                fprintf(stderr, "sse_line_%d: mismatch for width %d\n", bpp, w);
+                fail();
+                break;
+            }
+        }
+        bench_new(buf, ref, WIDTH);
+    }
+}
+
+void checkasm_check_vf_psnr(void)
+{
+    check_sse_line(8);
+    check_sse_line(10);
+    check_sse_line(15);
+    report("sse_line");
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/ssim.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH  512
+#define STRIDE (WIDTH + 32)
+/* number of 4x4 blocks in a line, and the length of the sums arrays */
+#define BLOCKS (WIDTH / 4)
+#define SUMS   (BLOCKS + 7)
+
+#define randomize_buffer(buf, size)                         \
+    do {                                                    \
+        int j;                                              \
+        for (j = 0; j < size; j++)                          \
+            buf[j] = rnd();                                 \
+    } while (0)
+
+static void check_ssim_4x4_line(const SSIMDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t, buf, [STRIDE * 4]);
+    LOCAL_ALIGNED_32(uint8_t, ref, [STRIDE * 4]);
+    LOCAL_ALIGNED_32(int, sums0, [SUMS * 4]);
+    LOCAL_ALIGNED_32(int, sums1, [SUMS * 4]);
+    int w;
+
+    declare_func(void, const uint8_t *buf, ptrdiff_t buf_stride,
+                 const uint8_t *ref, ptrdiff_t ref_stride,
+                 int (*sums)[4], int w);
+
+    if (check_func(dsp->ssim_4x4_line, "ssim_4x4_line")) {
+        randomize_buffer(buf, STRIDE * 4);
+        randomize_buffer(ref, STRIDE * 4);
+
+        for (w = BLOCKS - 3; w <= BLOCKS; w++) {
+            memset(sums0, 0, sizeof(int) * SUMS * 4);
+            memset(sums1, 0, sizeof(int) * SUMS * 4);
+            call_ref(buf, STRIDE, ref, STRIDE, (int (*)[4])sums0, w);
+            call_new(buf, STRIDE, ref, STRIDE, (int (*)[4])sums1, w);
+            if (memcmp(sums0, sums1, sizeof(int) * w * 4))
+                fail();
+        }
+        bench_new(buf, STRIDE, ref, STRIDE, (int (*)[4])sums1, BLOCKS);
+    }
+
+    report("ssim_4x4_line");
+}
+
+static void check_ssim_end_line(const SSIMDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(int, sum0, [SUMS * 4]);
+    LOCAL_ALIGNED_32(int, sum1, [SUMS * 4]);
+    int i, w;
+
+    declare_func_float(float, const int (*sum0)[4], const int (*sum1)[4], int w);
+
+    /* valid 4x4 sums of 8-bit pixels */
+    for (i = 0; i < SUMS; i++) {
+        int *s[2] = { &sum0[i * 4], &sum1[i * 4] };
+        int k;
+
+        for (k = 0; k < 2; k++) {
+            int s1 = rnd() % (16 * 255 + 1);
+            int s2 = rnd() % (16 * 255 + 1);
+
+            s[k][0] = s1;
+            s[k][1] = s2;
+            s[k][2] = (s1 * s1 + s2 * s2) / 16 + rnd() % 4096;
+            s[k][3] = s1 * s2 / 16 + rnd() % 2048;
+        }
+    }
+
+    if (check_func(dsp->ssim_end_line, "ssim_end_line")) {
+        for (w = BLOCKS - 8; w < BLOCKS; w++) {
+            float r0 = call_ref((const int (*)[4])sum0, (const int (*)[4])sum1, w);
+            float r1 = call_new((const int (*)[4])sum0, (const int (*)[4])sum1, w);
+
+            if (!float_near_abs_eps(r0, r1, 1e-5f * w)) {
+                fprintf(stderr, "ssim_end_line: %d: %f - %f\n", w, r0, r1);
+                fail();
+                break;
+            }
+        }
+        bench_new((const int (*)[4])sum0, (const int (*)[4])sum1, BLOCKS - 1);
+    }
+
+    report("ssim_end_line");
+}
+
+void checkasm_check_vf_ssim(void)
+{
+    SSIMDSPContext dsp;
+
+    ff_ssim_init(&dsp);
+
+    check_ssim_4x4_line(&dsp);
+    check_ssim_end_line(&dsp);
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/tonemap.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define WIDTH 256
+
+#define randomize_buffer(buf, size)                         \
+    do {                                                    \
+        int j;                                              \
+        for (j = 0; j < size; j++)                          \
+            buf[j] = (rnd() % 10001) / 1000.0f;             \
+    } while (0)
+
+/* reinhard, hable and mobius curves for a peak of 10, with and without
+ * desaturation */
+static const TonemapCurve curves[] = {
+    { { 0.2627, 0.0593, 0.6780 }, 2.0f, 0.0f,
+      { 0.0f, 1.05f, 0.0f }, { 0.0f, 1.0f, 0.5f }, 0.0f },
+    { { 0.2627, 0.0593, 0.6780 }, 0.0f, 0.0f,
+      { 0.15f * 1.3746f, 0.05f * 1.3746f, 0.004f * 1.3746f },
+      { 0.15f, 0.5f, 0.06f }, -0.02f / 0.3f * 1.3746f },
+    { { 0.2126, 0.0722, 0.7152 }, 0.5f, 0.3f,
+      { 0.0f, 1.1683f, -0.2924f }, { 0.0f, 1.0f, 0.8722f }, 0.0f },
+};
+
+static void check_tonemap_curve(const TonemapDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, src_buf,  [3 * WIDTH]);
+    LOCAL_ALIGNED_32(float, dst0_buf, [3 * WIDTH]);
+    LOCAL_ALIGNED_32(float, dst1_buf, [3 * WIDTH]);
+    float *src[3]  = { src_buf,  src_buf  + WIDTH, src_buf  + 2 * WIDTH };
+    float *dst0[3] = { dst0_buf, dst0_buf + WIDTH, dst0_buf + 2 * WIDTH };
+    float *dst1[3] = { dst1_buf, dst1_buf + WIDTH, dst1_buf + 2 * WIDTH };
+    int i, p, x;
+
+    declare_func(void, float *dst0, float *dst1, float *dst2,
+                 const float *src0, const float *src1, const float *src2,
+                 int width, const TonemapCurve *curve);
+
+    randomize_buffer(src_buf, 3 * WIDTH);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(curves); i++) {
+        if (check_func(dsp->tonemap_curve, "tonemap_curve_%d", i)) {
+            memset(dst0_buf, 0, 3 * WIDTH * sizeof(*dst0_buf));
+            memset(dst1_buf, 0, 3 * WIDTH * sizeof(*dst1_buf));
+
+            call_ref(dst0[0], dst0[1], dst0[2], src[0], src[1], src[2], WIDTH, &curves[i]);
+            call_new(dst1[0], dst1[1], dst1[2], src[0], src[1], src[2], WIDTH, &curves[i]);
+            for (p = 0; p < 3; p++) {
+                for (x = 0; x < WIDTH; x++) {
+                    if (!float_near_abs_eps_ulp(dst0[p][x], dst1[p][x], 1e-5f, 16)) {
+                        fprintf(stderr, "%d,%d: %- .12f - %- .12f = % .12g\n", p, x,
+                                dst0[p][x], dst1[p][x], dst0[p][x] - dst1[p][x]);
+                        fail();
+                        break;
+                    }
+                }
+            }
+            bench_new(dst1[0], dst1[1], dst1[2], src[0], src[1], src[2], WIDTH, &curves[i]);
+        }
+    }
+
+    report("tonemap_curve");
+}
+
+void checkasm_check_vf_tonemap(void)
+{
+    TonemapDSPContext dsp;
+
+    ff_tonemap_dsp_init(&dsp);
+
+    check_tonemap_curve(&dsp);
+}
@@ -33,6 +33,12 @@ errfile="${outdir}/${test}.err"
 cmpfile="${outdir}/${test}.diff"
 repfile="${outdir}/${test}.rep"
 
+# threaded variants of a test print the names of the test they share a ref with
+case $test in
+    *-slice-threads|*-frame-threads) ref_test=${test%-*-threads} ;;
+    *)                               ref_test=${test%-threads}   ;;
+esac
+
 target_path(){
     test ${1} = ${1#/} && p=${target_path}/
     echo ${p}${1}
@@ -201,11 +207,11 @@ enc_dec(){
     tdecfile=$(target_path $decfile)
     ffmpeg -f $src_fmt $DEC_OPTS -i $tsrcfile $ENC_OPTS $enc_opt $FLAGS \
         -f $enc_fmt -y $tencfile || return
-    do_md5sum $encfile
-    echo $(wc -c $encfile)
+    do_md5sum $encfile | sed "s#/$test\.#/$ref_test.#"
+    echo $(wc -c $encfile) | sed "s#/$test\.#/$ref_test.#"
     ffmpeg $8 $DEC_OPTS -i $tencfile $ENC_OPTS $dec_opt $FLAGS \
         -f $dec_fmt -y $tdecfile || return
-    do_md5sum $decfile
+    do_md5sum $decfile | sed "s#/$test\.#/$ref_test.#"
     tests/tiny_psnr $srcfile $decfile $cmp_unit $cmp_shift
 }
 
@@ -267,7 +273,7 @@ refcmp_metadata(){
 video_filter(){
     filters=$1
     shift
-    label=${test#filter-}
+    label=${ref_test#filter-}
     raw_src="${target_path}/tests/vsynth1/%02d.pgm"
     printf '%-20s' $label
     ffmpeg $DEC_OPTS -f image2 -vcodec pgmyuv -i $raw_src \
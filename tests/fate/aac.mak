@@ -212,6 +212,16 @@ fate-aac-ms-encode: CMP_TARGET = 558
 fate-aac-ms-encode: SIZE_TOLERANCE = 3560
 fate-aac-ms-encode: FUZZ = 15
 
+FATE_AAC_ENCODE += fate-aac-6ch-encode
+fate-aac-6ch-encode: ./tests/data/asynth-22050-6.wav
+fate-aac-6ch-encode: CMD = enc_dec_pcm adts wav s16le $(REF) -c:a aac -threads 4 -thread_type slice -fflags +bitexact -flags +bitexact
+fate-aac-6ch-encode: CMP = stddev
+fate-aac-6ch-encode: REF = ./tests/data/asynth-22050-6.wav
+fate-aac-6ch-encode: CMP_SHIFT = -12288
+fate-aac-6ch-encode: CMP_TARGET = 3409
+fate-aac-6ch-encode: SIZE_TOLERANCE = 9840
+fate-aac-6ch-encode: FUZZ = 50
+
 #Ticket1784
 FATE_AAC_ENCODE += fate-aac-yoraw-encode
 fate-aac-yoraw-encode: CMD = enc_dec_pcm adts wav s16le $(TARGET_SAMPLES)/audio-reference/yo.raw-short.wav -c:a aac -fflags +bitexact -flags +bitexact
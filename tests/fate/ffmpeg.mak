@@ -41,6 +41,22 @@ fate-ffmpeg-filter_colorkey: CMD = framecrc -idct simple -fflags +bitexact -flag
 FATE_FFMPEG-$(CONFIG_COLOR_FILTER) += fate-ffmpeg-lavfi
 fate-ffmpeg-lavfi: CMD = framecrc -lavfi color=d=1:r=5 -fflags +bitexact
 
+FATE_FFMPEG-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER HFLIP_FILTER VFLIP_FILTER NEGATE_FILTER TRANSPOSE_FILTER) += fate-ffmpeg-filter_scheduler
+fate-ffmpeg-filter_scheduler: CMD = framecrc -filter_scheduler parallel -filter_complex_threads 4 \
+  -filter_complex "testsrc2=d=1:r=10,split=4[a][b][c][d]\;[a]hflip[oa]\;[b]vflip[ob]\;[c]negate[oc]\;[d]transpose[od]" \
+  -map "[oa]" -map "[ob]" -map "[oc]" -map "[od]"
+
+FATE_FFMPEG-$(call ALLYES, TESTSRC2_FILTER SINE_FILTER SPLIT_FILTER SCALE_FILTER MPEG4_ENCODER FLAC_ENCODER) += fate-ffmpeg-parallel_encoders
+fate-ffmpeg-parallel_encoders: CMD = framecrc -parallel_encoders \
+  -filter_complex "testsrc2=d=1:r=10,split[a][b]\;[b]scale=160:120[ob]\;sine=d=1[oc]" \
+  -map "[a]" -map "[ob]" -map "[oc]" -c:v mpeg4 -bf 2 -c:a flac
+
+FATE_FFMPEG-$(call ALLYES, MPEGTS_DEMUXER MPEG2VIDEO_DECODER MPEG4_ENCODER SCALE_FILTER MP2_DECODER) += fate-ffmpeg-parallel_encoders-copy
+fate-ffmpeg-parallel_encoders-copy: fate-lavf-ts
+fate-ffmpeg-parallel_encoders-copy: CMD = framecrc -parallel_encoders \
+  -i $(TARGET_PATH)/tests/data/lavf/lavf.ts -map 0:v -map 0:v -map 0:a \
+  -c:v mpeg4 -s:v:1 176x144 -c:a copy
+
 FATE_SAMPLES_FFMPEG-$(CONFIG_RAWVIDEO_DEMUXER) += fate-force_key_frames
 fate-force_key_frames: tests/data/vsynth_lena.yuv
 fate-force_key_frames: CMD = enc_dec \
@@ -67,6 +83,14 @@ fate-unknown_layout-ac3: CMD = md5 \
   -guess_layout_max 0 -f s16le -ac 1 -ar 44100 -i $(TARGET_PATH)/$(AREF) \
   -f ac3 -flags +bitexact -c ac3_fixed
 
+FATE_FFMPEG-$(call ALLYES, WAV_DEMUXER WAV_MUXER PCM_S16LE_DECODER PCM_S16LE_ENCODER) += fate-ffmpeg-readahead
+fate-ffmpeg-readahead: tests/data/asynth-44100-2.wav
+fate-ffmpeg-readahead: CMD = md5 -readahead_size 4096 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -fflags +bitexact -f wav
+
+FATE_FFMPEG-$(call ALLYES, WAV_DEMUXER WAV_MUXER PCM_S16LE_DECODER PCM_S16LE_ENCODER) += fate-ffmpeg-writebehind
+fate-ffmpeg-writebehind: tests/data/asynth-44100-2.wav
+fate-ffmpeg-writebehind: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -writebehind_size 4096 -fflags +bitexact -f wav
+
 
 FATE_STREAMCOPY-$(call ALLYES, EAC3_DEMUXER MOV_MUXER) += fate-copy-trac3074
 fate-copy-trac3074: $(TARGET_SAMPLES)/eac3/csi_miami_stereo_128_spx.eac3
@@ -207,6 +207,23 @@ FATE_AFILTER-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FIL
 fate-filter-hls: tests/data/hls-list.m3u8
 fate-filter-hls: CMD = framecrc -flags +bitexact -i $(TARGET_PATH)/tests/data/hls-list.m3u8
 
+FATE_AFILTER-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-filter-hls-prefetch
+fate-filter-hls-prefetch: tests/data/hls-list.m3u8
+fate-filter-hls-prefetch: CMD = framecrc -flags +bitexact -prefetch_segments 2 -prefetch_buffer_size 4096 -i $(TARGET_PATH)/tests/data/hls-list.m3u8
+fate-filter-hls-prefetch: REF = $(SRC_PATH)/tests/ref/fate/filter-hls
+
+tests/data/hls-enc.m3u8: TAG = GEN
+tests/data/hls-enc.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< \
+        -f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=20" -f hls -hls_time 5 -hls_list_size 0 -map 0 -flags +bitexact \
+        -codec:a mp2fixed -hls_enc 1 -hls_enc_key 00112233445566778899aabbccddeeff \
+        -hls_enc_key_url $(TARGET_PATH)/tests/data/hls-enc.key -hls_segment_filename $(TARGET_PATH)/tests/data/hls-enc-%03d.ts \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_AFILTER-$(call ALLYES, HLS_DEMUXER HLS_MUXER MPEGTS_MUXER MPEGTS_DEMUXER CRYPTO_PROTOCOL AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-filter-hls-enc-prefetch
+fate-filter-hls-enc-prefetch: tests/data/hls-enc.m3u8
+fate-filter-hls-enc-prefetch: CMD = framecrc -flags +bitexact -allowed_extensions ALL -prefetch_segments 2 -i $(TARGET_PATH)/tests/data/hls-enc.m3u8
+
 tests/data/hls-list-append.m3u8: TAG = GEN
 tests/data/hls-list-append.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< \
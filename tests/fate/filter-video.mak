@@ -122,6 +122,21 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER FORMAT_FILTER) += fa
 fate-filter-framerate-12bit-up: CMD = framecrc -lavfi testsrc2=r=50:d=1,format=pix_fmts=yuv422p12le,framerate=fps=60 -t 1 -pix_fmt yuv422p12le
 fate-filter-framerate-12bit-down: CMD = framecrc -lavfi testsrc2=r=60:d=1,format=pix_fmts=yuv422p12le,framerate=fps=50 -t 1 -pix_fmt yuv422p12le
 
+FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-minterpolate fate-filter-minterpolate-threads
+fate-filter-minterpolate: CMD = framecrc -lavfi testsrc2=r=5:d=2,minterpolate=fps=12 -t 1
+fate-filter-minterpolate-threads: CMD = framecrc -filter_complex_threads 3 -lavfi testsrc2=r=5:d=2,minterpolate=fps=12 -t 1
+fate-filter-minterpolate-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-minterpolate
+
+FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-minterpolate-aobmc fate-filter-minterpolate-aobmc-threads
+fate-filter-minterpolate-aobmc: CMD = framecrc -lavfi testsrc2=r=5:d=2,minterpolate=fps=12:mc_mode=aobmc:vsbmc=1 -t 1
+fate-filter-minterpolate-aobmc-threads: CMD = framecrc -filter_complex_threads 3 -lavfi testsrc2=r=5:d=2,minterpolate=fps=12:mc_mode=aobmc:vsbmc=1 -t 1
+fate-filter-minterpolate-aobmc-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-minterpolate-aobmc
+
+FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-minterpolate-bidir fate-filter-minterpolate-bidir-threads
+fate-filter-minterpolate-bidir: CMD = framecrc -lavfi testsrc2=r=5:d=2,minterpolate=fps=12:me_mode=bidir:me=umh -t 1
+fate-filter-minterpolate-bidir-threads: CMD = framecrc -filter_complex_threads 3 -lavfi testsrc2=r=5:d=2,minterpolate=fps=12:me_mode=bidir:me=umh -t 1
+fate-filter-minterpolate-bidir-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-minterpolate-bidir
+
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
@@ -153,6 +168,10 @@ fate-filter-gradfun: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf gradfun
 FATE_FILTER_VSYNTH-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d
 fate-filter-hqdn3d: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf hqdn3d
 
+FATE_FILTER_VSYNTH-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d-threads
+fate-filter-hqdn3d-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf hqdn3d
+fate-filter-hqdn3d-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-hqdn3d
+
 FATE_FILTER_VSYNTH-$(CONFIG_INTERLACE_FILTER) += fate-filter-interlace
 fate-filter-interlace: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf interlace
 
@@ -395,6 +414,10 @@ FATE_FILTER_VSYNTH-$(CONFIG_TRIM_FILTER) += $(FATE_TRIM)
 FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp
 fate-filter-unsharp: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf unsharp=11:11:-1.5:11:11:-1.5
 
+FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp-threads
+fate-filter-unsharp-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 3 -vf unsharp=11:11:-1.5:11:11:-1.5
+fate-filter-unsharp-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-unsharp
+
 FATE_FILTER_SAMPLES-$(call ALLYES, SMJPEG_DEMUXER MJPEG_DECODER PERMS_FILTER HQDN3D_FILTER) += fate-filter-hqdn3d-sample
 fate-filter-hqdn3d-sample: tests/data/filtergraphs/hqdn3d
 fate-filter-hqdn3d-sample: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/smjpeg/scenwin.mjpg -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/hqdn3d -an
@@ -476,6 +499,10 @@ fate-filter-scale200: CMD = video_filter "scale=w=200:h=200"
 FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale500
 fate-filter-scale500: CMD = video_filter "scale=w=500:h=500"
 
+FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale500-threads
+fate-filter-scale500-threads: CMD = video_filter "scale=w=500:h=500:threads=4"
+fate-filter-scale500-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-scale500
+
 FATE_FILTER_VSYNTH-$(CONFIG_SCALE2REF_FILTER) += fate-filter-scale2ref_keep_aspect
 fate-filter-scale2ref_keep_aspect: tests/data/filtergraphs/scale2ref_keep_aspect
 fate-filter-scale2ref_keep_aspect: CMD = framemd5 -frames:v 5 -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/scale2ref_keep_aspect -map "[main]"
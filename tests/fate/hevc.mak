@@ -223,6 +223,24 @@ $(foreach N,$(HEVC_SAMPLES_422_10BIN),$(eval $(call FATE_HEVC_TEST_422_10BIN,$(N
 $(foreach N,$(HEVC_SAMPLES_444_8BIT),$(eval $(call FATE_HEVC_TEST_444_8BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT),$(eval $(call FATE_HEVC_TEST_444_12BIT,$(N))))
 
+# tiles and WPP decoded in frame threads, with the single threaded refs
+HEVC_SAMPLES_FRAME_THREADS =    \
+    TILES_A_Cisco_2             \
+    TILES_B_Cisco_1             \
+    WPP_A_ericsson_MAIN_2       \
+    WPP_D_ericsson_MAIN_2       \
+    WPP_F_ericsson_MAIN_2       \
+
+define FATE_HEVC_TEST_FRAME_THREADS
+FATE_HEVC += fate-hevc-conformance-$(1)-frame-threads
+fate-hevc-conformance-$(1)-frame-threads: CMD = framecrc -flags unaligned -vsync drop -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
+fate-hevc-conformance-$(1)-frame-threads: THREADS = 4
+fate-hevc-conformance-$(1)-frame-threads: THREAD_TYPE = frame+slice
+fate-hevc-conformance-$(1)-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+endef
+
+$(foreach N,$(HEVC_SAMPLES_FRAME_THREADS),$(eval $(call FATE_HEVC_TEST_FRAME_THREADS,$(N))))
+
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC += fate-hevc-paramchange-yuv420p-yuv420p10
 
@@ -59,6 +59,10 @@ FATE_LIBAVCODEC-yes += fate-libavcodec-options
 fate-libavcodec-options: libavcodec/tests/options$(EXESUF)
 fate-libavcodec-options: CMD = run libavcodec/tests/options
 
+FATE_LIBAVCODEC-yes += fate-libavcodec-shared-buffer-pool
+fate-libavcodec-shared-buffer-pool: libavcodec/tests/shared_buffer_pool$(EXESUF)
+fate-libavcodec-shared-buffer-pool: CMD = run libavcodec/tests/shared_buffer_pool
+
 FATE_LIBAVCODEC-$(CONFIG_RANGECODER) += fate-rangecoder
 fate-rangecoder: libavcodec/tests/rangecoder$(EXESUF)
 fate-rangecoder: CMD = run libavcodec/tests/rangecoder
@@ -22,6 +22,10 @@ FATE_LIBAVFORMAT-$(CONFIG_MOV_MUXER) += fate-movenc
 fate-movenc: libavformat/tests/movenc$(EXESUF)
 fate-movenc: CMD = run libavformat/tests/movenc
 
+FATE_LIBAVFORMAT-$(call ALLYES, MOV_MUXER MOV_DEMUXER) += fate-movfrag
+fate-movfrag: libavformat/tests/movfrag$(EXESUF)
+fate-movfrag: CMD = run libavformat/tests/movfrag
+
 FATE_LIBAVFORMAT += $(FATE_LIBAVFORMAT-yes)
 FATE-$(CONFIG_AVFORMAT) += $(FATE_LIBAVFORMAT)
 fate-libavformat: $(FATE_LIBAVFORMAT)
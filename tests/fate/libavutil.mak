@@ -35,6 +35,10 @@ FATE_LIBAVUTIL += fate-base64
 fate-base64: libavutil/tests/base64$(EXESUF)
 fate-base64: CMD = run libavutil/tests/base64
 
+FATE_LIBAVUTIL += fate-buffer
+fate-buffer: libavutil/tests/buffer$(EXESUF)
+fate-buffer: CMD = run libavutil/tests/buffer
+
 FATE_LIBAVUTIL += fate-blowfish
 fate-blowfish: libavutil/tests/blowfish$(EXESUF)
 fate-blowfish: CMD = run libavutil/tests/blowfish
@@ -35,7 +35,16 @@ FATE_SAMPLES_AVCONV += $(FATE_MOV)
 FATE_SAMPLES_FFPROBE += $(FATE_MOV_FFPROBE)
 FATE_SAMPLES_FASTSTART += $(FATE_MOV_FASTSTART)
 
-fate-mov: $(FATE_MOV) $(FATE_MOV_FFPROBE) $(FATE_MOV_FASTSTART)
+# Reserve space for the moov atom with the size estimated from the input
+# duration, the moov fits and is written in place. With a reserve that is too
+# small, it is turned into a free atom and faststart moves the mdat instead.
+FATE_MOV_FFMPEG-$(call ALLYES, RAWVIDEO_DEMUXER MPEG4_ENCODER MOV_MUXER MOV_DEMUXER MPEG4_DECODER) += \
+                   fate-mov-reserve-moov \
+                   fate-mov-reserve-moov-too-small \
+
+FATE_FFMPEG += $(FATE_MOV_FFMPEG-yes)
+
+fate-mov: $(FATE_MOV) $(FATE_MOV_FFPROBE) $(FATE_MOV_FASTSTART) $(FATE_MOV_FFMPEG-yes)
 
 # Make sure we handle edit lists correctly in normal cases.
 fate-mov-1elist-noctts: CMD = framemd5 -i $(TARGET_SAMPLES)/mov/mov-1elist-noctts.mov
@@ -121,3 +130,9 @@ fate-mov-guess-delay-3: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -show_entries stre
 fate-mov-faststart-4gb-overflow: CMD = run tools/qt-faststart$(EXESUF) $(TARGET_SAMPLES)/mov/faststart-4gb-overflow.mov faststart-4gb-overflow-output.mov > /dev/null ; md5sum faststart-4gb-overflow-output.mov | cut -d " " -f1 ; rm faststart-4gb-overflow-output.mov
 fate-mov-faststart-4gb-overflow: CMP = oneline
 fate-mov-faststart-4gb-overflow: REF = bc875921f151871e787c4b4023269b29
+
+$(FATE_MOV_FFMPEG-yes): tests/data/vsynth1.yuv
+fate-mov-reserve-moov: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv \
+                             mov "-c:v mpeg4 -frames:v 10 -movflags +faststart+reserve_moov"
+fate-mov-reserve-moov-too-small: CMD = transcode "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv \
+                                       mov "-c:v mpeg4 -frames:v 10 -movflags +faststart+reserve_moov -moov_size 200"
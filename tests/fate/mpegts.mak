@@ -20,6 +20,14 @@ fate-mpegts-probe-pmt-merge: SRC = $(TARGET_SAMPLES)/mpegts/pmtchange.ts
 fate-mpegts-probe-pmt-merge: CMD = run $(PROBE_CODEC_NAME_COMMAND) -merge_pmt_versions 1 -i "$(SRC)"
 
 
+FATE_MPEGTS_FFPROBE-$(call ENCDEC2, MPEG2VIDEO, MP2, MPEGTS) += fate-mpegts-probe-fast
+fate-mpegts-probe-fast: fate-lavf-ts
+fate-mpegts-probe-fast: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -fflags fastprobe \
+    -show_entries stream=codec_name,width,height,pix_fmt,sample_rate,channels,r_frame_rate,avg_frame_rate \
+    -print_format default -bitexact -v 0 -i $(TARGET_PATH)/tests/data/lavf/lavf.ts
+
+
 FATE_SAMPLES_FFPROBE += $(FATE_MPEGTS_PROBE-yes)
+FATE_FFPROBE += $(FATE_MPEGTS_FFPROBE-yes)
 
-fate-mpegts: $(FATE_MPEGTS_PROBE-yes)
+fate-mpegts: $(FATE_MPEGTS_PROBE-yes) $(FATE_MPEGTS_FFPROBE-yes)
@@ -0,0 +1,10 @@
+FATE_TEE_MUXER-$(call ALLYES, TEE_MUXER LAVFI_INDEV TESTSRC2_FILTER RAWVIDEO_ENCODER FRAMECRC_MUXER NULL_MUXER) += fate-tee-muxer-framecrc fate-tee-muxer-framecrc-threads
+fate-tee-muxer-framecrc: CMD = ffmpeg -f lavfi -i testsrc2=s=160x120:d=2 -map 0 -c:v rawvideo\
+                               -flags +bitexact -fflags +bitexact -f tee "[f=framecrc]pipe:1|[f=null]-"
+fate-tee-muxer-framecrc-threads: CMD = ffmpeg -f lavfi -i testsrc2=s=160x120:d=2 -map 0 -c:v rawvideo\
+                                       -flags +bitexact -fflags +bitexact -f tee\
+                                       "[f=framecrc:use_threads=1:queue_size=2]pipe:1|[f=null:use_threads=1:queue_size=2]-"
+fate-tee-muxer-framecrc-threads: REF = $(SRC_PATH)/tests/ref/fate/tee-muxer-framecrc
+
+FATE_FFMPEG += $(FATE_TEE_MUXER-yes)
+fate-tee-muxer: $(FATE_TEE_MUXER-yes)
@@ -229,6 +229,16 @@ fate-vsynth%-mjpeg-trell:             ENCOPTS = -qscale 9 -pix_fmt yuvj420p -tre
 fate-vsynth%-mjpeg-huffman:           ENCOPTS = -qscale 9 -pix_fmt yuvj420p -huffman optimal
 fate-vsynth%-mjpeg-trell-huffman:     ENCOPTS = -qscale 9 -pix_fmt yuvj420p -trellis 1 -huffman optimal
 
+FATE_VCODEC-$(call ENCDEC, MJPEG, AVI)  += mjpeg-slice-threads mjpeg-frame-threads
+fate-vsynth%-mjpeg-slice-threads:     ENCOPTS = -qscale 9 -pix_fmt yuvj420p
+fate-vsynth%-mjpeg-slice-threads:     THREADS = 4
+fate-vsynth%-mjpeg-slice-threads:     THREAD_TYPE = slice
+fate-vsynth%-mjpeg-slice-threads:     REF = $(SRC_PATH)/tests/ref/vsynth/$(@:fate-%-slice-threads=%)
+fate-vsynth%-mjpeg-frame-threads:     ENCOPTS = -qscale 9 -pix_fmt yuvj420p
+fate-vsynth%-mjpeg-frame-threads:     THREADS = 4
+fate-vsynth%-mjpeg-frame-threads:     THREAD_TYPE = frame
+fate-vsynth%-mjpeg-frame-threads:     REF = $(SRC_PATH)/tests/ref/vsynth/$(@:fate-%-frame-threads=%)
+
 FATE_VCODEC-$(call ENCDEC, MPEG1VIDEO, MPEG1VIDEO MPEGVIDEO) += mpeg1 mpeg1b
 fate-vsynth%-mpeg1:              FMT     = mpeg1video
 fate-vsynth%-mpeg1:              CODEC   = mpeg1video